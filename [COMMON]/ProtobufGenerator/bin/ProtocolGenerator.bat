@@ -1,10 +1,11 @@
 protoc --cpp_out=. Protocols.proto
 protoc --csharp_out=. Protocols.proto
-py enum_mapper_generator.py "./" "./PacketNumberMapper.h" "./PacketNumberMapper.cs"
+py enum_mapper_generator.py "./" "./PacketNumberMapper.h" "./PacketNumberMapper.cs" "./PacketDispatcher.h"
 
 COPY /Y *.pb.h "../../../[SERVER]\NetworkLibrary\NetworkLibrary"
 COPY /Y *.pb.cc "../../../[SERVER]\NetworkLibrary\NetworkLibrary"
 COPY /Y "PacketNumberMapper.h" "../../../[SERVER]\NetworkLibrary\NetworkLibrary"
+COPY /Y "PacketDispatcher.h" "../../../[SERVER]\NetworkLibrary\NetworkLibrary"
 
 COPY /Y *.cs "../../../[SERVER]/CSharp_NetworkClient/CSharp_NetworkClient"
 COPY /Y "PacketNumberMapper.cs" "../../../[SERVER]/CSharp_NetworkClient/CSharp_NetworkClient"
@@ -8,9 +8,10 @@ from pathlib import Path
 
 def parse_proto_files(proto_dir):
     """
-    proto 파일에서 packet_number enum 파싱
+    proto 파일에서 packet_number enum과 방향별(C2S_ / S2C_) 메시지 이름 파싱
     """
     packet_number_map = {}
+    message_names = set()
     
     print(f"Scanning directory: {os.path.abspath(proto_dir)}")
     proto_files = list(Path(proto_dir).rglob("*.proto"))
@@ -21,7 +22,7 @@ def parse_proto_files(proto_dir):
     
     if not proto_files:
         print("ERROR: No .proto files found!")
-        return packet_number_map
+        return packet_number_map, message_names
     
     for proto_file in proto_files:
         print(f"\nParsing: {proto_file}")
@@ -47,8 +48,12 @@ def parse_proto_files(proto_dir):
                         print(f"    {name} = {number}")
             else:
                 print("  ✗ No packet_number enum found in this file")
+
+            # 디스패치 표에 올릴 메시지 (C2S_TestEcho, S2C_TestEcho ...)
+            for direction, name in re.findall(r'message\s+(C2S|S2C)_(\w+)\s*\{', content):
+                message_names.add(f"{direction}_{name}")
     
-    return packet_number_map
+    return packet_number_map, message_names
 
 def generate_cpp_mapper(packet_number_map, output_path):
     """
@@ -118,6 +123,115 @@ public:
     
     print(f"\n✓ Generated C++: {os.path.abspath(output_path)}")
 
+def generate_cpp_dispatcher(packet_number_map, message_names, output_path):
+    """
+    C++ 패킷 디스패치 표 헤더 생성 (packet_number -> 방향별 메시지 타입, 세션 클래스별 핸들러 표)
+    """
+    content = """// Auto-generated by enum_mapper_generator.py
+// DO NOT EDIT THIS FILE MANUALLY
+
+#pragma once
+#include <array>
+#include <type_traits>
+#include <utility>
+
+// packet_number -> 받는 메시지 타입 (서버가 받는 C2S_, 클라이언트가 받는 S2C_). 메시지가 없으면 void
+template<int PacketNumber> struct C2SMessageOf { using type = void; };
+template<int PacketNumber> struct S2CMessageOf { using type = void; };
+"""
+
+    for direction in ("C2S", "S2C"):
+        for name, number in sorted(packet_number_map.items(), key=lambda x: x[1]):
+            message = f"{direction}_{name}"
+            if message in message_names:
+                content += f"template<> struct {direction}MessageOf<packet_number::{name}> {{ using type = {message}; }};\n"
+
+    content += """
+// 메시지 타입 -> packet_number (Session::do_send<MessageT>가 GetTypeName과 문자열 검색 없이 컴파일 시간에 정한다)
+// 기본 템플릿은 Packet.h에 있고, 여기 없는 메시지를 보내면 컴파일 오류가 난다
+"""
+    for direction in ("C2S", "S2C"):
+        for name, number in sorted(packet_number_map.items(), key=lambda x: x[1]):
+            message = f"{direction}_{name}"
+            if message in message_names:
+                content += f"template<> struct ProtocolOf<{message}> {{ static constexpr unsigned short value = packet_number::{name}; }};\n"
+
+    content += """
+// 세션 클래스마다 packet_number로 바로 찾는 핸들러 표를 컴파일 시간에 만든다
+// 표의 칸은 메시지를 디코딩해 세션 클래스의 on_packet(C2S_XXX&) (클라이언트 세션은 on_packet(S2C_XXX&))을 바로 부른다
+// on_packet이 없는 패킷의 칸은 nullptr이고, 그 패킷은 Session::m_handlers에서 찾는다
+// on_packet을 private으로 두려면 세션 클래스에 friend class PacketDispatcher; 를 선언한다
+class PacketDispatcher
+{
+public:
+    static constexpr int TABLE_SIZE = packet_number_ARRAYSIZE;
+    using Table = std::array<Session::PacketHandler, TABLE_SIZE>;
+
+    // 세션 생성자에서 부른다 (ClientSession 계열은 bind_c2s, ServerSession 계열은 bind_s2c)
+    template<typename SessionT>
+    static void bind_c2s(SessionT* session) { session->set_packet_handlers(get_c2s_table<SessionT>().data(), TABLE_SIZE); }
+    template<typename SessionT>
+    static void bind_s2c(SessionT* session) { session->set_packet_handlers(get_s2c_table<SessionT>().data(), TABLE_SIZE); }
+
+    template<typename SessionT>
+    static const Table& get_c2s_table()
+    {
+        static constexpr Table table = make_table<SessionT, C2SMessageOf>(std::make_index_sequence<TABLE_SIZE>());
+        return table;
+    }
+
+    template<typename SessionT>
+    static const Table& get_s2c_table()
+    {
+        static constexpr Table table = make_table<SessionT, S2CMessageOf>(std::make_index_sequence<TABLE_SIZE>());
+        return table;
+    }
+
+private:
+    // 섹션 스레드에서는 섹션의 MessageArena에 디코딩하므로 메시지는 묶음(tick)이 끝날 때까지만 살아 있다
+    template<typename SessionT, typename MessageT>
+    static void dispatch(Session* session, Packet* packet)
+    {
+        MessageArena* arena = MessageArena::get_current();
+        if (nullptr != arena)
+        {
+            MessageT* message = arena->create<MessageT>();
+            packet->pop_message(*message);
+            static_cast<SessionT*>(session)->on_packet(*message);
+            return;
+        }
+
+        MessageT message;
+        packet->pop_message(message);
+        static_cast<SessionT*>(session)->on_packet(message);
+    }
+
+    template<typename SessionT, typename MessageT>
+    static constexpr auto get_handler(int) -> decltype(std::declval<SessionT&>().on_packet(std::declval<MessageT&>()), Session::PacketHandler())
+    {
+        return &dispatch<SessionT, MessageT>;
+    }
+
+    template<typename SessionT, typename MessageT>
+    static constexpr Session::PacketHandler get_handler(...) { return nullptr; }
+
+    template<typename SessionT, template<int> class MessageOf, size_t... PacketNumbers>
+    static constexpr Table make_table(std::index_sequence<PacketNumbers...>)
+    {
+        return Table{ get_handler<SessionT, typename MessageOf<static_cast<int>(PacketNumbers)>::type>(0)... };
+    }
+};
+"""
+
+    output_dir = os.path.dirname(output_path)
+    if output_dir:
+        os.makedirs(output_dir, exist_ok=True)
+
+    with open(output_path, 'w', encoding='utf-8') as f:
+        f.write(content)
+
+    print(f"✓ Generated C++ dispatcher: {os.path.abspath(output_path)}")
+
 def generate_csharp_mapper(packet_number_map, output_path):
     """
     C# 매퍼 클래스 생성
@@ -205,13 +319,15 @@ public static class PacketNumberMapper
 
 def main():
     if len(sys.argv) < 4:
-        print("Usage: python enum_mapper_generator.py <proto_dir> <cpp_output> <csharp_output>")
-        print("Example: python enum_mapper_generator.py ./proto ./PacketNumberMapper.h ./PacketNumberMapper.cs")
+        print("Usage: python enum_mapper_generator.py <proto_dir> <cpp_output> <csharp_output> [cpp_dispatcher_output]")
+        print("Example: python enum_mapper_generator.py ./proto ./PacketNumberMapper.h ./PacketNumberMapper.cs ./PacketDispatcher.h")
         sys.exit(1)
     
     proto_dir = sys.argv[1]
     cpp_output = sys.argv[2]
     csharp_output = sys.argv[3]
+    # 지정하지 않으면 C++ 매퍼 옆에 만든다
+    cpp_dispatcher_output = sys.argv[4] if len(sys.argv) > 4 else os.path.join(os.path.dirname(cpp_output), "PacketDispatcher.h")
     
     print("="*60)
     print("Packet Number Mapper Generator")
@@ -221,7 +337,7 @@ def main():
         print(f"ERROR: Proto directory not found: {proto_dir}")
         sys.exit(1)
     
-    packet_number_map = parse_proto_files(proto_dir)
+    packet_number_map, message_names = parse_proto_files(proto_dir)
     
     if not packet_number_map:
         print("\nERROR: No packet_number enum found in any .proto file!")
@@ -237,6 +353,7 @@ def main():
     print(f"{'='*60}")
     
     generate_cpp_mapper(packet_number_map, cpp_output)
+    generate_cpp_dispatcher(packet_number_map, message_names, cpp_dispatcher_output)
     generate_csharp_mapper(packet_number_map, csharp_output)
     
     print("\n✓ Code generation completed successfully!")
@@ -0,0 +1,130 @@
+#include "pch.h"
+
+// 접속 폭주 벤치마크
+// 배포 직후 재접속처럼 client_threads개 스레드가 쉬지 않고 접속 -> 첫 패킷 받기 -> 끊기를 반복한다 (connections번)
+// 서버는 접속하자마자 패킷 하나를 보내므로, 접속 시작부터 첫 바이트를 받을 때까지의 시간(time-to-first-byte)과 초당 접속 수를 본다
+// backlog가 넘치면 커널이 SYN이나 마지막 ACK를 버려 재전송(1초~)을 기다리므로 p99가 튄다
+// 클라이언트는 접속되었다고 보고 첫 바이트를 기다리므로, first_byte_timeout_ms 안에 못 받으면 시간 초과로 센다
+// listeners=0이면 I/O 스레드 수만큼 SO_REUSEPORT 리슨 소켓을 연다. 예전 설정과 비교하려면 listeners=1 accepts=1 backlog=1
+// session_pool=0이면 끊긴 세션을 모으지 않고 accept마다 새로 만든다
+// usage: AcceptBenchmark [connections=20000] [client_threads=32] [listeners=0] [accepts=16] [backlog=SOMAXCONN] [io_threads=2] [port=7800] [engine=epoll|io_uring]
+//                        [first_byte_timeout_ms=3000] [session_pool=4096]
+
+namespace
+{
+    class AcceptClientSession : public ClientSession
+    {
+    public:
+        void on_connected() override
+        {
+            S2C_TestEcho send_message;
+            send_message.set_session_id(get_id());
+            do_send(send_message);
+        }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    const int connection_count = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int client_thread_count = argc > 2 ? std::max(1, std::atoi(argv[2])) : 32;
+    reuse_port_listener_count = argc > 3 ? std::atoi(argv[3]) : 0;
+    const int accept_count = argc > 4 ? std::atoi(argv[4]) : 16;
+    if (argc > 5)
+        listen_backlog = std::atoi(argv[5]);
+    const int io_thread_count = argc > 6 ? std::atoi(argv[6]) : 2;
+    const int port = argc > 7 ? std::atoi(argv[7]) : 7800;
+    const IoEngineType engine_type = (argc > 8 && 0 == std::strcmp(argv[8], "io_uring")) ? IoEngineType::IO_URING : IoEngineType::DEFAULT;
+    const int first_byte_timeout_ms = argc > 9 ? std::atoi(argv[9]) : 3000;
+    if (argc > 10)
+        session_pool_max_count = std::atoi(argv[10]);
+
+    // 스레드를 멈추는 경로가 없으므로 서비스는 종료 시까지 살려둔다
+    ServerBase* server = xnew ServerBase;
+    server->init(io_thread_count, 0, [](){ return xmake_shared(NetworkSection); }, 2, engine_type);
+    server->open("127.0.0.1", port, [](){ return xnew AcceptClientSession; }, accept_count);
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+    server_addr.sin_port = htons(port);
+
+    std::atomic<int> next_connection{ 0 };
+    std::atomic<int> failed_count{ 0 };
+    std::atomic<int> timeout_count{ 0 };
+    std::vector<std::vector<long long>> ttfb_us_per_thread(client_thread_count);
+    const auto start_time = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < client_thread_count; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            std::vector<long long>& ttfb_us = ttfb_us_per_thread[t];
+            while (next_connection.fetch_add(1) < connection_count)
+            {
+                const auto connect_time = std::chrono::steady_clock::now();
+                SOCKET socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+                // RST로 끊어 클라이언트 쪽 TIME_WAIT가 포트를 다 쓰지 않게 한다
+                linger no_linger{};
+                no_linger.l_onoff = 1;
+                no_linger.l_linger = 0;
+                ::setsockopt(socket, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&no_linger), sizeof(no_linger));
+#ifdef _WIN32
+                DWORD recv_timeout = first_byte_timeout_ms;
+#else
+                timeval recv_timeout{ first_byte_timeout_ms / 1000, (first_byte_timeout_ms % 1000) * 1000 };
+#endif
+                ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&recv_timeout), sizeof(recv_timeout));
+
+                if (SOCKET_ERROR == ::connect(socket, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)))
+                {
+                    failed_count.fetch_add(1);
+                    closesocket(socket);
+                    continue;
+                }
+
+                char buffer[64];
+                if (0 >= ::recv(socket, buffer, sizeof(buffer), 0))
+                {
+                    timeout_count.fetch_add(1);
+                    closesocket(socket);
+                    continue;
+                }
+
+                ttfb_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - connect_time).count());
+                closesocket(socket);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    // 끊긴 세션이 모두 정리되는지 본다 (send 완료가 늦게 와도 남거나 먼저 지워지면 안 된다)
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const int remaining_session_count = server->get_session_count();
+
+    std::vector<long long> ttfb_us;
+    for (std::vector<long long>& thread_ttfb_us : ttfb_us_per_thread)
+        ttfb_us.insert(ttfb_us.end(), thread_ttfb_us.begin(), thread_ttfb_us.end());
+    std::sort(ttfb_us.begin(), ttfb_us.end());
+    auto percentile = [&](double ratio) { return ttfb_us.empty() ? 0 : ttfb_us[std::min(ttfb_us.size() - 1, static_cast<size_t>(ttfb_us.size() * ratio))]; };
+
+    std::cout << "=== Accept Benchmark ===" << std::endl;
+    std::cout << "backend: " << get_io_engine_name(server->get_io_engine_type()) << ", io threads: " << io_thread_count << ", client threads: " << client_thread_count
+              << ", listeners: " << (0 < reuse_port_listener_count ? reuse_port_listener_count : io_thread_count) << ", accepts per listener: " << accept_count
+              << ", backlog: " << listen_backlog << std::endl;
+    std::cout << "connections: " << ttfb_us.size() << " of " << connection_count << " (" << failed_count.load() << " connect failed, " << timeout_count.load() << " no first byte in " << first_byte_timeout_ms << " ms)" << std::endl;
+    std::cout << "connections/sec: " << static_cast<long long>(ttfb_us.size() / elapsed) << std::endl;
+    std::cout << "time to first byte us p50: " << percentile(0.5) << ", p99: " << percentile(0.99) << ", max: " << (ttfb_us.empty() ? 0 : ttfb_us.back()) << std::endl;
+    std::cout << "sessions left on server: " << remaining_session_count << std::endl;
+    SessionPool& session_pool = server->get_session_pool();
+    std::cout << "session pool (max " << session_pool_max_count << "): created " << session_pool.get_created_count() << ", reused " << session_pool.get_reused_count()
+              << ", pooled " << session_pool.get_pooled_count() << std::endl;
+    std::cout.flush();
+
+    std::quick_exit(0);
+}
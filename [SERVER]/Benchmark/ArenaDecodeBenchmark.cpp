@@ -0,0 +1,165 @@
+#include "pch.h"
+#include <iomanip>
+#include <random>
+
+// 메시지 아레나 벤치마크
+// 받은 패킷을 PacketDispatcher 표로 실행할 때 메시지를 스택에 디코딩하는 방식과 섹션의 MessageArena에 디코딩하는 방식의
+// 패킷당 힙 할당 수(operator new 호출)와 시간을 비교한다. 아레나는 섹션처럼 batch개마다 비운다
+// 보낼 메시지도 스택과 아레나에서 만들어 패킷으로 직렬화하는 비용을 비교한다
+// 문자열 필드는 std::string의 작은 문자열 최적화(15바이트)를 넘는 길이로 채운다
+// usage: ArenaDecodeBenchmark [packets=2000000] [batch=256] [initial_block_kb=256]
+
+namespace
+{
+    std::atomic<long long> g_new_count{ 0 };
+}
+
+// 이 프로그램의 힙 할당을 센다
+void* operator new(size_t size)
+{
+    g_new_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = ::malloc(0 == size ? 1 : size))
+        return block;
+    throw std::bad_alloc();
+}
+void operator delete(void* block) noexcept { ::free(block); }
+void operator delete(void* block, size_t) noexcept { ::free(block); }
+
+namespace
+{
+    volatile long long g_sink = 0;
+
+    Packet* make_packet(google::protobuf::Message& message, unsigned short protocol_number)
+    {
+        Packet* packet = xnew Packet;
+        packet->reserve_packet_buffer(PACKET_HEADER_SIZEOF + static_cast<int>(message.ByteSizeLong()));
+        packet->initialize(protocol_number);
+        packet->push(message);
+        packet->finalize();
+        return packet;
+    }
+
+    class ArenaSession : public ClientSession
+    {
+        friend class ::PacketDispatcher;
+    public:
+        void init_handlers() override
+        {
+            PacketDispatcher::bind_c2s(this);
+        }
+
+        long long m_checksum = 0;
+
+    private:
+        void on_packet(C2S_TestEcho& message) { m_checksum += message.rand_number(); }
+        void on_packet(C2S_AccountRegister& message) { m_checksum += static_cast<long long>(message.id().size() + message.password().size()); }
+        void on_packet(C2S_AccountLogin& message) { m_checksum += static_cast<long long>(message.id().size() + message.password().size()); }
+    };
+
+    struct Result
+    {
+        double ns_per_packet = 0;
+        double allocs_per_packet = 0;
+    };
+
+    template<typename Work>
+    Result run(int count, int batch, MessageArena* arena, Work&& work)
+    {
+        MessageArena::set_current(arena);
+        const long long start_new_count = g_new_count.load();
+        const auto start_time = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+        {
+            work(i);
+            if (nullptr != arena && 0 == (i + 1) % batch)
+                arena->reset();
+        }
+        if (nullptr != arena)
+            arena->reset();
+        const double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+        const long long new_count = g_new_count.load() - start_new_count;
+        MessageArena::set_current(nullptr);
+
+        return Result{ elapsed_ns / count, static_cast<double>(new_count) / count };
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int packet_count = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    const int batch = argc > 2 ? std::max(1, std::atoi(argv[2])) : 256;
+    const int initial_block_size = (argc > 3 ? std::atoi(argv[3]) : 256) * 1024;
+
+    std::mt19937 random(7);
+    std::vector<Packet*> packets;
+    for (int i = 0; i < 1024; ++i)
+    {
+        const int kind = std::uniform_int_distribution<int>(0, 2)(random);
+        if (0 == kind)
+        {
+            C2S_TestEcho message;
+            message.set_rand_number(i);
+            packets.push_back(make_packet(message, ProtocolOf<C2S_TestEcho>::value));
+        }
+        else if (1 == kind)
+        {
+            C2S_AccountRegister message;
+            message.set_id("register_user_" + std::to_string(100000 + i));
+            message.set_password("register_password_" + std::to_string(i));
+            packets.push_back(make_packet(message, ProtocolOf<C2S_AccountRegister>::value));
+        }
+        else
+        {
+            C2S_AccountLogin message;
+            message.set_id("login_user_" + std::to_string(100000 + i));
+            message.set_password("login_password_" + std::to_string(i));
+            packets.push_back(make_packet(message, ProtocolOf<C2S_AccountLogin>::value));
+        }
+    }
+
+    ArenaSession session;
+    session.init();
+    MessageArena arena;
+    arena.init(initial_block_size);
+
+    auto decode = [&](int i) { session.Session::execute_packet(packets[i % packets.size()]); };
+    const Result stack_decode = run(packet_count, batch, nullptr, decode);
+    const long long stack_checksum = session.m_checksum;
+    session.m_checksum = 0;
+    const Result arena_decode = run(packet_count, batch, &arena, decode);
+
+    // 보낼 메시지 만들기 + 직렬화 (패킷 버퍼는 PacketBufferPool에서 오므로 메시지 필드 할당만 차이난다)
+    const std::string game_server_ip = "game-server-01.internal.example";
+    auto build_on_stack = [&](int i)
+    {
+        S2C_AccountLogin message;
+        message.set_result_code(AccountLoginResult::SUCCESS);
+        message.set_game_server_ip(game_server_ip);
+        message.set_game_server_port(i);
+        g_sink = g_sink + Packet::create(message)->get_protocol();
+    };
+    auto build_on_arena = [&](int i)
+    {
+        S2C_AccountLogin* message = MessageArena::get_current()->create<S2C_AccountLogin>();
+        message->set_result_code(AccountLoginResult::SUCCESS);
+        message->set_game_server_ip(game_server_ip);
+        message->set_game_server_port(i);
+        g_sink = g_sink + Packet::create(*message)->get_protocol();
+    };
+    const Result stack_build = run(packet_count, batch, nullptr, build_on_stack);
+    const Result arena_build = run(packet_count, batch, &arena, build_on_arena);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "=== Arena Decode Benchmark ===" << std::endl;
+    std::cout << "packets: " << packet_count << ", reset every " << batch << " packets, initial block: " << initial_block_size / 1024 << " KB"
+              << ", checksum " << (stack_checksum == session.m_checksum ? "match" : "MISMATCH") << std::endl;
+    std::cout << "decode stack: " << stack_decode.ns_per_packet << " ns, " << stack_decode.allocs_per_packet << " allocs/packet" << std::endl;
+    std::cout << "decode arena: " << arena_decode.ns_per_packet << " ns, " << arena_decode.allocs_per_packet << " allocs/packet" << std::endl;
+    std::cout << "build + serialize stack: " << stack_build.ns_per_packet << " ns, " << stack_build.allocs_per_packet << " allocs/packet" << std::endl;
+    std::cout << "build + serialize arena: " << arena_build.ns_per_packet << " ns, " << arena_build.allocs_per_packet << " allocs/packet" << std::endl;
+    std::cout << "arena messages: " << arena.get_created_count() << ", block allocs: " << arena.get_block_alloc_count() << ", resets: " << arena.get_reset_count()
+              << ", peak used: " << arena.get_peak_used_bytes() / 1024 << " KB" << std::endl;
+    std::cout.flush();
+
+    std::_Exit(0);
+}
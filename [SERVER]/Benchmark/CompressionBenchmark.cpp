@@ -0,0 +1,245 @@
+#include "pch.h"
+#include <iomanip>
+
+// 패킷 압축 벤치마크
+// Protocols.proto의 메시지마다 PacketCompressor로 압축했을 때의 압축률(압축된 본문 / 원래 본문)과 패킷 하나당 압축 / 해제 시간을 본다
+// 지금 메시지들은 대부분 작아서 압축해도 작아지지 않으므로(skipped), 문자열 필드를 키운 메시지로 어느 크기부터 이득인지도 본다
+// 마지막으로 서버가 압축 워커에서 압축한 패킷을 소켓으로 받아 풀어 보며 순서와 선로 바이트를 확인한다
+// blocked_hard_tasks를 주면 그 수로 묶은 하드 task 워커를 모두 DB 대기처럼 막아두고 보낸다 (압축이 하드 task 워커에 밀리지 않는지)
+// usage: CompressionBenchmark [packets=200000] [stream_packets=20000] [compression_threads=2] [port=7950] [level=1] [blocked_hard_tasks=0]
+
+namespace
+{
+    volatile long long g_sink = 0;
+    std::atomic<bool> g_is_stream_done{ false };
+
+    // 사람이 쓰는 글처럼 단어가 반복되는 문자열
+    std::string make_text(int size)
+    {
+        static const char* const words[] = { "guild", "party", "raid", "boss", "loot", "ready", "heal", "tank", "dps", "wipe", "again", "sword", "shield" };
+        std::string text;
+        for (int i = 0; static_cast<int>(text.size()) < size; ++i)
+        {
+            text += words[(i * 7 + i / 3) % 13];
+            text += (0 == i % 5) ? std::to_string(i % 97) + " " : " ";
+        }
+        text.resize(size);
+        return text;
+    }
+
+    template<typename MessageT>
+    void measure(const char* name, const MessageT& message, int count)
+    {
+        PacketCompressor& compressor = PacketCompressor::get_instance();
+        const unsigned short protocol_number = ProtocolOf<MessageT>::value;
+        const PacketCompressor::Stats before = compressor.get_stats(protocol_number);
+
+        // 압축은 Packet::create 안에서 (워커가 없으므로 이 스레드에서) 하고, 해제는 받은 패킷처럼 복사본을 푼다
+        Packet original;
+        original.set_message(protocol_number, message);
+        bool is_round_trip_same = true;
+        for (int i = 0; i < count; ++i)
+        {
+            std::shared_ptr<Packet> packet = Packet::create(message);
+            if (false == packet->is_compressed())
+                continue;
+
+            Packet received(packet.get());
+            if (false == compressor.decompress(received) || received.get_size() != original.get_size() || 0 != ::memcmp(received.get_data(), original.get_data(), received.get_size()))
+                is_round_trip_same = false;
+            g_sink = g_sink + received.get_size();
+        }
+
+        const PacketCompressor::Stats after = compressor.get_stats(protocol_number);
+        const long long compressed_count = after.compressed_count - before.compressed_count;
+        const long long skipped_count = after.skipped_count - before.skipped_count;
+        const long long raw_bytes = after.raw_bytes - before.raw_bytes;
+        const long long compressed_bytes = after.compressed_bytes - before.compressed_bytes;
+        const long long decompressed_count = after.decompressed_count - before.decompressed_count;
+
+        std::cout << std::left << std::setw(30) << name << std::right << " body " << std::setw(5) << original.get_body_size() << " bytes, ";
+        if (0 == compressed_count)
+            std::cout << "skipped (not smaller)";
+        else
+            std::cout << "ratio " << std::setw(5) << static_cast<double>(compressed_bytes) / raw_bytes;
+        std::cout << ", compress " << std::setw(7) << static_cast<double>(after.compress_ns - before.compress_ns) / std::max(1LL, compressed_count + skipped_count) << " ns"
+                  << ", decompress " << std::setw(7) << (decompressed_count > 0 ? static_cast<double>(after.decompress_ns - before.decompress_ns) / decompressed_count : 0) << " ns"
+                  << (is_round_trip_same ? "" : "  ROUND TRIP DIFFERS") << std::endl;
+    }
+
+    class CompressClientSession : public ClientSession
+    {
+    public:
+        static inline int s_stream_packet_count = 0;
+        static inline std::string s_game_server_ip;
+
+        void on_connected() override
+        {
+            for (int i = 0; i < s_stream_packet_count; ++i)
+            {
+                S2C_AccountLogin send_message;
+                send_message.set_result_code(AccountLoginResult::SUCCESS);
+                send_message.set_game_server_ip(s_game_server_ip);
+                send_message.set_game_server_port(i);
+                do_send(send_message);
+            }
+        }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    const int packet_count = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const int stream_packet_count = argc > 2 ? std::atoi(argv[2]) : 20000;
+    packet_compression_thread_count = argc > 3 ? std::max(0, std::atoi(argv[3])) : 2;
+    const int port = argc > 4 ? std::atoi(argv[4]) : 7950;
+    if (argc > 5)
+        packet_compression_level = std::atoi(argv[5]);
+    const int blocked_hard_task_count = argc > 6 ? std::max(0, std::atoi(argv[6])) : 0;
+
+    PacketCompressor& compressor = PacketCompressor::get_instance();
+    for (int protocol_number = 0; protocol_number < packet_number_ARRAYSIZE; ++protocol_number)
+        compressor.enable(static_cast<unsigned short>(protocol_number), 1);
+
+    C2S_TestEcho c2s_test_echo;
+    c2s_test_echo.set_rand_number(123456);
+    S2C_TestEcho s2c_test_echo;
+    s2c_test_echo.set_session_id(42);
+    s2c_test_echo.set_rand_number(123456);
+    C2S_AccountRegister c2s_account_register;
+    c2s_account_register.set_id("register_user_100001");
+    c2s_account_register.set_password("register_password_1");
+    S2C_AccountRegister s2c_account_register;
+    s2c_account_register.set_result_code(AccountRegisterResult::ID_ALREADY_EXIST);
+    C2S_AccountLogin c2s_account_login;
+    c2s_account_login.set_id("login_user_100001");
+    c2s_account_login.set_password("login_password_1");
+    S2C_AccountLogin s2c_account_login;
+    s2c_account_login.set_result_code(AccountLoginResult::SUCCESS);
+    s2c_account_login.set_game_server_ip("game-server-01.internal.example");
+    s2c_account_login.set_game_server_port(7777);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "=== Compression Benchmark ===" << std::endl;
+    std::cout << "packets per message: " << packet_count << ", zlib level: " << packet_compression_level << std::endl;
+    measure("C2S_TestEcho", c2s_test_echo, packet_count);
+    measure("S2C_TestEcho", s2c_test_echo, packet_count);
+    measure("C2S_AccountRegister", c2s_account_register, packet_count);
+    measure("S2C_AccountRegister", s2c_account_register, packet_count);
+    measure("C2S_AccountLogin", c2s_account_login, packet_count);
+    measure("S2C_AccountLogin", s2c_account_login, packet_count);
+
+    // 문자열 필드가 커지면 어디서부터 이득인지
+    for (int text_size : { 64, 256, 1024, 4096, 16384 })
+    {
+        S2C_AccountLogin large_message = s2c_account_login;
+        large_message.set_game_server_ip(make_text(text_size));
+        const std::string name = "S2C_AccountLogin (" + std::to_string(text_size) + " text)";
+        measure(name.c_str(), large_message, std::max(1, packet_count * 64 / text_size / 16));
+    }
+
+    // 워커에서 압축해 소켓으로 보낸 패킷을 받아 풀어 본다
+    // 접속하자마자 한꺼번에 넣으므로 send 큐 제한은 다 들어가게 늘린다
+    CompressClientSession::s_stream_packet_count = stream_packet_count;
+    send_queue_max_bytes = INT_MAX;
+    send_queue_max_packets = INT_MAX;
+    CompressClientSession::s_game_server_ip = make_text(1024);
+
+    // 스레드를 멈추는 경로가 없으므로 서비스는 종료 시까지 살려둔다
+    ServerBase* server = xnew ServerBase;
+    server->init(1, std::max(1, blocked_hard_task_count), [](){ return xmake_shared(NetworkSection); }, 1);
+
+    // DB 커넥션 수로 묶인 하드 task 워커가 모두 쿼리를 기다리는 상황
+    if (0 < blocked_hard_task_count)
+    {
+        server->get_hard_task_pool().set_max_thread_count(blocked_hard_task_count);
+        for (int i = 0; i < blocked_hard_task_count; ++i)
+        {
+            iTask* task = xnew iTask;
+            task->func = []()
+            {
+                HardTaskPool::BlockingScope blocking_scope;
+                while (false == g_is_stream_done.load())
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            };
+            server->push_hard_task(task, HardTaskPriority::INTERACTIVE);
+        }
+    }
+    server->open("127.0.0.1", port, [](){ return xnew CompressClientSession; });
+
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+    server_addr.sin_port = htons(port);
+
+    SOCKET socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    const auto start_time = std::chrono::steady_clock::now();
+    if (SOCKET_ERROR == ::connect(socket, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)))
+    {
+        std::cout << "connect failed" << std::endl;
+        std::quick_exit(1);
+    }
+
+    // 압축이 멈추면 기다리지 않고 받은 데까지 보여준다
+    timeval recv_timeout{ 5, 0 };
+    ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&recv_timeout), sizeof(recv_timeout));
+
+    std::vector<char> stream;
+    std::vector<char> buffer(64 * 1024);
+    long long wire_bytes = 0;
+    long long raw_bytes = 0;
+    int received_count = 0;
+    int compressed_count = 0;
+    int order_error_count = 0;
+    bool is_broken = false;
+    while (received_count < stream_packet_count && false == is_broken)
+    {
+        const int received = ::recv(socket, buffer.data(), static_cast<int>(buffer.size()), 0);
+        if (0 >= received)
+            break;
+        stream.insert(stream.end(), buffer.data(), buffer.data() + received);
+
+        size_t offset = 0;
+        while (stream.size() - offset >= PACKET_HEADER_SIZEOF)
+        {
+            PacketHeader header;
+            ::memcpy(&header, stream.data() + offset, PACKET_HEADER_SIZEOF);
+            if (stream.size() - offset < header.packet_size)
+                break;
+
+            Packet packet;
+            packet.set_packet(stream.data() + offset, header.packet_size);
+            wire_bytes += header.packet_size;
+            offset += header.packet_size;
+            if (packet.is_compressed())
+            {
+                ++compressed_count;
+                if (false == compressor.decompress(packet))
+                {
+                    is_broken = true;
+                    break;
+                }
+            }
+            raw_bytes += packet.get_size();
+
+            S2C_AccountLogin message;
+            packet.pop_message(message);
+            if (message.game_server_port() != received_count || message.game_server_ip() != CompressClientSession::s_game_server_ip)
+                ++order_error_count;
+            ++received_count;
+        }
+        stream.erase(stream.begin(), stream.begin() + offset);
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    closesocket(socket);
+    g_is_stream_done.store(true);
+
+    std::cout << "stream over socket (S2C_AccountLogin with 1024 text, " << packet_compression_thread_count << " compression threads, " << blocked_hard_task_count
+              << " blocked hard task threads): received " << received_count << " of " << stream_packet_count << ", compressed " << compressed_count
+              << " (" << compressor.get_inline_count() << " inline), order / content errors " << order_error_count << (is_broken ? ", DECOMPRESS FAILED" : "") << std::endl;
+    std::cout << "wire bytes " << wire_bytes / 1024 << " KB, uncompressed " << raw_bytes / 1024 << " KB (" << (raw_bytes > 0 ? static_cast<double>(wire_bytes) / raw_bytes : 0)
+              << "), " << static_cast<long long>(received_count / elapsed) << " packets/s" << std::endl;
+    std::cout.flush();
+
+    std::quick_exit(0);
+}
@@ -0,0 +1,139 @@
+#include "pch.h"
+
+// 에코 처리량 벤치마크
+// 같은 프로그램을 윈도우(IOCP)와 리눅스(epoll / io_uring)에서 실행해 초당 왕복 패킷 수를 비교한다
+// sections와 work_us(패킷마다 섹션 스레드가 일하는 시간)를 주면 섹션 수와 섹션 고르기 정책에 따라 처리량이 어떻게 늘어나는지 본다
+// usage: EchoBenchmark [connections=100] [pipeline=16] [seconds=10] [io_threads=2] [port=7777] [engine=epoll|io_uring]
+//                      [coalesce=0|1] [flush=immediate|batch|<delay us>] [sections=1] [select=first|sessions|queued|p2c|hash] [work_us=0]
+
+static std::atomic<long long> g_echo_count{0};
+static int g_pipeline_depth = 16;
+static int g_work_us = 0;
+
+class EchoClientSession : public ClientSession
+{
+    friend class PacketDispatcher;
+public:
+    void init_handlers() override
+    {
+        PacketDispatcher::bind_c2s(this);
+    }
+
+private:
+    void on_packet(C2S_TestEcho& recv_message)
+    {
+        // 게임 로직 대신 섹션 스레드를 붙잡고 돈다
+        const auto work_end_time = std::chrono::steady_clock::now() + std::chrono::microseconds(g_work_us);
+        while (0 < g_work_us && std::chrono::steady_clock::now() < work_end_time) {}
+
+        S2C_TestEcho send_message;
+        send_message.set_session_id(get_id());
+        send_message.set_rand_number(recv_message.rand_number());
+        do_send(send_message);
+    }
+};
+
+class EchoServer : public ServerBase
+{
+public:
+    const std::map<unsigned int, std::shared_ptr<NetworkSection>>& get_sections() const { return m_sections; }
+};
+
+class EchoServerSession : public ServerSession
+{
+    friend class PacketDispatcher;
+public:
+    void init_handlers() override
+    {
+        PacketDispatcher::bind_s2c(this);
+    }
+
+    void on_connected() override
+    {
+        for (int i = 0; i < g_pipeline_depth; ++i)
+            send_echo(i);
+    }
+
+private:
+    void on_packet(S2C_TestEcho& recv_message)
+    {
+        g_echo_count.fetch_add(1, std::memory_order_relaxed);
+        send_echo(recv_message.rand_number());
+    }
+
+    void send_echo(int number)
+    {
+        C2S_TestEcho send_message;
+        send_message.set_rand_number(number);
+        do_send(send_message);
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    const int connection_count = argc > 1 ? std::atoi(argv[1]) : 100;
+    g_pipeline_depth = argc > 2 ? std::atoi(argv[2]) : 16;
+    const int seconds = argc > 3 ? std::atoi(argv[3]) : 10;
+    const int io_thread_count = argc > 4 ? std::atoi(argv[4]) : 2;
+    const int port = argc > 5 ? std::atoi(argv[5]) : 7777;
+    const IoEngineType engine_type = (argc > 6 && 0 == std::strcmp(argv[6], "io_uring")) ? IoEngineType::IO_URING : IoEngineType::DEFAULT;
+    send_coalescing_mode = argc > 7 && 0 != std::atoi(argv[7]);
+    if (argc > 8 && 0 == std::strcmp(argv[8], "batch"))
+        send_flush_policy = SendFlushPolicy::END_OF_BATCH;
+    else if (argc > 8 && 0 != std::strcmp(argv[8], "immediate"))
+    {
+        send_flush_policy = SendFlushPolicy::DELAYED;
+        send_flush_delay_us = std::atoi(argv[8]);
+    }
+    const int section_count = argc > 9 ? std::max(1, std::atoi(argv[9])) : 1;
+    const std::string select_name = argc > 10 ? argv[10] : "sessions";
+    static const std::map<std::string, SectionSelectPolicy> select_policies = {
+        { "first", SectionSelectPolicy::FIRST }, { "sessions", SectionSelectPolicy::LEAST_SESSIONS }, { "queued", SectionSelectPolicy::LEAST_QUEUED },
+        { "p2c", SectionSelectPolicy::POWER_OF_TWO_LOAD }, { "hash", SectionSelectPolicy::CONSISTENT_HASH } };
+    if (select_policies.count(select_name))
+        section_select_policy = select_policies.at(select_name);
+    g_work_us = argc > 11 ? std::atoi(argv[11]) : 0;
+
+    // 스레드를 멈추는 경로가 없으므로 서비스는 종료 시까지 살려둔다
+    EchoServer* server = xnew EchoServer;
+    server->init(io_thread_count, 0, [](){ return xmake_shared(NetworkSection); }, section_count, engine_type);
+    server->open("127.0.0.1", port, [](){ return xnew EchoClientSession; }, 16);
+
+    ClientBase* client = xnew ClientBase;
+    client->init(io_thread_count, engine_type);
+    client->open("127.0.0.1", port, [](){ return xnew EchoServerSession; }, connection_count);
+
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    g_echo_count.store(0);
+    const long long start_send_call_count = MultiSender::get_send_call_count();
+    const long long start_sent_packet_count = MultiSender::get_sent_packet_count();
+
+    const auto start_time = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    const long long echo_count = g_echo_count.load();
+    const long long send_call_count = MultiSender::get_send_call_count() - start_send_call_count;
+    const long long sent_packet_count = MultiSender::get_sent_packet_count() - start_sent_packet_count;
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    std::cout << "=== Echo Benchmark ===" << std::endl;
+    std::cout << "backend: " << get_io_engine_name(server->get_io_engine_type()) << ", connections: " << connection_count << ", pipeline: " << g_pipeline_depth
+              << ", io threads: " << io_thread_count << std::endl;
+    std::cout << "send: coalesce " << (send_coalescing_mode ? "on" : "off") << ", flush "
+              << (SendFlushPolicy::IMMEDIATE == send_flush_policy ? "immediate" : SendFlushPolicy::END_OF_BATCH == send_flush_policy ? "batch" : "delayed")
+              << ", send calls per packet: " << (sent_packet_count > 0 ? static_cast<double>(send_call_count) / sent_packet_count : 0) << std::endl;
+    std::cout << "sections: " << section_count << " (select " << select_name << ", work " << g_work_us << " us), sessions per section:";
+    for (auto& section_pair : server->get_sections())
+        std::cout << " " << section_pair.second->get_session_count();
+    std::cout << ", load:";
+    for (auto& section_pair : server->get_sections())
+        std::cout << " " << static_cast<int>(section_pair.second->get_load() * 100) << "%";
+    std::cout << std::endl;
+    std::cout << "echo/sec: " << static_cast<long long>(echo_count / elapsed) << std::endl;
+    std::cout << "recv buffer: " << RecvBufferPool::get_instance().get_in_use_bytes() / 1024 << " KB in use, "
+              << RecvBufferPool::get_instance().get_pooled_bytes() / 1024 << " KB pooled (server + client, " << connection_count * 2 << " sessions)" << std::endl;
+    std::cout << "packet buffer: hit " << PacketBufferPool::get_instance().get_hit_count() << ", miss " << PacketBufferPool::get_instance().get_miss_count()
+              << ", outstanding " << PacketBufferPool::get_instance().get_outstanding_bytes() / 1024 << " KB" << std::endl;
+    std::cout.flush();
+
+    std::quick_exit(0);
+}
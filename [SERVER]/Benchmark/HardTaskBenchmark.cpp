@@ -0,0 +1,115 @@
+#include "pch.h"
+#include <ctime>
+
+// 하드 task 풀 벤치마크
+// DB 호출처럼 막히는 NORMAL task(회원가입 폭주)를 워커가 감당 못할 만큼 넣으면서 INTERACTIVE task(로그인)를 섞어 넣고,
+// 우선순위별로 실행 시각부터 실행 시작까지 기다린 시간을 본다. 끝나고 할 일이 없을 때 워커가 CPU를 쓰는지도 잰다
+// max_workers가 workers보다 크면 워커 수 자동 조절을 켜고, 몇 개까지 늘었다가 일이 끝난 뒤 다시 줄어드는지 본다
+// usage: HardTaskBenchmark [seconds=3] [workers=4] [flood_per_sec=4000] [interactive_per_sec=200] [task_ms=2] [max_workers=workers]
+
+namespace
+{
+    struct ClassStats
+    {
+        std::mutex mutex;
+        std::vector<long long> wait_us;
+    };
+    ClassStats g_stats[HARD_TASK_PRIORITY_COUNT];
+    std::atomic<int> g_done_count{ 0 };
+
+    long long percentile(std::vector<long long>& values, double ratio)
+    {
+        if (values.empty())
+            return 0;
+        std::sort(values.begin(), values.end());
+        return values[std::min(values.size() - 1, static_cast<size_t>(ratio * values.size()))];
+    }
+
+    iTask* make_task(HardTaskPriority priority, int task_ms)
+    {
+        iTask* task = xnew iTask;
+        const auto push_time = std::chrono::steady_clock::now();
+        task->func = [priority, task_ms, push_time]()
+        {
+            const long long wait_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - push_time).count();
+            {
+                ClassStats& stats = g_stats[static_cast<int>(priority)];
+                std::lock_guard<std::mutex> lock(stats.mutex);
+                stats.wait_us.push_back(wait_us);
+            }
+            {
+                HardTaskPool::BlockingScope blocking;
+                std::this_thread::sleep_for(std::chrono::milliseconds(task_ms));
+            }
+            g_done_count.fetch_add(1);
+        };
+        return task;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 3;
+    const int worker_count = argc > 2 ? std::atoi(argv[2]) : 4;
+    const int flood_per_sec = argc > 3 ? std::atoi(argv[3]) : 4000;
+    const int interactive_per_sec = argc > 4 ? std::atoi(argv[4]) : 200;
+    const int task_ms = argc > 5 ? std::atoi(argv[5]) : 2;
+    const int max_worker_count = argc > 6 ? std::atoi(argv[6]) : worker_count;
+
+    hard_task_auto_scaling_mode = max_worker_count > worker_count;
+    hard_task_min_threads = worker_count;
+    hard_task_max_threads = max_worker_count;
+    hard_task_shrink_idle_ms = 300;
+
+    ServerBase server;
+    server.init(1, worker_count, {}, 0);
+    int peak_worker_count = worker_count;
+
+    const int total_ticks = seconds * 1000;
+    int pushed_count = 0;
+    auto next_tick_time = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < total_ticks; ++tick)
+    {
+        std::this_thread::sleep_until(next_tick_time);
+        next_tick_time += std::chrono::milliseconds(1);
+
+        // 1ms마다 그 사이 몫만큼 넣는다
+        for (int i = flood_per_sec * tick / 1000; i < flood_per_sec * (tick + 1) / 1000; ++i, ++pushed_count)
+            server.push_hard_task(make_task(HardTaskPriority::NORMAL, task_ms), HardTaskPriority::NORMAL);
+        for (int i = interactive_per_sec * tick / 1000; i < interactive_per_sec * (tick + 1) / 1000; ++i, ++pushed_count)
+            server.push_hard_task(make_task(HardTaskPriority::INTERACTIVE, task_ms), HardTaskPriority::INTERACTIVE);
+        peak_worker_count = std::max(peak_worker_count, server.get_hard_task_pool().get_thread_count());
+    }
+
+    while (g_done_count.load() < pushed_count)
+    {
+        peak_worker_count = std::max(peak_worker_count, server.get_hard_task_pool().get_thread_count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // 할 일이 없는 동안 쓴 프로세스 CPU 시간
+    const std::clock_t idle_start_clock = std::clock();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    const double idle_cpu_ratio = static_cast<double>(std::clock() - idle_start_clock) / CLOCKS_PER_SEC;
+
+    std::cout << "=== Hard Task Benchmark ===" << std::endl;
+    std::cout << "workers: " << worker_count << "~" << max_worker_count << ", task: " << task_ms << " ms, normal: " << flood_per_sec << "/s, interactive: " << interactive_per_sec << "/s, " << seconds << " s" << std::endl;
+    static const char* const priority_names[HARD_TASK_PRIORITY_COUNT] = { "interactive", "normal", "background" };
+    for (int priority = 0; priority < HARD_TASK_PRIORITY_COUNT; ++priority)
+    {
+        std::vector<long long>& wait_us = g_stats[priority].wait_us;
+        if (wait_us.empty())
+            continue;
+        const size_t count = wait_us.size();
+        std::cout << priority_names[priority] << " wait us (" << count << " tasks) p50: " << percentile(wait_us, 0.5) << ", p99: " << percentile(wait_us, 0.99)
+                  << ", max: " << wait_us.back() << std::endl;
+    }
+
+    HardTaskPool& pool = server.get_hard_task_pool();
+    std::cout << "peak workers: " << peak_worker_count << ", workers after idle: " << pool.get_thread_count()
+              << ", grown: " << pool.get_grow_count() << ", shrunk: " << pool.get_shrink_count() << std::endl;
+    std::cout << "idle cpu: " << static_cast<int>(idle_cpu_ratio * 100) << "% of one core" << std::endl;
+    std::cout.flush();
+
+    std::_Exit(0);
+}
@@ -0,0 +1,211 @@
+#include "pch.h"
+#include <random>
+
+// 세션 섹션 이동 스트레스 벤치마크
+// 클라이언트는 연결마다 0부터 1씩 늘린 번호를 파이프라인으로 보내고, 서버는 받은 번호가 이어지는지 보고 그대로 돌려준다
+// 그 사이 다른 스레드가 무작위 세션을 다른 섹션으로 초당 migrations_per_sec번 옮긴다
+// 서버와 클라이언트 양쪽에서 번호가 빠지거나 뒤바뀐 횟수, 옮기기 시작해서 새 섹션이 넘겨받을 때까지 걸린 시간을 본다
+// 패킷을 잃으면 그 연결의 파이프라인이 멈추므로, 옮기기를 멈춘 뒤 더 이상 응답을 받지 못하는 연결도 센다
+// usage: MigrationBenchmark [connections=100] [pipeline=16] [seconds=5] [sections=4] [migrations_per_sec=5000] [io_threads=2] [port=7790]
+
+namespace
+{
+    std::atomic<long long> g_echo_count{ 0 };
+    std::atomic<long long> g_server_order_error_count{ 0 };
+    std::atomic<long long> g_client_order_error_count{ 0 };
+    int g_pipeline_depth = 16;
+
+    std::mutex g_sessions_mutex;
+    std::vector<std::weak_ptr<ClientSession>> g_sessions;
+
+    class MigrationClientSession : public ClientSession
+    {
+        friend class ::PacketDispatcher;
+    public:
+        void init_handlers() override
+        {
+            PacketDispatcher::bind_c2s(this);
+        }
+
+        void finalize() override
+        {
+            m_expected_number = 0;
+            ClientSession::finalize();
+        }
+
+        void on_connected() override
+        {
+            std::lock_guard<std::mutex> lock(g_sessions_mutex);
+            g_sessions.push_back(std::static_pointer_cast<ClientSession>(shared_from_this()));
+        }
+
+    private:
+        // 섹션을 옮겨도 한 번에 한 섹션 스레드만 실행하므로 락 없이 센다
+        void on_packet(C2S_TestEcho& recv_message)
+        {
+            if (recv_message.rand_number() != m_expected_number)
+                g_server_order_error_count.fetch_add(1, std::memory_order_relaxed);
+            m_expected_number = recv_message.rand_number() + 1;
+
+            S2C_TestEcho send_message;
+            send_message.set_session_id(get_id());
+            send_message.set_rand_number(recv_message.rand_number());
+            do_send(send_message);
+        }
+
+        int m_expected_number = 0;
+    };
+
+    class MigrationServer : public ServerBase
+    {
+    public:
+        const std::map<unsigned int, std::shared_ptr<NetworkSection>>& get_sections() const { return m_sections; }
+    };
+
+    class MigrationServerSession : public ServerSession
+    {
+        friend class ::PacketDispatcher;
+    public:
+        void init_handlers() override
+        {
+            PacketDispatcher::bind_s2c(this);
+        }
+
+        void on_connected() override
+        {
+            for (int i = 0; i < g_pipeline_depth; ++i)
+                send_next();
+        }
+
+        long long get_reply_count() const { return m_reply_count.load(std::memory_order_relaxed); }
+
+    private:
+        void on_packet(S2C_TestEcho& recv_message)
+        {
+            if (recv_message.rand_number() != m_expected_number)
+                g_client_order_error_count.fetch_add(1, std::memory_order_relaxed);
+            m_expected_number = recv_message.rand_number() + 1;
+
+            g_echo_count.fetch_add(1, std::memory_order_relaxed);
+            m_reply_count.fetch_add(1, std::memory_order_relaxed);
+            send_next();
+        }
+
+        void send_next()
+        {
+            C2S_TestEcho send_message;
+            send_message.set_rand_number(m_next_number++);
+            do_send(send_message);
+        }
+
+        int m_next_number = 0;
+        int m_expected_number = 0;
+        std::atomic<long long> m_reply_count{ 0 };
+    };
+    std::vector<MigrationServerSession*> g_client_sessions;
+}
+
+int main(int argc, char* argv[])
+{
+    const int connection_count = argc > 1 ? std::atoi(argv[1]) : 100;
+    g_pipeline_depth = argc > 2 ? std::atoi(argv[2]) : 16;
+    const int seconds = argc > 3 ? std::atoi(argv[3]) : 5;
+    const int section_count = argc > 4 ? std::max(2, std::atoi(argv[4])) : 4;
+    const int migrations_per_sec = argc > 5 ? std::atoi(argv[5]) : 5000;
+    const int io_thread_count = argc > 6 ? std::atoi(argv[6]) : 2;
+    const int port = argc > 7 ? std::atoi(argv[7]) : 7790;
+
+    // 스레드를 멈추는 경로가 없으므로 서비스는 종료 시까지 살려둔다
+    MigrationServer* server = xnew MigrationServer;
+    server->init(io_thread_count, 0, [](){ return xmake_shared(NetworkSection); }, section_count);
+    server->open("127.0.0.1", port, [](){ return xnew MigrationClientSession; }, 16);
+
+    ClientBase* client = xnew ClientBase;
+    client->init(io_thread_count);
+    client->open("127.0.0.1", port, []()
+    {
+        MigrationServerSession* session = xnew MigrationServerSession;
+        g_client_sessions.push_back(session);
+        return session;
+    }, connection_count);
+
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    std::vector<std::shared_ptr<NetworkSection>> sections;
+    for (auto& section_pair : server->get_sections())
+        sections.push_back(section_pair.second);
+
+    g_echo_count.store(0);
+    long long requested_count = 0;
+    long long started_count = 0;
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto end_time = start_time + std::chrono::seconds(seconds);
+
+    std::mt19937 random(7);
+    const auto interval = std::chrono::nanoseconds(1000000000LL / std::max(1, migrations_per_sec));
+    auto next_migration_time = start_time;
+    while (std::chrono::steady_clock::now() < end_time)
+    {
+        std::this_thread::sleep_until(next_migration_time);
+        next_migration_time += interval;
+
+        std::shared_ptr<ClientSession> session;
+        {
+            std::lock_guard<std::mutex> lock(g_sessions_mutex);
+            if (g_sessions.empty())
+                continue;
+            session = g_sessions[std::uniform_int_distribution<size_t>(0, g_sessions.size() - 1)(random)].lock();
+        }
+        if (nullptr == session)
+            continue;
+
+        std::shared_ptr<NetworkSection> from = session->get_section();
+        if (nullptr == from)
+            continue;
+        std::shared_ptr<NetworkSection> to = sections[std::uniform_int_distribution<size_t>(0, sections.size() - 1)(random)];
+        if (to == from)
+            to = sections[(std::find(sections.begin(), sections.end(), to) - sections.begin() + 1) % sections.size()];
+
+        ++requested_count;
+        if (from->migrate_session(session, to))
+            ++started_count;
+    }
+
+    const long long echo_count = g_echo_count.load();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    // 옮기기를 멈춘 뒤에도 응답이 오는지 본다 (연결이 안 된 세션은 처음부터 0이므로 뺀다)
+    std::vector<long long> reply_counts;
+    for (MigrationServerSession* session : g_client_sessions)
+        reply_counts.push_back(session->get_reply_count());
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    int stalled_count = 0;
+    for (size_t i = 0; i < g_client_sessions.size(); ++i)
+    {
+        if (0 < reply_counts[i] && reply_counts[i] == g_client_sessions[i]->get_reply_count())
+            ++stalled_count;
+    }
+
+    long long migrated_count = 0;
+    long long pause_total_us = 0;
+    long long pause_max_us = 0;
+    for (std::shared_ptr<NetworkSection>& section : sections)
+    {
+        migrated_count += section->get_migrated_in_count();
+        pause_total_us += section->get_migration_pause_total_us();
+        pause_max_us = std::max(pause_max_us, section->get_migration_pause_max_us());
+    }
+
+    std::cout << "=== Migration Benchmark ===" << std::endl;
+    std::cout << "connections: " << server->get_session_count() << " accepted of " << connection_count << ", pipeline: " << g_pipeline_depth
+              << ", sections: " << section_count << ", io threads: " << io_thread_count << std::endl;
+    std::cout << "migrations: " << static_cast<long long>(migrated_count / elapsed) << "/s (" << migrated_count << " done, " << started_count << " started, "
+              << requested_count - started_count << " rejected while moving)" << std::endl;
+    std::cout << "pause us avg: " << (migrated_count > 0 ? pause_total_us / migrated_count : 0) << ", max: " << pause_max_us << std::endl;
+    std::cout << "echo/sec: " << static_cast<long long>(echo_count / elapsed) << std::endl;
+    std::cout << "order errors server: " << g_server_order_error_count.load() << ", client: " << g_client_order_error_count.load()
+              << ", stalled connections: " << stalled_count << std::endl;
+    std::cout.flush();
+
+    std::quick_exit(0);
+}
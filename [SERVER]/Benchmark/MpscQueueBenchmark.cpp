@@ -0,0 +1,121 @@
+#include "pch.h"
+
+// MPSC 큐 경합 벤치마크
+// 생산자 스레드 1 ~ max_producers개가 동시에 넣고 소비자 스레드 하나가 꺼낼 때의 초당 처리 수를
+// 기존 Concurrency::concurrent_queue(윈도우는 PPL, 그 외는 ConcurrentContainers.h의 mutex 구현)와 MpscQueue로 비교한다
+// 생산자별로 넣은 순서대로 꺼내지는지도 함께 확인한다
+// usage: MpscQueueBenchmark [total_items=2000000] [max_producers=32]
+
+namespace
+{
+    struct BenchItem : public MpscNode
+    {
+        int producer_id = 0;
+        int sequence = 0;
+    };
+
+    struct ConcurrentQueueAdapter
+    {
+        static constexpr const char* NAME = "concurrent_queue";
+
+        void push(BenchItem* item) { queue.push(item); }
+        bool try_pop(BenchItem*& item) { return queue.try_pop(item); }
+
+        Concurrency::concurrent_queue<BenchItem*> queue;
+    };
+
+    struct MpscQueueAdapter
+    {
+        static constexpr const char* NAME = "MpscQueue";
+
+        void push(BenchItem* item) { queue.push(item); }
+        bool try_pop(BenchItem*& item) { return queue.try_pop(item); }
+
+        MpscQueue<BenchItem> queue;
+    };
+
+    template<typename Queue>
+    double run(std::vector<BenchItem>& items, int producer_count, bool& is_ordered)
+    {
+        Queue queue;
+        const int items_per_producer = static_cast<int>(items.size()) / producer_count;
+        const long long total = static_cast<long long>(items_per_producer) * producer_count;
+
+        std::atomic<int> ready_count{ 0 };
+        std::atomic<bool> start{ false };
+        std::vector<std::thread> producers;
+        for (int producer_id = 0; producer_id < producer_count; ++producer_id)
+        {
+            producers.emplace_back([&, producer_id]()
+            {
+                BenchItem* begin = &items[static_cast<size_t>(producer_id) * items_per_producer];
+                for (int i = 0; i < items_per_producer; ++i)
+                {
+                    begin[i].producer_id = producer_id;
+                    begin[i].sequence = i;
+                }
+
+                ready_count.fetch_add(1);
+                while (false == start.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+
+                for (int i = 0; i < items_per_producer; ++i)
+                    queue.push(&begin[i]);
+            });
+        }
+
+        while (ready_count.load() < producer_count)
+            std::this_thread::yield();
+
+        std::vector<int> next_sequence(producer_count, 0);
+        is_ordered = true;
+
+        const auto start_time = std::chrono::steady_clock::now();
+        start.store(true, std::memory_order_release);
+
+        for (long long popped = 0; popped < total;)
+        {
+            BenchItem* item = nullptr;
+            if (false == queue.try_pop(item))
+                continue;
+
+            if (item->sequence != next_sequence[item->producer_id]++)
+                is_ordered = false;
+            ++popped;
+        }
+
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        for (std::thread& producer : producers)
+            producer.join();
+
+        return total / elapsed;
+    }
+
+    template<typename Queue>
+    void report(std::vector<BenchItem>& items, int producer_count)
+    {
+        bool is_ordered = true;
+        const double items_per_sec = run<Queue>(items, producer_count, is_ordered);
+        std::cout << "  " << Queue::NAME << ": " << static_cast<long long>(items_per_sec / 1000) << " K items/s"
+                  << (is_ordered ? "" : " (ORDER VIOLATION)") << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int total_items = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    const int max_producers = argc > 2 ? std::atoi(argv[2]) : 32;
+
+    std::vector<BenchItem> items(total_items);
+
+    std::cout << "=== MPSC Queue Benchmark ===" << std::endl;
+    std::cout << "items: " << total_items << ", hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    for (int producer_count = 1; producer_count <= max_producers; producer_count *= 2)
+    {
+        std::cout << "producers: " << producer_count << std::endl;
+        report<ConcurrentQueueAdapter>(items, producer_count);
+        report<MpscQueueAdapter>(items, producer_count);
+    }
+
+    return 0;
+}
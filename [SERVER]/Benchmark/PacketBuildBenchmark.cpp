@@ -0,0 +1,120 @@
+#include "pch.h"
+#include <iomanip>
+
+// 패킷 만들기 벤치마크
+// Protocols.proto의 메시지마다 보낼 패킷을 만드는 시간을
+// 예전 방식(reserve -> initialize -> push(ByteSizeLong 세 번, 0으로 채우는 resize) -> finalize)과 Packet::create(크기 한 번, 정확한 크기 한 번 할당, 캐시된 크기로 직렬화)로 비교한다
+// 브로드캐스트는 받는 세션마다 직렬화하는 방식과 한 번 만든 패킷을 같이 쓰는 방식을 비교한다
+// usage: PacketBuildBenchmark [packets=2000000] [fanout=100]
+
+namespace
+{
+    volatile long long g_sink = 0;
+
+    // 바꾸기 전의 Session::do_send(Message&)가 만들던 패킷 (버퍼는 0으로 채우는 PacketAllocator 벡터)
+    struct LegacyPacket
+    {
+        std::vector<char, PacketAllocator<char>> buffer;
+        int current_idx = 0;
+    };
+
+    std::shared_ptr<LegacyPacket> build_legacy(unsigned short protocol_number, google::protobuf::Message& message)
+    {
+        std::shared_ptr<LegacyPacket> packet = xmake_shared(LegacyPacket);
+        packet->buffer.reserve(PACKET_HEADER_SIZEOF + static_cast<int>(message.ByteSizeLong()));
+
+        packet->buffer.resize(PACKET_HEADER_SIZEOF);
+        packet->current_idx = PACKET_HEADER_SIZEOF;
+        ::memcpy(packet->buffer.data() + PACKET_SIZE_SIZEOF, &protocol_number, PACKET_PROTOCOL_SIZEOF);
+
+        packet->buffer.resize(packet->buffer.size() + message.ByteSizeLong());
+        message.SerializeToArray(packet->buffer.data() + packet->current_idx, static_cast<int>(message.ByteSizeLong()));
+        packet->current_idx += static_cast<int>(message.ByteSizeLong());
+
+        *reinterpret_cast<unsigned short*>(packet->buffer.data()) = static_cast<unsigned short>(packet->current_idx);
+        return packet;
+    }
+
+    template<typename Build>
+    double run(int count, Build&& build)
+    {
+        long long sum = 0;
+        const auto start_time = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+            sum += build(i);
+        const double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+        g_sink = g_sink + sum;
+        return elapsed_ns / count;
+    }
+
+    template<typename MessageT>
+    void compare(const char* name, MessageT& message, int count)
+    {
+        const unsigned short protocol_number = ProtocolOf<MessageT>::value;
+        const double legacy_ns = run(count, [&](int) { return static_cast<long long>(build_legacy(protocol_number, message)->buffer.size()); });
+        const double create_ns = run(count, [&](int) { return static_cast<long long>(Packet::create(message)->get_size()); });
+
+        // 두 방식이 같은 바이트를 만드는지 본다
+        std::shared_ptr<LegacyPacket> legacy = build_legacy(protocol_number, message);
+        std::shared_ptr<Packet> created = Packet::create(message);
+        const bool is_same = legacy->buffer.size() == created->get_size() && 0 == ::memcmp(legacy->buffer.data(), created->get_data(), created->get_size());
+
+        std::cout << std::left << std::setw(22) << name << std::right << " (" << std::setw(3) << created->get_size() << " bytes) legacy: " << std::setw(7) << legacy_ns
+                  << " ns, Packet::create: " << std::setw(7) << create_ns << " ns" << (is_same ? "" : "  BYTES DIFFER") << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int packet_count = argc > 1 ? std::atoi(argv[1]) : 2000000;
+    const int fanout = argc > 2 ? std::max(1, std::atoi(argv[2])) : 100;
+
+    C2S_TestEcho c2s_test_echo;
+    c2s_test_echo.set_rand_number(123456);
+    S2C_TestEcho s2c_test_echo;
+    s2c_test_echo.set_session_id(42);
+    s2c_test_echo.set_rand_number(123456);
+    C2S_AccountRegister c2s_account_register;
+    c2s_account_register.set_id("register_user_100001");
+    c2s_account_register.set_password("register_password_1");
+    S2C_AccountRegister s2c_account_register;
+    s2c_account_register.set_result_code(AccountRegisterResult::ID_ALREADY_EXIST);
+    C2S_AccountLogin c2s_account_login;
+    c2s_account_login.set_id("login_user_100001");
+    c2s_account_login.set_password("login_password_1");
+    S2C_AccountLogin s2c_account_login;
+    s2c_account_login.set_result_code(AccountLoginResult::SUCCESS);
+    s2c_account_login.set_game_server_ip("game-server-01.internal.example");
+    s2c_account_login.set_game_server_port(7777);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "=== Packet Build Benchmark ===" << std::endl;
+    std::cout << "packets per message: " << packet_count << std::endl;
+    compare("C2S_TestEcho", c2s_test_echo, packet_count);
+    compare("S2C_TestEcho", s2c_test_echo, packet_count);
+    compare("C2S_AccountRegister", c2s_account_register, packet_count);
+    compare("S2C_AccountRegister", s2c_account_register, packet_count);
+    compare("C2S_AccountLogin", c2s_account_login, packet_count);
+    compare("S2C_AccountLogin", s2c_account_login, packet_count);
+
+    // 받는 세션 fanout개에게 보낼 패킷 (세션마다 패킷의 참조를 하나씩 쥔다)
+    const int broadcast_count = std::max(1, packet_count / fanout);
+    std::vector<std::shared_ptr<Packet>> recipients(fanout);
+    const double per_session_ns = run(broadcast_count, [&](int)
+    {
+        for (std::shared_ptr<Packet>& recipient : recipients)
+            recipient = Packet::create(s2c_account_login);
+        return static_cast<long long>(recipients.back()->get_size());
+    });
+    const double serialize_once_ns = run(broadcast_count, [&](int)
+    {
+        std::shared_ptr<Packet> packet = Packet::create(s2c_account_login);
+        for (std::shared_ptr<Packet>& recipient : recipients)
+            recipient = packet;
+        return static_cast<long long>(recipients.back()->get_size());
+    });
+    std::cout << "broadcast S2C_AccountLogin to " << fanout << " sessions, serialize per session: " << per_session_ns / 1000 << " us, serialize once: " << serialize_once_ns / 1000 << " us" << std::endl;
+    std::cout.flush();
+
+    std::_Exit(0);
+}
@@ -0,0 +1,158 @@
+#include "pch.h"
+#include <random>
+
+// 패킷 디스패치 벤치마크
+// 예전 방식(세션마다 init_handlers에서 채우는 std::map<packet_number, std::function> + count / operator[])과
+// 생성된 PacketDispatcher 표(packet_number로 바로 찾아 on_packet을 부르는 함수 포인터 배열)의 초당 실행 패킷 수와
+// 세션 하나의 핸들러 준비 시간을 비교한다. 두 방식 모두 메시지 디코딩까지 포함한다
+// usage: PacketDispatchBenchmark [packets=5000000] [sessions=100000]
+
+namespace
+{
+    Packet* make_packet(google::protobuf::Message& message)
+    {
+        Packet* packet = xnew Packet;
+        packet->reserve_packet_buffer(PACKET_HEADER_SIZEOF + static_cast<int>(message.ByteSizeLong()));
+        packet->initialize(PacketNumberMapper::GetProtocolNumber(message.GetTypeName()));
+        packet->push(message);
+        packet->finalize();
+        return packet;
+    }
+
+    class MapSession : public ClientSession
+    {
+    public:
+        void init_handlers() override
+        {
+            m_handlers.emplace(packet_number::TestEcho, [this](auto* p){ this->test_echo_handler(p); });
+            m_handlers.emplace(packet_number::AccountRegister, [this](auto* p){ this->account_register_handler(p); });
+            m_handlers.emplace(packet_number::AccountLogin, [this](auto* p){ this->account_login_handler(p); });
+        }
+
+        // 바꾸기 전의 Session::execute_packet
+        void execute(Packet* packet)
+        {
+            if (0 == m_handlers.count(packet->get_protocol()))
+                return;
+
+            m_handlers[packet->get_protocol()](packet);
+        }
+
+        long long m_checksum = 0;
+
+    private:
+        void test_echo_handler(Packet* packet)
+        {
+            C2S_TestEcho message;
+            packet->pop_message(message);
+            m_checksum += message.rand_number();
+        }
+        void account_register_handler(Packet* packet)
+        {
+            C2S_AccountRegister message;
+            packet->pop_message(message);
+            m_checksum += static_cast<long long>(message.id().size());
+        }
+        void account_login_handler(Packet* packet)
+        {
+            C2S_AccountLogin message;
+            packet->pop_message(message);
+            m_checksum += static_cast<long long>(message.password().size());
+        }
+    };
+
+    class TableSession : public ClientSession
+    {
+        friend class ::PacketDispatcher;
+    public:
+        void init_handlers() override
+        {
+            PacketDispatcher::bind_c2s(this);
+        }
+
+        long long m_checksum = 0;
+
+    private:
+        void on_packet(C2S_TestEcho& message) { m_checksum += message.rand_number(); }
+        void on_packet(C2S_AccountRegister& message) { m_checksum += static_cast<long long>(message.id().size()); }
+        void on_packet(C2S_AccountLogin& message) { m_checksum += static_cast<long long>(message.password().size()); }
+    };
+
+    template<typename Execute>
+    double run(const std::vector<Packet*>& packets, int packet_count, Execute&& execute)
+    {
+        const auto start_time = std::chrono::steady_clock::now();
+        for (int i = 0; i < packet_count; ++i)
+            execute(packets[i % packets.size()]);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        return packet_count / seconds;
+    }
+
+    template<typename SessionT>
+    double init_ns(int session_count)
+    {
+        std::vector<SessionT*> sessions(session_count);
+        const auto start_time = std::chrono::steady_clock::now();
+        for (SessionT*& session : sessions)
+        {
+            session = xnew SessionT;
+            session->init();
+        }
+        const double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+        for (SessionT* session : sessions)
+            xdelete session;
+        return elapsed_ns / session_count;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int packet_count = argc > 1 ? std::atoi(argv[1]) : 5000000;
+    const int session_count = argc > 2 ? std::atoi(argv[2]) : 100000;
+
+    // 에코가 대부분이고 가끔 로그인 / 가입이 섞인 트래픽
+    std::mt19937 random(7);
+    std::vector<Packet*> packets;
+    for (int i = 0; i < 1024; ++i)
+    {
+        const int kind = std::uniform_int_distribution<int>(0, 9)(random);
+        if (kind < 8)
+        {
+            C2S_TestEcho message;
+            message.set_rand_number(i);
+            packets.push_back(make_packet(message));
+        }
+        else if (kind < 9)
+        {
+            C2S_AccountRegister message;
+            message.set_id("user" + std::to_string(i));
+            message.set_password("password");
+            packets.push_back(make_packet(message));
+        }
+        else
+        {
+            C2S_AccountLogin message;
+            message.set_id("user" + std::to_string(i));
+            message.set_password("password");
+            packets.push_back(make_packet(message));
+        }
+    }
+
+    MapSession map_session;
+    map_session.init();
+    TableSession table_session;
+    table_session.init();
+
+    const double map_rate = run(packets, packet_count, [&](Packet* packet) { map_session.execute(packet); });
+    const double table_rate = run(packets, packet_count, [&](Packet* packet) { table_session.Session::execute_packet(packet); });
+
+    std::cout << "=== Packet Dispatch Benchmark ===" << std::endl;
+    std::cout << "packets: " << packet_count << ", checksum " << (map_session.m_checksum == table_session.m_checksum ? "match" : "MISMATCH") << std::endl;
+    std::cout << "map + std::function: " << static_cast<long long>(map_rate) << " packets/s" << std::endl;
+    std::cout << "PacketDispatcher table: " << static_cast<long long>(table_rate) << " packets/s" << std::endl;
+    std::cout << "session init ns, map: " << static_cast<long long>(init_ns<MapSession>(session_count))
+              << ", table: " << static_cast<long long>(init_ns<TableSession>(session_count)) << std::endl;
+    std::cout.flush();
+
+    std::_Exit(0);
+}
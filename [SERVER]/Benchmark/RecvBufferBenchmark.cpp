@@ -0,0 +1,132 @@
+#include "pch.h"
+#include <random>
+
+// RecvBuffer 처리량 벤치마크
+// 잘게 쪼개져 들어오는 파이프라인 트래픽(패킷 경계와 무관한 recv 크기)을 흉내내어
+// 기존 방식(읽은 뒤 남은 바이트를 앞으로 당기는 선형 버퍼)과 이중 매핑 링 버퍼의 초당 처리 바이트를 비교한다
+// usage: RecvBufferBenchmark [seconds=3] [max_fragment=4096] [max_packet=4096] [buffer_size=196605]
+
+namespace
+{
+    // 패킷 복사가 최적화로 사라지지 않도록 결과를 남겨둔다
+    volatile long long g_checksum_sink = 0;
+
+    struct Workload
+    {
+        std::vector<char> stream;
+        std::vector<int> fragments;
+    };
+
+    Workload make_workload(int max_fragment, int max_packet)
+    {
+        std::mt19937 random(7);
+        std::uniform_int_distribution<int> packet_size(PACKET_HEADER_SIZEOF + 8, max_packet);
+        std::uniform_int_distribution<int> fragment_size(1, max_fragment);
+
+        Workload workload;
+        workload.stream.reserve(32 * 1024 * 1024);
+        while (workload.stream.size() < 32 * 1024 * 1024)
+        {
+            PacketHeader header;
+            header.packet_size = static_cast<unsigned short>(packet_size(random));
+            header.protocol_no = 1;
+
+            const size_t offset = workload.stream.size();
+            workload.stream.resize(offset + header.packet_size, static_cast<char>(offset));
+            ::memcpy(&workload.stream[offset], &header, sizeof(header));
+        }
+
+        for (size_t total = 0; total < workload.stream.size();)
+        {
+            workload.fragments.push_back(fragment_size(random));
+            total += workload.fragments.back();
+        }
+
+        return workload;
+    }
+
+    // Session::on_recieve와 같은 방식으로 완성된 패킷을 꺼내 복사한다
+    int consume_packets(RecvBuffer& buffer, char* packet_copy, long long& checksum)
+    {
+        int complete_byte_length = 0;
+        while (true)
+        {
+            const int remain_len = buffer.GetDataSize() - complete_byte_length;
+            if (remain_len < PACKET_HEADER_SIZEOF)
+                break;
+
+            PacketHeader header = *reinterpret_cast<PacketHeader*>(buffer.GetReadPos() + complete_byte_length);
+            if (header.packet_size > remain_len)
+                break;
+
+            ::memcpy(packet_copy, buffer.GetReadPos() + complete_byte_length, header.packet_size);
+            checksum += packet_copy[header.packet_size - 1];
+            complete_byte_length += header.packet_size;
+        }
+
+        return complete_byte_length;
+    }
+
+    double run(const Workload& workload, RecvBuffer& buffer, int seconds)
+    {
+        std::vector<char> packet_copy(USHRT_MAX);
+        long long checksum = 0;
+        long long total_bytes = 0;
+
+        const auto start_time = std::chrono::steady_clock::now();
+        const auto end_time = start_time + std::chrono::seconds(seconds);
+
+        size_t stream_pos = 0;
+        size_t fragment_idx = 0;
+        while (std::chrono::steady_clock::now() < end_time)
+        {
+            for (int i = 0; i < 1024; ++i)
+            {
+                // recv 한 번 = 조각 하나를 남은 공간만큼 복사
+                int size = std::min(workload.fragments[fragment_idx], buffer.GetRemainingSize());
+                size = std::min<int>(size, static_cast<int>(workload.stream.size() - stream_pos));
+                ::memcpy(buffer.GetWritePos(), &workload.stream[stream_pos], size);
+                buffer.OnWrite(size);
+
+                stream_pos += size;
+                if (++fragment_idx == workload.fragments.size())
+                    fragment_idx = 0;
+                if (stream_pos == workload.stream.size())
+                    stream_pos = 0;
+
+                const int consumed = consume_packets(buffer, packet_copy.data(), checksum);
+                buffer.OnRead(consumed);
+                total_bytes += consumed;
+            }
+        }
+
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        g_checksum_sink = checksum;
+
+        return total_bytes / elapsed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 3;
+    const int max_fragment = argc > 2 ? std::atoi(argv[2]) : 4096;
+    const int max_packet = argc > 3 ? std::min(std::atoi(argv[3]), static_cast<int>(USHRT_MAX)) : 4096;
+    const int buffer_size = argc > 4 ? std::atoi(argv[4]) : 65535 * 3;
+
+    const Workload workload = make_workload(max_fragment, max_packet);
+
+    RecvBuffer linear_buffer(buffer_size, false);
+    RecvBuffer ring_buffer(buffer_size, true);
+    const double linear_bytes_per_sec = run(workload, linear_buffer, seconds);
+    const double ring_bytes_per_sec = run(workload, ring_buffer, seconds);
+
+    std::cout << "=== RecvBuffer Benchmark ===" << std::endl;
+    std::cout << "buffer: " << buffer_size << " bytes, max fragment: " << max_fragment << ", max packet: " << max_packet << std::endl;
+    std::cout << "linear (compaction) : " << static_cast<long long>(linear_bytes_per_sec / (1024 * 1024)) << " MB/s" << std::endl;
+    std::cout << "mirrored ring       : " << static_cast<long long>(ring_bytes_per_sec / (1024 * 1024)) << " MB/s"
+              << (ring_buffer.IsMirrored() ? "" : " (mapping failed, linear fallback)") << std::endl;
+    std::cout << "speedup: " << ring_bytes_per_sec / linear_bytes_per_sec << "x" << std::endl;
+
+    return 0;
+}
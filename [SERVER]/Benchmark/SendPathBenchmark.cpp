@@ -0,0 +1,59 @@
+#include "pch.h"
+#include <iomanip>
+
+// 보내기 경로 벤치마크
+// Session::do_send가 메시지를 패킷으로 만들기까지의 비용을
+// 예전 방식(GetTypeName 문자열 + PacketNumberMapper::GetProtocolNumber의 find / substr / unordered_map)과
+// 생성된 ProtocolOf<MessageT>(컴파일 시간 상수)로 비교한다. packet_number 찾기만 따로 잰 값과 패킷 만들기까지 포함한 값을 함께 본다
+// usage: SendPathBenchmark [sends=5000000]
+
+namespace
+{
+    // 최적화로 사라지지 않도록 결과를 남겨둔다
+    volatile long long g_sink = 0;
+
+    template<typename Send>
+    double run(int send_count, Send&& send)
+    {
+        long long sum = 0;
+        const auto start_time = std::chrono::steady_clock::now();
+        for (int i = 0; i < send_count; ++i)
+            sum += send(i);
+        const double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+        g_sink = g_sink + sum;
+        return elapsed_ns / send_count;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int send_count = argc > 1 ? std::atoi(argv[1]) : 5000000;
+
+    S2C_AccountLogin message;
+    message.set_result_code(AccountLoginResult::SUCCESS);
+    message.set_game_server_ip("127.0.0.1");
+    message.set_game_server_port(7777);
+
+    const double lookup_ns = run(send_count, [&](int) { return PacketNumberMapper::GetProtocolNumber(message.GetTypeName()); });
+    const double trait_ns = run(send_count, [&](int) { return ProtocolOf<S2C_AccountLogin>::value; });
+
+    const double lookup_packet_ns = run(send_count, [&](int i)
+    {
+        message.set_game_server_port(i);
+        return Packet::create(PacketNumberMapper::GetProtocolNumber(message.GetTypeName()), message)->get_protocol();
+    });
+    const double trait_packet_ns = run(send_count, [&](int i)
+    {
+        message.set_game_server_port(i);
+        return Packet::create(ProtocolOf<S2C_AccountLogin>::value, message)->get_protocol();
+    });
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "=== Send Path Benchmark ===" << std::endl;
+    std::cout << "sends: " << send_count << " (S2C_AccountLogin)" << std::endl;
+    std::cout << "packet_number ns, GetTypeName + GetProtocolNumber: " << lookup_ns << ", ProtocolOf: " << trait_ns << std::endl;
+    std::cout << "packet_number + Packet::create ns, GetTypeName + GetProtocolNumber: " << lookup_packet_ns << ", ProtocolOf: " << trait_packet_ns << std::endl;
+    std::cout.flush();
+
+    std::_Exit(0);
+}
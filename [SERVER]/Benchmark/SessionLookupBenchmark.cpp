@@ -0,0 +1,109 @@
+#include "pch.h"
+#include <random>
+
+// 세션 조회 벤치마크
+// 세션 sessions개를 넣어두고 lookup_threads개 스레드가 무작위 id로 동시에 찾을 때의 초당 조회 수를
+// 기존 방식(std::map + shared_mutex)과 SessionRegistry::find, 패킷마다 하던 weak_ptr::lock과 SessionRegistry::is_alive로 비교한다
+// usage: SessionLookupBenchmark [sessions=10000] [lookups_per_thread=2000000] [lookup_threads=4]
+
+namespace
+{
+    struct MapAdapter
+    {
+        static constexpr const char* NAME = "map + shared_mutex find";
+
+        std::shared_ptr<ClientSession> lookup(int id)
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = sessions.find(id);
+            return it == sessions.end() ? nullptr : it->second;
+        }
+
+        std::map<unsigned int, std::shared_ptr<ClientSession>> sessions;
+        std::shared_mutex mutex;
+    };
+
+    struct RegistryAdapter
+    {
+        static constexpr const char* NAME = "SessionRegistry::find";
+
+        std::shared_ptr<ClientSession> lookup(int id) { return registry->find(id); }
+
+        SessionRegistry* registry = nullptr;
+    };
+
+    template<typename Lookup>
+    double run(const std::vector<int>& ids, int lookups_per_thread, int thread_count, Lookup&& lookup)
+    {
+        std::atomic<long long> found_count{ 0 };
+        const auto start_time = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                std::mt19937 random(t + 1);
+                std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+                long long found = 0;
+                for (int i = 0; i < lookups_per_thread; ++i)
+                    found += lookup(ids[pick(random)]) ? 1 : 0;
+                found_count.fetch_add(found);
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        if (found_count.load() != static_cast<long long>(lookups_per_thread) * thread_count)
+            std::cout << "  missing lookups: " << static_cast<long long>(lookups_per_thread) * thread_count - found_count.load() << std::endl;
+        return lookups_per_thread * static_cast<double>(thread_count) / seconds;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int session_count = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int lookups_per_thread = argc > 2 ? std::atoi(argv[2]) : 2000000;
+    const int thread_count = argc > 3 ? std::atoi(argv[3]) : 4;
+
+    MapAdapter map;
+    SessionRegistry registry;
+    std::vector<int> map_ids;
+    std::vector<int> registry_ids;
+    std::vector<std::weak_ptr<ClientSession>> weak_sessions;
+    for (int i = 0; i < session_count; ++i)
+    {
+        std::shared_ptr<ClientSession> session = std::make_shared<ClientSession>();
+        map_ids.push_back(i + 1);
+        map.sessions.emplace(i + 1, session);
+        registry_ids.push_back(registry.add(session));
+        weak_sessions.push_back(session);
+    }
+
+    // 칸을 다시 쓴 뒤의 옛 id는 찾히지 않아야 한다
+    const int stale_id = registry_ids.front();
+    std::shared_ptr<ClientSession> removed = registry.remove(stale_id);
+    registry_ids.front() = registry.add(removed);
+    const bool is_stale_rejected = false == registry.is_alive(stale_id) && nullptr == registry.find(stale_id)
+                                   && SessionRegistry::get_index(stale_id) == SessionRegistry::get_index(registry_ids.front());
+
+    RegistryAdapter registry_adapter;
+    registry_adapter.registry = &registry;
+
+    std::cout << "=== Session Lookup Benchmark ===" << std::endl;
+    std::cout << "sessions: " << session_count << ", lookup threads: " << thread_count << ", lookups per thread: " << lookups_per_thread << std::endl;
+    std::cout << "stale id rejected: " << (is_stale_rejected ? "yes" : "NO") << std::endl;
+
+    std::cout << MapAdapter::NAME << ": " << static_cast<long long>(run(map_ids, lookups_per_thread, thread_count, [&](int id) { return nullptr != map.lookup(id); })) << " /s" << std::endl;
+    std::cout << RegistryAdapter::NAME << ": " << static_cast<long long>(run(registry_ids, lookups_per_thread, thread_count, [&](int id) { return nullptr != registry_adapter.lookup(id); })) << " /s" << std::endl;
+
+    // 패킷마다 세션이 살아 있는지 보던 방식과 비교 (weak_ptr는 id 대신 배열 위치로 고른다)
+    std::vector<int> positions(session_count);
+    std::iota(positions.begin(), positions.end(), 0);
+    std::cout << "weak_ptr::lock: " << static_cast<long long>(run(positions, lookups_per_thread, thread_count, [&](int position) { return nullptr != weak_sessions[position].lock(); })) << " /s" << std::endl;
+    std::cout << "SessionRegistry::is_alive: " << static_cast<long long>(run(registry_ids, lookups_per_thread, thread_count, [&](int id) { return registry.is_alive(id); })) << " /s" << std::endl;
+
+    std::cout.flush();
+    std::_Exit(0);
+}
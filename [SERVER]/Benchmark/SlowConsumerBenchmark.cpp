@@ -0,0 +1,254 @@
+#include "pch.h"
+#include <iomanip>
+
+// 느린 클라이언트 벤치마크
+// 서버가 1ms마다 모든 세션에 패킷을 보내는 동안, 클라이언트 하나는 받기를 멈추고(stalled) 나머지는 계속 받는다
+// 보내는 패킷: S2C_TestEcho(RELIABLE, 순번), S2C_AccountLogin(CONFLATE, 1KB, 위치 갱신처럼 마지막 것만 의미 있음), S2C_AccountRegister(DROPPABLE)
+// 멈춘 클라이언트 세션의 send 큐 깊이가 제한 안에 머무는지, 언제 느린 클라이언트로 끊기는지, 계속 받는 클라이언트는 빠짐없이 순서대로 받는지 본다
+// bounded=0이면 큐 제한과 느린 클라이언트 끊기를 끄고 예전처럼 큐가 얼마나 자라는지 본다
+// usage: SlowConsumerBenchmark [seconds=5] [healthy_clients=8] [packets_per_ms=16] [disconnect_ms=2000] [port=8010] [bounded=1]
+
+namespace
+{
+    std::mutex g_sessions_mutex;
+    std::vector<std::shared_ptr<Session>> g_sessions;
+    std::string g_payload;
+
+    class ProducerClientSession : public ClientSession
+    {
+    public:
+        void on_connected() override
+        {
+            std::lock_guard<std::mutex> lock(g_sessions_mutex);
+            g_sessions.push_back(shared_from_this());
+        }
+
+        void on_disconnected() override
+        {
+            ClientSession::on_disconnected();
+
+            std::lock_guard<std::mutex> lock(g_sessions_mutex);
+            g_sessions.erase(std::remove(g_sessions.begin(), g_sessions.end(), shared_from_this()), g_sessions.end());
+        }
+    };
+
+    SOCKET connect_client(int port, int recv_buffer_size)
+    {
+        SOCKET socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (0 < recv_buffer_size)
+            ::setsockopt(socket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&recv_buffer_size), sizeof(recv_buffer_size));
+
+        sockaddr_in server_addr{};
+        server_addr.sin_family = AF_INET;
+        inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
+        server_addr.sin_port = htons(port);
+        if (SOCKET_ERROR == ::connect(socket, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)))
+        {
+            std::cout << "connect failed" << std::endl;
+            std::quick_exit(1);
+        }
+        return socket;
+    }
+
+    int get_local_port(SOCKET socket)
+    {
+        sockaddr_in local_addr{};
+        socklen_t addr_length = sizeof(local_addr);
+        ::getsockname(socket, reinterpret_cast<sockaddr*>(&local_addr), &addr_length);
+        return ntohs(local_addr.sin_port);
+    }
+
+    struct HealthyResult
+    {
+        long long received_count = 0;
+        long long echo_count = 0;
+        int order_error_count = 0;
+    };
+
+    // 받은 S2C_TestEcho의 순번이 빠짐없이 이어지는지 본다
+    void receive_all(SOCKET socket, const std::atomic<bool>& is_running, HealthyResult& result)
+    {
+        timeval recv_timeout{ 0, 100 * 1000 };
+        ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&recv_timeout), sizeof(recv_timeout));
+
+        std::vector<char> stream;
+        std::vector<char> buffer(64 * 1024);
+        int next_echo_number = 0;
+        while (is_running.load())
+        {
+            const int received = ::recv(socket, buffer.data(), static_cast<int>(buffer.size()), 0);
+            if (0 == received)
+                break;
+            if (0 > received)
+                continue;
+            stream.insert(stream.end(), buffer.data(), buffer.data() + received);
+
+            size_t offset = 0;
+            while (stream.size() - offset >= PACKET_HEADER_SIZEOF)
+            {
+                PacketHeader header;
+                ::memcpy(&header, stream.data() + offset, PACKET_HEADER_SIZEOF);
+                if (stream.size() - offset < header.packet_size)
+                    break;
+
+                if (packet_number::TestEcho == header.protocol_no)
+                {
+                    S2C_TestEcho message;
+                    message.ParseFromArray(stream.data() + offset + PACKET_HEADER_SIZEOF, header.packet_size - PACKET_HEADER_SIZEOF);
+                    if (message.rand_number() != next_echo_number)
+                        ++result.order_error_count;
+                    next_echo_number = message.rand_number() + 1;
+                    ++result.echo_count;
+                }
+                ++result.received_count;
+                offset += header.packet_size;
+            }
+            stream.erase(stream.begin(), stream.begin() + offset);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+    const int healthy_client_count = argc > 2 ? std::atoi(argv[2]) : 8;
+    const int packets_per_ms = argc > 3 ? std::max(1, std::atoi(argv[3])) : 16;
+    slow_consumer_disconnect_ms = argc > 4 ? std::atoi(argv[4]) : 2000;
+    const int port = argc > 5 ? std::atoi(argv[5]) : 8010;
+    const bool is_bounded = argc > 6 ? 0 != std::atoi(argv[6]) : true;
+    if (false == is_bounded)
+    {
+        send_queue_max_bytes = INT_MAX;
+        send_queue_max_packets = INT_MAX;
+        slow_consumer_disconnect_ms = 0;
+    }
+
+    MultiSender::set_send_policy(packet_number::TestEcho, SendPolicy::RELIABLE);
+    MultiSender::set_send_policy(packet_number::AccountLogin, SendPolicy::CONFLATE);
+    MultiSender::set_send_policy(packet_number::AccountRegister, SendPolicy::DROPPABLE);
+    g_payload.assign(1024, 'x');
+
+    // 스레드를 멈추는 경로가 없으므로 서비스는 종료 시까지 살려둔다
+    ServerBase* server = xnew ServerBase;
+    server->init(1, 0, [](){ return xmake_shared(NetworkSection); }, 1);
+    server->open("127.0.0.1", port, [](){ return xnew ProducerClientSession; });
+
+    // 받기를 멈춘 클라이언트는 커널 버퍼도 작게 잡아 금방 막히게 한다
+    SOCKET stalled_socket = connect_client(port, 4096);
+    const int stalled_port = get_local_port(stalled_socket);
+    std::vector<SOCKET> healthy_sockets;
+    for (int i = 0; i < healthy_client_count; ++i)
+        healthy_sockets.push_back(connect_client(port, 0));
+
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_sessions_mutex);
+            if (static_cast<int>(g_sessions.size()) == healthy_client_count + 1)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::shared_ptr<Session> stalled_session;
+    {
+        std::lock_guard<std::mutex> lock(g_sessions_mutex);
+        for (std::shared_ptr<Session>& session : g_sessions)
+        {
+            if (session->get_remote_port() == stalled_port)
+                stalled_session = session;
+        }
+    }
+
+    std::atomic<bool> is_running{ true };
+    std::vector<HealthyResult> healthy_results(healthy_client_count);
+    std::vector<std::thread> receive_threads;
+    for (int i = 0; i < healthy_client_count; ++i)
+        receive_threads.emplace_back([&, i]() { receive_all(healthy_sockets[i], is_running, healthy_results[i]); });
+
+    // 1ms마다 세션마다 RELIABLE 하나와 CONFLATE / DROPPABLE을 반씩 보낸다
+    long long sent_per_session = 0;
+    long long peak_stalled_queued_bytes = 0;
+    int peak_stalled_queued_packets = 0;
+    double stalled_disconnect_ms = -1;
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto end_time = start_time + std::chrono::seconds(seconds);
+    int echo_number = 0;
+    while (std::chrono::steady_clock::now() < end_time)
+    {
+        std::vector<std::shared_ptr<Session>> sessions;
+        {
+            std::lock_guard<std::mutex> lock(g_sessions_mutex);
+            sessions = g_sessions;
+        }
+
+        S2C_TestEcho echo_message;
+        echo_message.set_rand_number(echo_number++);
+        std::shared_ptr<Packet> echo_packet = Packet::create(echo_message);
+        std::vector<std::shared_ptr<Packet>> packets{ echo_packet };
+        for (int i = 1; i < packets_per_ms; ++i)
+        {
+            if (0 == i % 2)
+            {
+                S2C_AccountLogin login_message;
+                login_message.set_game_server_ip(g_payload);
+                login_message.set_game_server_port(echo_number * packets_per_ms + i);
+                packets.push_back(Packet::create(login_message));
+            }
+            else
+            {
+                S2C_AccountRegister register_message;
+                register_message.set_result_code(i);
+                packets.push_back(Packet::create(register_message));
+            }
+        }
+
+        for (std::shared_ptr<Session>& session : sessions)
+        {
+            for (std::shared_ptr<Packet>& packet : packets)
+                session->do_send(packet);
+        }
+        sent_per_session += packets_per_ms;
+
+        const MultiSender& stalled_sender = stalled_session->get_multi_sender();
+        peak_stalled_queued_bytes = std::max(peak_stalled_queued_bytes, stalled_sender.get_queued_bytes());
+        peak_stalled_queued_packets = std::max(peak_stalled_queued_packets, stalled_sender.get_queued_packet_count());
+        if (0 > stalled_disconnect_ms && false == stalled_session->is_connected())
+            stalled_disconnect_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 남은 패킷이 도착할 시간을 준다
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    is_running.store(false);
+    for (std::thread& thread : receive_threads)
+        thread.join();
+
+    long long healthy_received_count = 0;
+    long long min_echo_count = LLONG_MAX;
+    int healthy_order_error_count = 0;
+    for (HealthyResult& result : healthy_results)
+    {
+        healthy_received_count += result.received_count;
+        min_echo_count = std::min(min_echo_count, result.echo_count);
+        healthy_order_error_count += result.order_error_count;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "=== Slow Consumer Benchmark ===" << std::endl;
+    std::cout << (is_bounded ? "bounded" : "unbounded") << " send queue (max " << send_queue_max_bytes / 1024 << " KB / " << send_queue_max_packets << " packets, high watermark "
+              << send_queue_high_watermark_bytes / 1024 << " KB, disconnect after " << slow_consumer_disconnect_ms << " ms), " << healthy_client_count << " healthy clients + 1 stalled, "
+              << packets_per_ms << " packets/ms per session for " << seconds << " s" << std::endl;
+    std::cout << "stalled session peak queue: " << peak_stalled_queued_bytes / 1024 << " KB / " << peak_stalled_queued_packets << " packets, "
+              << (0 > stalled_disconnect_ms ? std::string("never disconnected") : "disconnected as slow consumer at " + std::to_string(static_cast<long long>(stalled_disconnect_ms)) + " ms") << std::endl;
+    std::cout << "healthy clients: " << healthy_received_count << " packets received (" << sent_per_session * healthy_client_count << " sent), echo min " << min_echo_count
+              << " of " << echo_number << ", echo order errors " << healthy_order_error_count << std::endl;
+    std::cout << "dropped: " << MultiSender::get_dropped_packet_count() << ", conflated: " << MultiSender::get_conflated_packet_count()
+              << ", slow consumers: " << MultiSender::get_slow_consumer_count() << ", partial sends: " << MultiSender::get_partial_send_count()
+              << ", packet buffer outstanding: " << PacketBufferPool::get_instance().get_outstanding_bytes() / 1024 << " KB" << std::endl;
+    std::cout.flush();
+
+    closesocket(stalled_socket);
+    std::quick_exit(0);
+}
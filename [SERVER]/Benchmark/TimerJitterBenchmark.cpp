@@ -0,0 +1,88 @@
+#include "pch.h"
+#include <random>
+
+// 섹션 타이머 지터 벤치마크
+// 다른 스레드에서 지연 시간이 제각각인 task를 섹션에 넣고, 정해진 실행 시각보다 얼마나 늦게 실행됐는지의 분포를 본다
+// 실행되지 않을 먼 미래의 task(idle_timers)를 함께 쌓아두어 대기 중인 타이머가 많을 때의 비용도 반영한다
+// usage: TimerJitterBenchmark [seconds=5] [timers_per_sec=2000] [max_delay_ms=50] [idle_timers=10000]
+
+namespace
+{
+    class JitterServer : public ServerBase
+    {
+    public:
+        std::shared_ptr<NetworkSection> get_section() { return m_sections.begin()->second; }
+    };
+
+    // 섹션 스레드에서만 쓴다
+    std::vector<long long> g_lateness_us;
+    std::atomic<int> g_executed_count{ 0 };
+
+    long long percentile(const std::vector<long long>& sorted, double ratio)
+    {
+        if (sorted.empty())
+            return 0;
+        const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(ratio * sorted.size()));
+        return sorted[index];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+    const int timers_per_sec = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const int max_delay_ms = argc > 3 ? std::atoi(argv[3]) : 50;
+    const int idle_timers = argc > 4 ? std::atoi(argv[4]) : 10000;
+
+    JitterServer server;
+    // 섹션 타이머만 재므로 하드 task 스레드는 띄우지 않는다
+    server.init(1, 0, [](){ return std::make_shared<NetworkSection>(); }, 1);
+    std::shared_ptr<NetworkSection> section = server.get_section();
+
+    for (int i = 0; i < idle_timers; ++i)
+    {
+        iTask* task = xnew iTask;
+        task->delay_time = 3600 * 1000;
+        task->func = [](){};
+        section->push_task(task);
+    }
+
+    const int total = seconds * timers_per_sec;
+    g_lateness_us.reserve(total);
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> delay_ms(1, max_delay_ms);
+    const auto interval = std::chrono::nanoseconds(1000000000LL / timers_per_sec);
+    auto next_push_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < total; ++i)
+    {
+        std::this_thread::sleep_until(next_push_time);
+        next_push_time += interval;
+
+        iTask* task = xnew iTask;
+        task->delay_time = delay_ms(random);
+        task->func = [task]()
+        {
+            const auto lateness = std::chrono::steady_clock::now() - task->execute_time;
+            g_lateness_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(lateness).count());
+            g_executed_count.fetch_add(1, std::memory_order_release);
+        };
+        section->push_task(task);
+    }
+
+    while (g_executed_count.load(std::memory_order_acquire) < total)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::vector<long long> sorted = g_lateness_us;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::cout << "=== Timer Jitter Benchmark ===" << std::endl;
+    std::cout << "timers: " << total << " (" << timers_per_sec << "/s, delay 1~" << max_delay_ms << " ms), idle timers: " << idle_timers << std::endl;
+    std::cout << "lateness us p50: " << percentile(sorted, 0.5)
+              << ", p90: " << percentile(sorted, 0.9)
+              << ", p99: " << percentile(sorted, 0.99)
+              << ", p99.9: " << percentile(sorted, 0.999)
+              << ", max: " << (sorted.empty() ? 0 : sorted.back()) << std::endl;
+
+    std::_Exit(0);
+}
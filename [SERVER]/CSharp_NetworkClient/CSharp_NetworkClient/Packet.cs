@@ -1,6 +1,7 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.IO;
+using System.IO.Compression;
 using System.Linq;
 using System.Net.Http;
 using System.Threading;
@@ -22,29 +23,75 @@ namespace CSharp_NetworkClient
         PACKET_SIZE_VALUE_START_IDX = 0,
         PACKET_PROTOCOL_VALUE_START_IDX = PACKET_SIZE_VALUE_SIZEOF,
         PACKET_DATA_START_IDX = PACKET_HEADER_VALUE_SIZEOF,
+        PACKET_COMPRESSED_SIZE_VALUE_SIZEOF = sizeof(ushort),
     }
 
     public class Packet
     {
+        // 서버(PacketCompressor)가 압축한 패킷은 protocol에 이 비트가 있고, 본문은 [원래 본문 크기(ushort)][deflate 데이터]이다
+        public const ushort PACKET_COMPRESSED_FLAG = 0x8000;
+
         private StreamBuffer? m_data;
         private int m_pos;
         
         public ArraySegment<byte> Data => new ArraySegment<byte>(m_data.GetWriteSpan().ToArray(), 0, m_pos);
         public ushort Size => BitConverter.ToUInt16(m_data.GetWriteSpan().Slice(Convert.ToInt32(PacketDefine.PACKET_SIZE_VALUE_START_IDX), Convert.ToInt32(PacketDefine.PACKET_SIZE_VALUE_SIZEOF)));
-        public ushort Protocol => BitConverter.ToUInt16(m_data.GetWriteSpan().Slice(Convert.ToInt32(PacketDefine.PACKET_PROTOCOL_VALUE_START_IDX), Convert.ToInt32(PacketDefine.PACKET_PROTOCOL_VALUE_SIZEOF)));
+        public ushort Protocol => (ushort)(BitConverter.ToUInt16(m_data.GetWriteSpan().Slice(Convert.ToInt32(PacketDefine.PACKET_PROTOCOL_VALUE_START_IDX), Convert.ToInt32(PacketDefine.PACKET_PROTOCOL_VALUE_SIZEOF))) & ~PACKET_COMPRESSED_FLAG);
 
         public Packet()
         {
             m_data = PacketBufferManager.GetBuffer();
         }
         
+        // 압축된 패킷이 깨져 있으면 InvalidDataException을 던진다 (Session.OnRecv가 받아 연결을 끊는다)
         public Packet(ArraySegment<byte> packet_buffer)
         {
             m_data = PacketBufferManager.GetBuffer();
             m_data.Reset();
+
+            // 압축된 패킷은 여기서 풀어 핸들러에는 원래 패킷으로 넘긴다
+            ushort protocol_no = BitConverter.ToUInt16(packet_buffer.Array, packet_buffer.Offset + Convert.ToInt32(PacketDefine.PACKET_PROTOCOL_VALUE_START_IDX));
+            if (0 != (protocol_no & PACKET_COMPRESSED_FLAG))
+            {
+                Decompress(packet_buffer, (ushort)(protocol_no & ~PACKET_COMPRESSED_FLAG));
+                return;
+            }
             
             packet_buffer.CopyTo(m_data.GetWriteSegment());
         }
+
+        private void Decompress(ArraySegment<byte> packet_buffer, ushort protocol_no)
+        {
+            int header_size = Convert.ToInt32(PacketDefine.PACKET_HEADER_VALUE_SIZEOF);
+            int compressed_size_sizeof = Convert.ToInt32(PacketDefine.PACKET_COMPRESSED_SIZE_VALUE_SIZEOF);
+            int compressed_start = header_size + compressed_size_sizeof;
+            if (packet_buffer.Count < compressed_start)
+                throw new InvalidDataException($"compressed packet is too short => protocol: {protocol_no}");
+
+            ushort raw_body_size = BitConverter.ToUInt16(packet_buffer.Array, packet_buffer.Offset + header_size);
+            if (header_size + raw_body_size > m_data.GetWriteSpan().Length)
+                throw new InvalidDataException($"compressed packet is too large => protocol: {protocol_no}, size: {raw_body_size}");
+
+            Span<byte> body = m_data.GetWriteSpan().Slice(header_size, raw_body_size);
+            using (MemoryStream compressed = new MemoryStream(packet_buffer.Array, packet_buffer.Offset + compressed_start, packet_buffer.Count - compressed_start))
+            using (DeflateStream deflate = new DeflateStream(compressed, CompressionMode.Decompress))
+            {
+                int read_size = 0;
+                while (read_size < raw_body_size)
+                {
+                    int size = deflate.Read(body.Slice(read_size));
+                    if (0 == size)
+                        break;
+                    read_size += size;
+                }
+
+                if (read_size != raw_body_size)
+                    throw new InvalidDataException($"compressed packet is broken => protocol: {protocol_no}");
+            }
+
+            BitConverter.TryWriteBytes(m_data.GetWriteSpan().Slice(Convert.ToInt32(PacketDefine.PACKET_SIZE_VALUE_START_IDX), Convert.ToInt32(PacketDefine.PACKET_SIZE_VALUE_SIZEOF)), Convert.ToUInt16(header_size + raw_body_size));
+            BitConverter.TryWriteBytes(m_data.GetWriteSpan().Slice(Convert.ToInt32(PacketDefine.PACKET_PROTOCOL_VALUE_START_IDX), Convert.ToInt32(PacketDefine.PACKET_PROTOCOL_VALUE_SIZEOF)), protocol_no);
+        }
         
         ~Packet()
         {
@@ -57,6 +57,8 @@ namespace CSharp_NetworkClient
                 }
 
                 int process_data_len = m_session.OnRecv(m_recv_buffer.GetReadSegment());
+                if (0 > process_data_len)
+                    return;
 
                 if (false == m_recv_buffer.OnRead(process_data_len))
                 {
@@ -66,6 +66,22 @@ namespace CSharp_NetworkClient
             DoSend(p);
         }
 
+        public void Disconnect()
+        {
+            if (0 != Interlocked.Exchange(ref m_is_disconnected, 1))
+                return;
+
+            try
+            {
+                m_socket?.Shutdown(SocketShutdown.Both);
+            }
+            catch (SocketException) { }
+            m_socket?.Close();
+
+            OnDisconnected();
+        }
+
+        // 처리한 바이트 수. 깨진 패킷을 받아 연결을 끊었으면 -1
         public int OnRecv(ArraySegment<byte> recv_datas)
         {
             int process_len = 0;
@@ -79,7 +95,18 @@ namespace CSharp_NetworkClient
                 if (packet_size > recv_datas.Count)
                     break;
 
-                Packet packet = new Packet(new ArraySegment<byte>(recv_datas.Array, recv_datas.Offset, packet_size));
+                Packet packet;
+                try
+                {
+                    packet = new Packet(new ArraySegment<byte>(recv_datas.Array, recv_datas.Offset, packet_size));
+                }
+                catch (InvalidDataException exception)
+                {
+                    // 압축된 본문이 깨지면 뒤의 스트림도 믿을 수 없으므로 끊는다
+                    Console.WriteLine($"broken packet received, disconnect => {exception.Message}");
+                    Disconnect();
+                    return -1;
+                }
 
                 OnPacketAssambled(packet);
                 process_len += packet_size;
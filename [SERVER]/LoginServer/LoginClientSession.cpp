@@ -11,9 +11,7 @@ void LoginClientSession::init()
 
 void LoginClientSession::init_handlers()
 {
-    m_handlers.emplace(packet_number::TestEcho, [this](auto* p){this->test_echo_handler(p); });
-    m_handlers.emplace(packet_number::AccountRegister, [this](auto* p){this->account_register_handler(p); });
-    m_handlers.emplace(packet_number::AccountLogin, [this](auto* p){this->account_login_handler(p); });
+    PacketDispatcher::bind_c2s(this);
 }
 
 void LoginClientSession::finalize()
@@ -36,11 +34,8 @@ void LoginClientSession::on_disconnected()
     ClientSession::on_disconnected();
 }
 
-void LoginClientSession::test_echo_handler(Packet* packet)
+void LoginClientSession::on_packet(C2S_TestEcho& recv_message_from_client)
 {
-    C2S_TestEcho recv_message_from_client;
-    packet->pop_message(recv_message_from_client);
-
     std::cout << "Recv Echo: " << recv_message_from_client.rand_number() << std::endl;
 
     S2C_TestEcho send_message_to_client;
@@ -54,11 +49,8 @@ void LoginClientSession::test_echo_handler(Packet* packet)
     }
 }
 
-void LoginClientSession::account_register_handler(Packet* packet)
+void LoginClientSession::on_packet(C2S_AccountRegister& recv_message_from_client)
 {
-    C2S_AccountRegister recv_message_from_client;
-    packet->pop_message(recv_message_from_client);
-
 
     auto db_context = DB::create_async_context(
         [weak_self = weak_from_this()](DB::QueryResult& result)
@@ -97,6 +89,7 @@ void LoginClientSession::account_register_handler(Packet* packet)
     auto task = xnew iTask;
     task->func = [db_context, user_id = recv_message_from_client.id(), password = recv_message_from_client.password()]() {
         try {
+            HardTaskPool::BlockingScope blocking;
             auto result = DB_INSTANCE().execute_query("CALL register_account('" + user_id + "','" + password + "');");
             
             db_context->deliver_success(result);
@@ -108,11 +101,8 @@ void LoginClientSession::account_register_handler(Packet* packet)
     get_server_base()->push_hard_task(task);
 }
 
-void LoginClientSession::account_login_handler(Packet* packet)
+void LoginClientSession::on_packet(C2S_AccountLogin& recv_message_from_client)
 {
-    C2S_AccountLogin recv_message_from_client;
-    packet->pop_message(recv_message_from_client);
-
     LoginServerService* service = static_cast<LoginServerService*>(get_server_base());
     if (nullptr == service)
     {
@@ -153,6 +143,7 @@ void LoginClientSession::account_login_handler(Packet* packet)
     auto task = xnew iTask;
     task->func = [db_context, user_id = recv_message_from_client.id(), password = recv_message_from_client.password()]() {
         try {
+            HardTaskPool::BlockingScope blocking;
             auto result = DB_INSTANCE().execute_query(
                 "SELECT id FROM account WHERE id = '"+ user_id + "' AND password = '" + password + "'");
             
@@ -162,5 +153,5 @@ void LoginClientSession::account_login_handler(Packet* packet)
         }
     };
     
-    get_server_base()->push_hard_task(task);
+    get_server_base()->push_hard_task(task, HardTaskPriority::INTERACTIVE);
 }
@@ -2,6 +2,7 @@
 
 class LoginClientSession : public ClientSession
 {
+    friend class PacketDispatcher;
 public:
     LoginClientSession() = default;
     ~LoginClientSession() override = default;
@@ -16,8 +17,8 @@ public:
     void on_disconnected() override;
 
 private:
-    void test_echo_handler(Packet* packet);
-    void account_register_handler(Packet* packet);
-    void account_login_handler(Packet* packet);
+    void on_packet(C2S_TestEcho& recv_message_from_client);
+    void on_packet(C2S_AccountRegister& recv_message_from_client);
+    void on_packet(C2S_AccountLogin& recv_message_from_client);
     
 };
\ No newline at end of file
@@ -3,15 +3,12 @@
 #include <DatabaseManager.h>
 
 void LoginServerService::init(int iocp_thread_count, int hard_task_thread_count, std::function<std::shared_ptr<NetworkSection>()> section_factory,
-                              int section_count)
+                              int section_count, IoEngineType io_engine_type)
 {
-    ServerBase::init(iocp_thread_count, hard_task_thread_count, section_factory, section_count);
+    ServerBase::init(iocp_thread_count, hard_task_thread_count, section_factory, section_count, io_engine_type);
     DB_INITIALIZE_FROM_JSON("db_config.json");
+    // 하드 task는 대부분 DB 호출이므로 커넥션 수보다 워커를 늘려봐야 acquire_connection에서 기다리기만 한다
+    get_hard_task_pool().set_max_thread_count(static_cast<int>(DB_INSTANCE().get_config().pool_max_size));
     server_config = LoginServerConfig::from_json_file("login_server_config.json");
 
 }
-
-std::shared_ptr<NetworkSection> LoginServerService::select_first_section()
-{
-    return m_sections.begin()->second;
-}
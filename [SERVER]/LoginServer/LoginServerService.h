@@ -11,10 +11,7 @@ public:
     LoginServerConfig& get_config() {return server_config;}
     
 public:
-    void init(int iocp_thread_count, int hard_task_thread_count, std::function<std::shared_ptr<NetworkSection>()> section_factory, int section_count) override;
-
-protected:
-    std::shared_ptr<NetworkSection> select_first_section() override;
+    void init(int iocp_thread_count, int hard_task_thread_count, std::function<std::shared_ptr<NetworkSection>()> section_factory, int section_count, IoEngineType io_engine_type = IoEngineType::DEFAULT) override;
 
 private:
     LoginServerConfig server_config;
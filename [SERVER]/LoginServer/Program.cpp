@@ -7,7 +7,7 @@ int main()
 {
     LoginServerService service;
     service.init(1, 1, [](){ return xmake_shared(NetworkSection); }, 1);
-    service.open(service.get_config().login_server_ip, service.get_config().login_server_port, []() { return xmake_shared(LoginClientSession); });
+    service.open(service.get_config().login_server_ip, service.get_config().login_server_port, []() { return xnew LoginClientSession; });
 
     while (true) {}
 }
\ No newline at end of file
@@ -3,4 +3,4 @@
 
 #define xdelete delete
 
-#define xmake_shared(T, ...) std::make_shared<T>(__VA_ARGS__)
+#define xmake_shared(T, ...) PacketBufferPool::make_shared<T>(__VA_ARGS__)
@@ -3,9 +3,9 @@
 
 #include "ServerSession.h"
 
-void ClientBase::init(int iocp_thread_count)
+void ClientBase::init(int iocp_thread_count, IoEngineType io_engine_type)
 {
-    NetworkCore::init(iocp_thread_count);
+    NetworkCore::init(iocp_thread_count, io_engine_type);
     m_job_thread = std::thread(&ClientBase::job_thread_work, this); 
 }
 
@@ -7,7 +7,7 @@ public:
     virtual ~ClientBase() = default;
 
 public:
-    void init(int iocp_thread_count = 1) override;
+    void init(int iocp_thread_count = 1, IoEngineType io_engine_type = IoEngineType::DEFAULT) override;
 public:
     void open(std::string connecting_ip, int connecting_port, std::function<class ServerSession*()> session_factory, int
               session_count = 1);
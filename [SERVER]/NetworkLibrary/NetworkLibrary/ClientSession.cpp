@@ -5,9 +5,48 @@ void ClientSession::init_handlers()
 {
 }
 
+void ClientSession::finalize()
+{
+    // 풀에서 다시 꺼냈을 때 지난 연결의 섹션이 남아 있지 않게 한다
+    set_section(nullptr);
+    m_section_index = -1;
+    m_arriving_section.store(nullptr, std::memory_order_relaxed);
+    m_dispatch_section.reset();
+
+    Session::finalize();
+}
+
+void ClientSession::close_socket()
+{
+#ifdef _WIN32
+    // DisconnectEx(TF_REUSE_SOCKET)로 끊었으므로 다음 AcceptEx에 다시 쓸 수 있다
+    // 풀에 넣으면 바로 다른 연결이 쓰므로, 먼저 세션에서 떼어 finalize 전까지 이 세션이 쓰지 못하게 한다
+    if (nullptr != m_session_pool)
+    {
+        const SOCKET socket = m_connecting_socket;
+        m_connecting_socket = INVALID_SOCKET;
+        m_session_pool->push_socket(socket);
+        return;
+    }
+#endif
+    Session::close_socket();
+}
+
+std::shared_ptr<NetworkSection> ClientSession::get_section()
+{
+    std::lock_guard<std::mutex> lock(m_section_mutex);
+    return m_section.lock();
+}
+
+void ClientSession::set_section(std::shared_ptr<NetworkSection> section)
+{
+    std::lock_guard<std::mutex> lock(m_section_mutex);
+    m_section = section;
+}
+
 NetworkCore* ClientSession::get_network_core()
 {
-    auto section = m_section.lock();
+    auto section = get_section();
     if (nullptr == section)
         return nullptr;
     
@@ -16,7 +55,7 @@ NetworkCore* ClientSession::get_network_core()
 
 ServerBase* ClientSession::get_server_base()
 {
-    auto section = m_section.lock();
+    auto section = get_section();
     if (nullptr == section)
         return nullptr;
     
@@ -29,7 +68,12 @@ void ClientSession::on_connected()
 
 int ClientSession::on_recieve()
 {
-    return Session::on_recieve();
+    // 이 recv에서 나온 패킷은 모두 같은 섹션으로 넘긴다
+    std::lock_guard<std::mutex> lock(m_dispatch_mutex);
+    m_dispatch_section = get_section();
+    const int process_byte_size = Session::on_recieve();
+    m_dispatch_section.reset();
+    return process_byte_size;
 }
 
 void ClientSession::on_send(int data_size)
@@ -39,10 +83,26 @@ void ClientSession::on_send(int data_size)
 void ClientSession::on_disconnected()
 {
     Session::on_disconnected();
-    auto section = m_section.lock();
+
+    // 섹션을 옮기는 중이면 옮겨갈 섹션에서 나간다 (도착할 때 id가 무효면 들어가지 않는다)
+    std::lock_guard<std::mutex> lock(m_dispatch_mutex);
+    auto section = get_section();
     if (nullptr != section)
-        section->exit_section(get_id());
-    m_section.reset();
+    {
+        // id를 먼저 무효로 만들어, 섹션에 남은 이 세션의 패킷은 실행하지 않고 버리게 한다
+        static_cast<ServerBase*>(section->get_network_core())->get_session_registry().remove(get_id());
+        section->exit_section(std::static_pointer_cast<ClientSession>(shared_from_this()));
+    }
+    set_section(nullptr);
+}
+
+bool ClientSession::dispatch_packet(Packet* packet)
+{
+    if (nullptr == m_dispatch_section)
+        return false;
+
+    m_dispatch_section->push_packet(packet);
+    return true;
 }
 
 void ClientSession::execute_packet(Packet* packet)
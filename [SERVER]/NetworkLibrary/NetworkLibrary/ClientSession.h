@@ -8,9 +8,23 @@ public:
 
 public:
     void init_handlers() override;
+    void finalize() override;
+    void close_socket() override;
+    // ServerBase가 SessionPool에서 꺼내 줄 때 정한다 (윈도우에서 끊은 소켓을 돌려줄 곳)
+    void set_session_pool(class SessionPool* session_pool) { m_session_pool = session_pool; }
 public:
-    std::shared_ptr<NetworkSection> get_section() override { return m_section.lock(); }
-    void set_section(std::shared_ptr<NetworkSection> section) { m_section = section; }
+    std::shared_ptr<NetworkSection> get_section() override;
+    void set_section(std::shared_ptr<NetworkSection> section);
+    // 들어가 있는 섹션의 세션 배열에서의 위치 (섹션에 없으면 -1). 섹션이 세션 락을 잡고 바꾼다
+    int get_section_index() const { return m_section_index; }
+    void set_section_index(int index) { m_section_index = index; }
+
+    // NetworkSection::migrate_session으로 옮겨가는 중이면 도착할 섹션 (아니면 nullptr)
+    // 도착할 섹션은 그동안 받은 이 세션의 패킷을 실행하지 않고 들고 있다가, 떠난 섹션이 앞선 패킷을 다 실행하면 이어서 실행한다
+    NetworkSection* get_arriving_section() const { return m_arriving_section.load(std::memory_order_acquire); }
+    void set_arriving_section(NetworkSection* section) { m_arriving_section.store(section, std::memory_order_release); }
+    // recv에서 나온 패킷을 섹션으로 넘기는 동안 잡는다. 섹션을 옮기는 쪽도 잡으므로, 옮긴 뒤에는 떠난 섹션으로 가는 패킷이 없다
+    std::mutex& get_dispatch_mutex() { return m_dispatch_mutex; }
     
     NetworkCore* get_network_core() override;
     virtual ServerBase* get_server_base();
@@ -20,7 +34,17 @@ public:
     void on_send(int data_size) override;
     void on_disconnected() override;
     void execute_packet(Packet* packet) override;
+    // 받은 I/O 스레드에서 섹션의 패킷 큐로 바로 넘긴다
+    bool dispatch_packet(Packet* packet) override;
 
 protected:
     std::weak_ptr<NetworkSection> m_section;
+    mutable std::mutex m_section_mutex; // 섹션을 옮기면 다른 스레드에서 읽는 중에 바뀌므로 m_section만 지킨다
+    int m_section_index = -1;
+    std::atomic<NetworkSection*> m_arriving_section{ nullptr };
+
+    std::mutex m_dispatch_mutex;
+    std::shared_ptr<NetworkSection> m_dispatch_section; // on_recieve 동안 패킷을 넘길 섹션 (m_dispatch_mutex)
+
+    SessionPool* m_session_pool = nullptr;
 };
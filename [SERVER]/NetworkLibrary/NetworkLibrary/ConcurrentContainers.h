@@ -0,0 +1,94 @@
+#pragma once
+#include <mutex>
+#include <queue>
+#include <vector>
+#include <functional>
+
+// PPL(concurrent_queue.h, concurrent_priority_queue.h)이 없는 플랫폼용 대체 구현
+// 사용하는 인터페이스(push / try_pop / empty)만 동일하게 맞춘다
+namespace Concurrency
+{
+    template<typename T>
+    class concurrent_queue
+    {
+    public:
+        void push(const T& value)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push(value);
+        }
+
+        void push(T&& value)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push(std::move(value));
+        }
+
+        bool try_pop(T& out)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_queue.empty())
+                return false;
+
+            out = std::move(m_queue.front());
+            m_queue.pop();
+            return true;
+        }
+
+        bool empty() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_queue.empty();
+        }
+
+        size_t unsafe_size() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_queue.size();
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::queue<T> m_queue;
+    };
+
+    template<typename T, typename Compare = std::less<T>>
+    class concurrent_priority_queue
+    {
+    public:
+        void push(const T& value)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push(value);
+        }
+
+        bool try_pop(T& out)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_queue.empty())
+                return false;
+
+            out = m_queue.top();
+            m_queue.pop();
+            return true;
+        }
+
+        bool empty() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_queue.empty();
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_queue.size();
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::priority_queue<T, std::vector<T>, Compare> m_queue;
+    };
+}
+
+namespace concurrency = Concurrency;
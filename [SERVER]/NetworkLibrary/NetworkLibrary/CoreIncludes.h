@@ -1,17 +1,10 @@
 ﻿#pragma once
 
 #include <iostream>
-#include <WinSock2.h>
-#include <MSWSock.h>
-#include <ws2tcpip.h>
-#include <mswsock.h>
-#pragma comment(lib,"mswsock.lib")
-#pragma comment(lib, "ws2_32.lib")
+#include "Platform.h"
 
 #include <vector>
 #include <map>
-#include <concurrent_queue.h>
-#include <concurrent_priority_queue.h>
 #include <thread>
 #include <functional>
 #include <chrono>
@@ -25,10 +18,22 @@
 
 #include "config.h"
 #include "Base.h"
+#include "PacketBufferPool.h"
+#include "MpscQueue.h"
+#include "SpscQueue.h"
 #include "NetworkUtil.h"
 #include "Packet.h"
+#include "MessageArena.h"
 #include "iTask.h"
+#include "TimerWheel.h"
+#include "HardTaskPool.h"
+#include "PacketCompressor.h"
+#include "SessionRegistry.h"
+#include "SessionPool.h"
 #include "NetworkIO.h"
+#include "IoEngine.h"
+#include "EpollReactor.h"
+#include "IoUringEngine.h"
 #include "NetworkCore.h"
 #include "ServerBase.h"
 #include "ClientBase.h"
@@ -39,4 +44,5 @@
 #include "ServerSession.h"
 #include "Protocols.pb.h"
 #include "PacketNumberMapper.h"
+#include "PacketDispatcher.h"
 
@@ -0,0 +1,540 @@
+#include "pch.h"
+#include "EpollReactor.h"
+
+#ifndef _WIN32
+
+namespace
+{
+    constexpr int EPOLL_EVENT_BATCH = 128;
+    constexpr int SEND_IOV_MAX = 1024;
+    constexpr int ACCEPT_RETRY_DELAY_MS = 100;
+
+    long long get_steady_ms()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+EpollReactor::EpollReactor()
+    : m_epoll_fd(-1), m_event_fd(-1)
+{
+}
+
+EpollReactor::~EpollReactor()
+{
+    if (-1 != m_event_fd)
+        ::close(m_event_fd);
+    if (-1 != m_epoll_fd)
+        ::close(m_epoll_fd);
+}
+
+bool EpollReactor::init()
+{
+    m_epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == m_epoll_fd)
+    {
+        std::cout << "epoll_create1 error: " << errno << std::endl;
+        return false;
+    }
+
+    m_event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (-1 == m_event_fd)
+    {
+        std::cout << "eventfd error: " << errno << std::endl;
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = m_event_fd;
+    if (-1 == ::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_event_fd, &event))
+    {
+        std::cout << "epoll_ctl(eventfd) error: " << errno << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool EpollReactor::register_socket(SOCKET socket)
+{
+    SocketContext* context = m_contexts.get_or_create(socket);
+    if (nullptr == context)
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(context->lock);
+        context->is_disconnecting = false;
+        context->accept_ios.clear();
+        context->connect_io = nullptr;
+        context->recv_io = nullptr;
+        context->send_io = nullptr;
+    }
+    bind_socket(socket, this);
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = socket;
+
+    if (0 == ::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, socket, &event))
+        return true;
+
+    if (EEXIST == errno && 0 == ::epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, socket, &event))
+        return true;
+
+    std::cout << "epoll_ctl error: " << errno << std::endl;
+    return false;
+}
+
+bool EpollReactor::get_queued_completions(std::vector<IoCompletion>& completions, DWORD timeout_ms)
+{
+    epoll_event events[EPOLL_EVENT_BATCH];
+    const int event_count = ::epoll_wait(m_epoll_fd, events, EPOLL_EVENT_BATCH, get_wait_timeout(timeout_ms));
+    if (-1 == event_count)
+        return EINTR == errno;
+
+    retry_accepts(completions);
+
+    for (int i = 0; i < event_count; ++i)
+    {
+        if (events[i].data.fd == m_event_fd)
+        {
+            drain_posted_completions(completions);
+            continue;
+        }
+
+        on_socket_event(events[i].data.fd, events[i].events, completions);
+    }
+
+    return true;
+}
+
+void EpollReactor::post_completion(NetworkIO* io, int bytes_transferred)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_posted_lock);
+        m_posted_completions.push_back({ io, bytes_transferred });
+    }
+
+    const uint64_t wake = 1;
+    if (-1 == ::write(m_event_fd, &wake, sizeof(wake)))
+        std::cout << "eventfd write error: " << errno << std::endl;
+}
+
+bool EpollReactor::accept(SOCKET listen_socket, AcceptIO* io)
+{
+    SocketContext* context = m_contexts.find(listen_socket);
+    if (nullptr == context)
+    {
+        std::cout << "accept error: listen socket is not registered" << std::endl;
+        return false;
+    }
+
+    // accept4가 새 소켓을 만들어 주므로 AcceptEx용으로 미리 만들어 둔 소켓은 필요없다
+    if (INVALID_SOCKET != io->m_socket)
+    {
+        ::close(io->m_socket);
+        io->m_socket = INVALID_SOCKET;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (false == context->accept_ios.empty())
+    {
+        context->accept_ios.push_back(io);
+        return true;
+    }
+
+    const IoResult result = try_accept(listen_socket, io);
+    if (IoResult::COMPLETED != result)
+    {
+        context->accept_ios.push_back(io);
+        if (IoResult::RETRY_LATER == result)
+            schedule_accept_retry(listen_socket);
+        return true;
+    }
+    post_completion(io, 0);
+    return true;
+}
+
+bool EpollReactor::connect(SOCKET socket, ConnectIO* io, const sockaddr_in& addr, bool& is_not_pending)
+{
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+    {
+        std::cout << "connect error: socket is not registered" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (0 == ::connect(socket, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)))
+    {
+        is_not_pending = true;
+        return true;
+    }
+
+    if (EINPROGRESS != errno)
+    {
+        std::cout << "connect error: " << errno << std::endl;
+        return false;
+    }
+
+    context->connect_io = io;
+    return true;
+}
+
+bool EpollReactor::send(SOCKET socket, SendIO* io, bool& is_not_pending, DWORD& send_byte_size)
+{
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+    {
+        std::cout << "send error: socket is not registered" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (context->is_disconnecting)
+        return false;
+
+    switch (try_send(socket, io))
+    {
+    case IoResult::PENDING:
+        context->send_io = io;
+        return true;
+    case IoResult::COMPLETED:
+        is_not_pending = true;
+        send_byte_size = static_cast<DWORD>(io->InternalHigh);
+        post_completion(io, static_cast<int>(io->InternalHigh));
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool EpollReactor::receive(SOCKET socket, RecvIO* io)
+{
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+    {
+        std::cout << "recv error: socket is not registered" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (context->is_disconnecting)
+        return false;
+
+    int bytes_transferred = 0;
+    switch (try_receive(socket, io, bytes_transferred))
+    {
+    case IoResult::PENDING:
+        context->recv_io = io;
+        return true;
+    case IoResult::COMPLETED:
+        post_completion(io, bytes_transferred);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool EpollReactor::disconnect(SOCKET socket, DisconnectIO* io)
+{
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+        return false;
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (context->is_disconnecting)
+        return false;
+
+    // DisconnectEx와 같이 끊기 요청 이후에는 걸려있던 I/O의 완료를 돌려주지 않는다
+    // 걸려있던 send만 0 바이트 완료로 돌려주어, 보내는 동안 세션을 잡아둔 MultiSender가 놓게 한다
+    context->is_disconnecting = true;
+    context->connect_io = nullptr;
+    context->recv_io = nullptr;
+    if (nullptr != context->send_io)
+        post_completion(context->send_io, 0);
+    context->send_io = nullptr;
+
+    if (-1 == ::shutdown(socket, SHUT_RDWR) && ENOTCONN != errno)
+    {
+        std::cout << "disconnect error: " << errno << std::endl;
+        return false;
+    }
+
+    post_completion(io, 0);
+    return true;
+}
+
+EpollReactor::IoResult EpollReactor::try_accept(SOCKET listen_socket, AcceptIO* io)
+{
+    while (true)
+    {
+        sockaddr_in remote_addr{};
+        socklen_t addr_length = sizeof(remote_addr);
+
+        SOCKET socket = ::accept4(listen_socket, reinterpret_cast<sockaddr*>(&remote_addr), &addr_length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (INVALID_SOCKET != socket)
+        {
+            io->m_socket = socket;
+            ::memcpy(io->m_accept_buffer, &remote_addr, sizeof(remote_addr));
+            return IoResult::COMPLETED;
+        }
+
+        if (EINTR == errno || ECONNABORTED == errno)
+            continue;
+
+        // 대기 중인 연결이 큐에 남아 있어 다시 준비 이벤트가 오지 않는다
+        if (EMFILE == errno || ENFILE == errno || ENOBUFS == errno || ENOMEM == errno)
+            return IoResult::RETRY_LATER;
+
+        if (EAGAIN != errno && EWOULDBLOCK != errno)
+            std::cout << "accept error: " << errno << std::endl;
+
+        // 실패한 accept도 걸어둔 채로 다음 이벤트에서 다시 시도한다
+        return IoResult::PENDING;
+    }
+}
+
+EpollReactor::IoResult EpollReactor::try_connect(SOCKET socket)
+{
+    int error = 0;
+    socklen_t error_length = sizeof(error);
+    if (-1 == ::getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &error_length) || 0 != error)
+        return IoResult::FAILED;
+
+    // 연결 전 소켓도 EPOLLOUT이 올 수 있으므로 실제로 연결되었는지 확인한다
+    sockaddr_in peer_addr{};
+    socklen_t addr_length = sizeof(peer_addr);
+    if (-1 == ::getpeername(socket, reinterpret_cast<sockaddr*>(&peer_addr), &addr_length))
+        return ENOTCONN == errno ? IoResult::PENDING : IoResult::FAILED;
+
+    return IoResult::COMPLETED;
+}
+
+EpollReactor::IoResult EpollReactor::try_receive(SOCKET socket, RecvIO* io, int& bytes_transferred)
+{
+    RecvBuffer& recv_buffer = io->get_session()->get_recv_buffer();
+    if (false == recv_buffer.EnsureBuffer())
+        return IoResult::FAILED;
+
+    while (true)
+    {
+        const ssize_t result = ::recv(socket, recv_buffer.GetWritePos(), recv_buffer.GetRemainingSize(), 0);
+        if (result >= 0)
+        {
+            bytes_transferred = static_cast<int>(result);
+            return IoResult::COMPLETED;
+        }
+
+        if (EINTR == errno)
+            continue;
+
+        // 읽을 게 없는 동안은 버퍼를 풀에 돌려두고 EPOLLIN이 오면 다시 빌린다
+        if (EAGAIN == errno || EWOULDBLOCK == errno)
+        {
+            recv_buffer.ReleaseIfEmpty();
+            return IoResult::PENDING;
+        }
+
+        bytes_transferred = 0;
+        return IoResult::FAILED;
+    }
+}
+
+EpollReactor::IoResult EpollReactor::try_send(SOCKET socket, SendIO* io)
+{
+    iovec vectors[SEND_IOV_MAX];
+
+    while (true)
+    {
+        // InternalHigh까지는 이미 보냈으므로 그 뒤부터 iovec을 구성한다
+        size_t skip = io->InternalHigh;
+        int vector_count = 0;
+        for (WSABUF& buffer : io->m_buffers)
+        {
+            if (skip >= buffer.len)
+            {
+                skip -= buffer.len;
+                continue;
+            }
+
+            vectors[vector_count].iov_base = buffer.buf + skip;
+            vectors[vector_count].iov_len = buffer.len - skip;
+            skip = 0;
+
+            if (++vector_count == SEND_IOV_MAX)
+                break;
+        }
+
+        if (0 == vector_count)
+            return IoResult::COMPLETED;
+
+        msghdr message{};
+        message.msg_iov = vectors;
+        message.msg_iovlen = vector_count;
+
+        const ssize_t result = ::sendmsg(socket, &message, MSG_NOSIGNAL);
+        if (result >= 0)
+        {
+            io->InternalHigh += static_cast<ULONG_PTR>(result);
+            continue;
+        }
+
+        if (EINTR == errno)
+            continue;
+
+        if (EAGAIN == errno || EWOULDBLOCK == errno)
+            return IoResult::PENDING;
+
+        std::cout << "send error: " << errno << std::endl;
+        return IoResult::FAILED;
+    }
+}
+
+void EpollReactor::on_socket_event(SOCKET socket, uint32_t events, std::vector<IoCompletion>& completions)
+{
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+        return;
+
+    std::lock_guard<std::mutex> lock(context->lock);
+
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+    {
+        complete_accepts(socket, context, completions);
+
+        if (nullptr != context->recv_io)
+        {
+            int bytes_transferred = 0;
+            if (IoResult::PENDING != try_receive(socket, context->recv_io, bytes_transferred))
+            {
+                // 실패도 0 바이트 완료로 돌려주어 세션이 끊기 처리를 하게 한다
+                completions.push_back({ context->recv_io, bytes_transferred });
+                context->recv_io = nullptr;
+            }
+        }
+    }
+
+    if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+    {
+        if (nullptr != context->connect_io)
+        {
+            const IoResult result = try_connect(socket);
+            if (IoResult::COMPLETED == result)
+                completions.push_back({ context->connect_io, 0 });
+            else if (IoResult::FAILED == result)
+                std::cout << "connect error: socket " << socket << std::endl;
+
+            if (IoResult::PENDING != result)
+                context->connect_io = nullptr;
+        }
+
+        if (nullptr != context->send_io)
+        {
+            // 실패도 IOCP처럼 0 바이트 완료로 돌려주어, 보내는 동안 세션을 잡아둔 MultiSender가 놓게 한다
+            const IoResult result = try_send(socket, context->send_io);
+            if (IoResult::COMPLETED == result)
+                completions.push_back({ context->send_io, static_cast<int>(context->send_io->InternalHigh) });
+            else if (IoResult::FAILED == result)
+                completions.push_back({ context->send_io, 0 });
+
+            if (IoResult::PENDING != result)
+                context->send_io = nullptr;
+        }
+    }
+}
+
+void EpollReactor::complete_accepts(SOCKET listen_socket, SocketContext* context, std::vector<IoCompletion>& completions)
+{
+    while (false == context->accept_ios.empty())
+    {
+        AcceptIO* io = context->accept_ios.front();
+        const IoResult result = try_accept(listen_socket, io);
+        if (IoResult::RETRY_LATER == result)
+            schedule_accept_retry(listen_socket);
+        if (IoResult::COMPLETED != result)
+            break;
+
+        context->accept_ios.pop_front();
+        completions.push_back({ io, 0 });
+    }
+}
+
+void EpollReactor::schedule_accept_retry(SOCKET listen_socket)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_accept_retry_lock);
+        if (m_accept_retry_sockets.end() != std::find(m_accept_retry_sockets.begin(), m_accept_retry_sockets.end(), listen_socket))
+            return;
+
+        if (false == m_is_accept_starved)
+        {
+            std::cout << "accept error: out of fds or memory (" << errno << "), retry every " << ACCEPT_RETRY_DELAY_MS << " ms" << std::endl;
+            m_is_accept_starved = true;
+        }
+        m_accept_retry_sockets.push_back(listen_socket);
+        if (0 == m_accept_retry_at_ms.load(std::memory_order_relaxed))
+            m_accept_retry_at_ms.store(get_steady_ms() + ACCEPT_RETRY_DELAY_MS, std::memory_order_relaxed);
+    }
+
+    // 모든 I/O 스레드가 무한 대기 중일 수 있으므로 깨워 대기 시간을 다시 잡게 한다
+    const uint64_t wake = 1;
+    if (-1 == ::write(m_event_fd, &wake, sizeof(wake)))
+        std::cout << "eventfd write error: " << errno << std::endl;
+}
+
+void EpollReactor::retry_accepts(std::vector<IoCompletion>& completions)
+{
+    const long long retry_at_ms = m_accept_retry_at_ms.load(std::memory_order_relaxed);
+    if (0 == retry_at_ms || get_steady_ms() < retry_at_ms)
+        return;
+
+    std::vector<SOCKET> retry_sockets;
+    {
+        std::lock_guard<std::mutex> lock(m_accept_retry_lock);
+        retry_sockets.swap(m_accept_retry_sockets);
+        m_accept_retry_at_ms.store(0, std::memory_order_relaxed);
+    }
+
+    // 그래도 모자라면 complete_accepts가 다시 예약한다
+    for (SOCKET listen_socket : retry_sockets)
+    {
+        SocketContext* context = m_contexts.find(listen_socket);
+        if (nullptr == context)
+            continue;
+
+        std::lock_guard<std::mutex> lock(context->lock);
+        complete_accepts(listen_socket, context, completions);
+    }
+
+    std::lock_guard<std::mutex> lock(m_accept_retry_lock);
+    if (m_is_accept_starved && m_accept_retry_sockets.empty())
+    {
+        std::cout << "accept resumed" << std::endl;
+        m_is_accept_starved = false;
+    }
+}
+
+int EpollReactor::get_wait_timeout(DWORD timeout_ms)
+{
+    const int timeout = (INFINITE == timeout_ms) ? -1 : static_cast<int>(timeout_ms);
+    const long long retry_at_ms = m_accept_retry_at_ms.load(std::memory_order_relaxed);
+    if (0 == retry_at_ms)
+        return timeout;
+
+    const int retry_timeout = static_cast<int>(std::max(0LL, retry_at_ms - get_steady_ms()));
+    return -1 == timeout ? retry_timeout : std::min(timeout, retry_timeout);
+}
+
+void EpollReactor::drain_posted_completions(std::vector<IoCompletion>& completions)
+{
+    uint64_t wake_count = 0;
+    while (sizeof(wake_count) == ::read(m_event_fd, &wake_count, sizeof(wake_count))) {}
+
+    std::lock_guard<std::mutex> lock(m_posted_lock);
+    completions.insert(completions.end(), m_posted_completions.begin(), m_posted_completions.end());
+    m_posted_completions.clear();
+}
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef _WIN32
+#include <deque>
+
+// epoll(edge-triggered) 위에서 IOCP의 완료 통지 모델을 흉내내는 리액터
+// 요청된 I/O는 소켓별 컨텍스트에 걸어두고, 준비 이벤트가 오면 I/O 스레드가 직접 시스템 콜을 수행한 뒤 완료로 돌려준다
+// 즉시 끝난 요청도 IOCP처럼 완료 큐를 거쳐 on_iocp_io로 전달된다
+class EpollReactor : public IoEngine
+{
+public:
+    EpollReactor();
+    ~EpollReactor() override;
+
+public:
+    IoEngineType get_type() const override { return IoEngineType::EPOLL; }
+    bool init() override;
+    bool register_socket(SOCKET socket) override;
+    bool get_queued_completions(std::vector<IoCompletion>& completions, DWORD timeout_ms) override;
+    void post_completion(NetworkIO* io, int bytes_transferred) override;
+
+public:
+    bool accept(SOCKET listen_socket, AcceptIO* io) override;
+    bool connect(SOCKET socket, ConnectIO* io, const sockaddr_in& addr, bool& is_not_pending) override;
+    bool send(SOCKET socket, SendIO* io, bool& is_not_pending, DWORD& send_byte_size) override;
+    bool receive(SOCKET socket, RecvIO* io) override;
+    bool disconnect(SOCKET socket, DisconnectIO* io) override;
+
+private:
+    enum class IoResult
+    {
+        COMPLETED,
+        PENDING,
+        FAILED,
+        RETRY_LATER, // fd / 메모리가 모자라 지금은 받을 수 없다. edge-triggered라 다음 이벤트가 오지 않을 수 있으므로 시간을 두고 다시 시도한다
+    };
+
+    struct SocketContext
+    {
+        std::mutex lock;
+        bool is_disconnecting = false;
+
+        std::deque<AcceptIO*> accept_ios;
+        ConnectIO* connect_io = nullptr;
+        RecvIO* recv_io = nullptr;
+        SendIO* send_io = nullptr;
+    };
+
+    static IoResult try_accept(SOCKET listen_socket, AcceptIO* io);
+    static IoResult try_connect(SOCKET socket);
+    static IoResult try_receive(SOCKET socket, RecvIO* io, int& bytes_transferred);
+    static IoResult try_send(SOCKET socket, SendIO* io);
+
+    void on_socket_event(SOCKET socket, uint32_t events, std::vector<IoCompletion>& completions);
+    void drain_posted_completions(std::vector<IoCompletion>& completions);
+
+    // context->lock을 잡은 채로 부른다. 걸어둔 accept를 받을 수 있는 만큼 완료로 돌리고, 모자라면 재시도를 예약한다
+    void complete_accepts(SOCKET listen_socket, SocketContext* context, std::vector<IoCompletion>& completions);
+    void schedule_accept_retry(SOCKET listen_socket);
+    void retry_accepts(std::vector<IoCompletion>& completions);
+    int get_wait_timeout(DWORD timeout_ms);
+
+private:
+    int m_epoll_fd;
+    int m_event_fd;
+
+    SocketTable<SocketContext> m_contexts;
+
+    std::mutex m_posted_lock;
+    std::vector<IoCompletion> m_posted_completions;
+
+    // fd가 모자라 accept를 미룬 리슨 소켓들과 다시 시도할 시각 (steady_clock ms, 0이면 없음)
+    std::mutex m_accept_retry_lock;
+    std::vector<SOCKET> m_accept_retry_sockets;
+    std::atomic<long long> m_accept_retry_at_ms{ 0 };
+    bool m_is_accept_starved = false; // 로그를 모자라기 시작할 때와 풀렸을 때만 남긴다 (m_accept_retry_lock)
+};
+
+#endif
@@ -0,0 +1,374 @@
+#include "pch.h"
+#include "HardTaskPool.h"
+
+namespace
+{
+    // 지금 스레드가 워커면 그 풀과 워커 번호
+    thread_local HardTaskPool* t_current_pool = nullptr;
+    thread_local int t_current_worker_index = -1;
+
+    long long to_steady_ns(std::chrono::steady_clock::time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+}
+
+void HardTaskPool::init(NetworkCore* owner, int thread_count)
+{
+    m_owner = owner;
+    if (thread_count <= 0)
+        return;
+
+    m_min_thread_count = thread_count;
+    int max_thread_count = thread_count;
+    if (hard_task_auto_scaling_mode)
+    {
+        m_min_thread_count = std::max(1, hard_task_min_threads);
+        max_thread_count = std::max(m_min_thread_count, hard_task_max_threads);
+        thread_count = std::clamp(thread_count, m_min_thread_count, max_thread_count);
+    }
+    m_max_thread_count = max_thread_count;
+
+    for (int i = 0; i < max_thread_count; ++i)
+        m_workers.emplace_back(std::make_unique<Worker>());
+
+    for (int i = 0; i < thread_count; ++i)
+        start_worker();
+
+    if (hard_task_auto_scaling_mode)
+        m_scaler_thread = std::thread([this]() { scaler_thread_work(); });
+}
+
+void HardTaskPool::push(iTask* task, HardTaskPriority priority)
+{
+    task->hard_task_priority = priority;
+    task->execute_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(task->delay_time);
+
+    if (0 < task->delay_time || m_workers.empty())
+    {
+        std::lock_guard<std::mutex> lock(m_delayed_mutex);
+        m_delayed_tasks.push(task);
+        m_next_delayed_time.store(to_steady_ns(m_delayed_tasks.top()->execute_time), std::memory_order_relaxed);
+    }
+    else if (this == t_current_pool)
+    {
+        push_to_worker(*m_workers[t_current_worker_index], task);
+    }
+    else
+    {
+        // 내려간 자리는 건너뛴다. 고르는 사이 내려가더라도 남은 task는 다른 워커가 훔쳐 간다
+        const int worker_count = static_cast<int>(m_workers.size());
+        const int start_index = static_cast<int>(m_next_worker.fetch_add(1, std::memory_order_relaxed) % worker_count);
+        int index = start_index;
+        for (int i = 0; i < worker_count; ++i)
+        {
+            if (m_workers[(start_index + i) % worker_count]->is_running.load(std::memory_order_relaxed))
+            {
+                index = (start_index + i) % worker_count;
+                break;
+            }
+        }
+        push_to_worker(*m_workers[index], task);
+    }
+
+    // 잠든 워커는 지연 task가 새로 들어오면 깨어날 시각도 다시 정해야 하므로 어느 경우든 깨운다
+    wake_one();
+}
+
+void HardTaskPool::set_max_thread_count(int max_thread_count)
+{
+    if (m_workers.empty())
+        return;
+
+    // 워커 자리 수를 넘을 수 없고, 최소 워커 수 아래로는 내리지 않는다
+    m_max_thread_count.store(std::clamp(max_thread_count, m_min_thread_count, static_cast<int>(m_workers.size())), std::memory_order_relaxed);
+}
+
+HardTaskPool::BlockingScope::BlockingScope() : m_pool(t_current_pool)
+{
+    if (nullptr != m_pool)
+        m_pool->m_blocked_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+HardTaskPool::BlockingScope::~BlockingScope()
+{
+    if (nullptr != m_pool)
+        m_pool->m_blocked_count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+int HardTaskPool::get_queued_task_count() const
+{
+    int queued_count = 0;
+    for (const auto& worker : m_workers)
+    {
+        for (int priority = 0; priority < HARD_TASK_PRIORITY_COUNT; ++priority)
+            queued_count += worker->counts[priority].load(std::memory_order_relaxed);
+    }
+    return queued_count;
+}
+
+void HardTaskPool::update_wait_stats()
+{
+    for (int priority = 0; priority < HARD_TASK_PRIORITY_COUNT; ++priority)
+    {
+        const long long count = m_wait_count[priority].exchange(0);
+        const long long total_us = m_wait_total_us[priority].exchange(0);
+        m_current_wait_count[priority] = count;
+        m_current_wait_avg_us[priority] = 0 < count ? static_cast<double>(total_us) / count : 0;
+        m_current_wait_max_us[priority] = m_wait_max_us[priority].exchange(0);
+    }
+}
+
+void HardTaskPool::worker_thread_work(int index)
+{
+    t_current_pool = this;
+    t_current_worker_index = index;
+
+    auto idle_start_time = std::chrono::steady_clock::now();
+    while (true == m_owner->is_running())
+    {
+        move_due_delayed_tasks(index);
+
+        iTask* task = pop_task(index);
+        if (nullptr != task)
+        {
+            execute(task);
+            idle_start_time = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        // 상한이 줄었거나 오래 놀았으면 내려간다
+        const bool is_idle_long = std::chrono::steady_clock::now() - idle_start_time >= std::chrono::milliseconds(hard_task_shrink_idle_ms);
+        if ((is_idle_long || get_thread_count() > get_max_thread_count()) && try_retire_worker(index, is_idle_long))
+        {
+            // 그 사이 자기 deque에 들어온 task를 다른 워커가 가져가도록 깨운다
+            wake_one();
+            return;
+        }
+
+        park();
+    }
+}
+
+iTask* HardTaskPool::pop_task(int index)
+{
+    const int worker_count = static_cast<int>(m_workers.size());
+    iTask* task = nullptr;
+    for (int priority = 0; priority < HARD_TASK_PRIORITY_COUNT; ++priority)
+    {
+        for (int i = 0; i < worker_count; ++i)
+        {
+            if (try_pop_from(*m_workers[(index + i) % worker_count], priority, task))
+                return task;
+        }
+    }
+    return nullptr;
+}
+
+bool HardTaskPool::try_pop_from(Worker& worker, int priority, iTask*& task)
+{
+    if (0 == worker.counts[priority].load(std::memory_order_relaxed))
+        return false;
+
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    std::deque<iTask*>& queue = worker.queues[priority];
+    if (queue.empty())
+        return false;
+
+    task = queue.front();
+    queue.pop_front();
+    worker.counts[priority].fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void HardTaskPool::push_to_worker(Worker& worker, iTask* task)
+{
+    const int priority = static_cast<int>(task->hard_task_priority);
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.queues[priority].push_back(task);
+    worker.counts[priority].fetch_add(1, std::memory_order_relaxed);
+}
+
+void HardTaskPool::move_due_delayed_tasks(int index)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (to_steady_ns(now) < m_next_delayed_time.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_delayed_mutex);
+    while (false == m_delayed_tasks.empty() && m_delayed_tasks.top()->execute_time <= now)
+    {
+        push_to_worker(*m_workers[index], m_delayed_tasks.top());
+        m_delayed_tasks.pop();
+    }
+    m_next_delayed_time.store(m_delayed_tasks.empty() ? LLONG_MAX : to_steady_ns(m_delayed_tasks.top()->execute_time), std::memory_order_relaxed);
+
+    // 한꺼번에 옮겼으면 잠든 워커도 나눠 가져가도록 깨운다
+    wake_one();
+}
+
+bool HardTaskPool::has_ready_task() const
+{
+    if (m_next_delayed_time.load(std::memory_order_relaxed) <= to_steady_ns(std::chrono::steady_clock::now()))
+        return true;
+
+    for (const auto& worker : m_workers)
+    {
+        for (int priority = 0; priority < HARD_TASK_PRIORITY_COUNT; ++priority)
+        {
+            if (0 < worker->counts[priority].load(std::memory_order_relaxed))
+                return true;
+        }
+    }
+    return false;
+}
+
+void HardTaskPool::park()
+{
+    auto wake_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(MAX_PARK_MS);
+    const long long next_delayed_time = m_next_delayed_time.load(std::memory_order_relaxed);
+    if (LLONG_MAX != next_delayed_time)
+        wake_time = std::min(wake_time, std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(next_delayed_time))));
+
+    std::unique_lock<std::mutex> lock(m_park_mutex);
+    m_parked_count.fetch_add(1, std::memory_order_relaxed);
+
+    // 넣는 쪽은 넣은 뒤 m_parked_count를 보고, 여기서는 m_parked_count를 올린 뒤 큐를 보므로 둘 중 한 쪽은 상대를 본다
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (false == has_ready_task())
+        m_park_cv.wait_until(lock, wake_time);
+    m_parked_count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void HardTaskPool::wake_one()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (0 == m_parked_count.load(std::memory_order_relaxed))
+        return;
+
+    // 워커가 잠들기 직전이면 wait에 들어갈 때까지 기다렸다가 깨운다
+    {
+        std::lock_guard<std::mutex> lock(m_park_mutex);
+    }
+    m_park_cv.notify_one();
+}
+
+void HardTaskPool::execute(iTask* task)
+{
+    const int priority = static_cast<int>(task->hard_task_priority);
+    record_wait(priority, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - task->execute_time).count());
+
+    try
+    {
+        task->func();
+
+        if (nullptr != task->post_processing_func)
+            task->post_processing_func();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "[hard_task] exception: " << e.what() << std::endl;
+        xdelete task;
+        return;
+    }
+    catch (...)
+    {
+        std::cerr << "[hard_task] unknown exception" << std::endl;
+        xdelete task;
+        return;
+    }
+
+    if (task->is_repeat)
+        push(task, task->hard_task_priority);
+    else
+        xdelete task;
+}
+
+void HardTaskPool::record_wait(int priority, long long wait_us)
+{
+    m_wait_count[priority].fetch_add(1, std::memory_order_relaxed);
+    m_wait_total_us[priority].fetch_add(wait_us, std::memory_order_relaxed);
+
+    long long max_us = m_wait_max_us[priority].load(std::memory_order_relaxed);
+    while (max_us < wait_us && false == m_wait_max_us[priority].compare_exchange_weak(max_us, wait_us, std::memory_order_relaxed)) {}
+}
+
+void HardTaskPool::scaler_thread_work()
+{
+    while (true == m_owner->is_running())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(hard_task_scale_interval_ms));
+
+        const int thread_count = get_thread_count();
+        if (thread_count >= get_max_thread_count() || 0 == get_queued_task_count())
+            continue;
+
+        // 기다리는 task가 있을 때, 오래 기다렸거나 워커 대부분이 DB 등에 막혀 있으면 하나 늘린다
+        const double blocked_ratio = 0 < thread_count ? static_cast<double>(get_blocked_thread_count()) / thread_count : 1.0;
+        if (get_oldest_wait_us() >= hard_task_grow_wait_us || blocked_ratio >= hard_task_grow_blocked_ratio)
+        {
+            if (start_worker())
+                m_grow_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool HardTaskPool::start_worker()
+{
+    std::lock_guard<std::mutex> lock(m_scale_mutex);
+    if (get_thread_count() >= get_max_thread_count())
+        return false;
+
+    for (int i = 0; i < static_cast<int>(m_workers.size()); ++i)
+    {
+        Worker& worker = *m_workers[i];
+        if (worker.is_running.load(std::memory_order_relaxed))
+            continue;
+
+        // 내려간 워커 스레드는 이미 끝났거나 끝나는 중이다
+        if (worker.thread.joinable())
+            worker.thread.join();
+
+        worker.is_running.store(true, std::memory_order_relaxed);
+        m_thread_count.fetch_add(1, std::memory_order_relaxed);
+        worker.thread = std::thread([this, i]() { worker_thread_work(i); });
+        return true;
+    }
+    return false;
+}
+
+bool HardTaskPool::try_retire_worker(int index, bool is_idle_long)
+{
+    std::lock_guard<std::mutex> lock(m_scale_mutex);
+    const int thread_count = get_thread_count();
+    if (thread_count <= m_min_thread_count)
+        return false;
+    if (false == is_idle_long && thread_count <= get_max_thread_count())
+        return false;
+
+    m_workers[index]->is_running.store(false, std::memory_order_relaxed);
+    m_thread_count.fetch_sub(1, std::memory_order_relaxed);
+    m_shrink_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+long long HardTaskPool::get_oldest_wait_us() const
+{
+    auto oldest_time = std::chrono::steady_clock::time_point::max();
+    for (const auto& worker : m_workers)
+    {
+        for (int priority = 0; priority < HARD_TASK_PRIORITY_COUNT; ++priority)
+        {
+            if (0 == worker->counts[priority].load(std::memory_order_relaxed))
+                continue;
+
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            if (false == worker->queues[priority].empty())
+                oldest_time = std::min(oldest_time, worker->queues[priority].front()->execute_time);
+        }
+    }
+
+    if (std::chrono::steady_clock::time_point::max() == oldest_time)
+        return 0;
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - oldest_time).count();
+}
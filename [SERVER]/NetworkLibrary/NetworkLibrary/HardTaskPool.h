@@ -0,0 +1,120 @@
+#pragma once
+#include <deque>
+#include <queue>
+#include <condition_variable>
+
+// 하드 task(DB 쿼리처럼 오래 막히는 일)를 실행하는 스레드 풀
+// 워커마다 우선순위별 deque를 두고, 워커 밖에서 넣은 task는 워커에 돌아가며 나눠 넣는다 (워커 안에서 넣으면 자기 deque)
+// 워커는 높은 우선순위부터 자기 deque -> 다른 워커 deque(훔치기) 순으로 꺼내므로, 어느 워커에든 INTERACTIVE task가 있으면 그것부터 실행된다
+// 실행 시각이 아직 안 된 task는 실행 시각 순 힙에 두었다가, 시각이 되면 처음 확인한 워커가 자기 deque로 옮긴다
+// 할 일이 없는 워커는 다음 지연 task 시각까지 잠들고, task를 넣는 쪽이 깨운다
+// hard_task_auto_scaling_mode면 워커 수를 늘리고 줄인다 (config.h). 워커 자리는 최대 수만큼 미리 만들어 두고 켜고 끄므로 훔치기는 락 없이 자리를 돈다
+class HardTaskPool
+{
+public:
+    HardTaskPool() = default;
+    HardTaskPool(const HardTaskPool&) = delete;
+    HardTaskPool& operator=(const HardTaskPool&) = delete;
+
+public:
+    // owner가 돌고 있는 동안 워커 thread_count개를 돌린다
+    void init(class NetworkCore* owner, int thread_count);
+    // task->delay_time(ms) 뒤에 실행한다. 워커가 하나도 없으면 실행되지 않는다
+    void push(iTask* task, HardTaskPriority priority);
+
+    // 워커 수 상한을 바꾼다 (DB 커넥션 풀 크기처럼 워커를 늘려도 소용없는 한계가 있을 때). 넘는 워커는 놀 때 내려간다
+    void set_max_thread_count(int max_thread_count);
+
+    // 워커에서 실행 중인 task가 DB 호출처럼 막히는 동안 잡아둔다. 막힌 워커 비율이 높으면 워커를 늘린다
+    class BlockingScope
+    {
+    public:
+        BlockingScope();
+        ~BlockingScope();
+        BlockingScope(const BlockingScope&) = delete;
+        BlockingScope& operator=(const BlockingScope&) = delete;
+
+    private:
+        HardTaskPool* m_pool;
+    };
+
+public:
+    int get_thread_count() const { return m_thread_count.load(std::memory_order_relaxed); }
+    int get_min_thread_count() const { return m_min_thread_count; }
+    int get_max_thread_count() const { return m_max_thread_count.load(std::memory_order_relaxed); }
+    int get_blocked_thread_count() const { return m_blocked_count.load(std::memory_order_relaxed); }
+    int get_queued_task_count() const;
+    long long get_grow_count() const { return m_grow_count.load(std::memory_order_relaxed); }
+    long long get_shrink_count() const { return m_shrink_count.load(std::memory_order_relaxed); }
+
+    // 우선순위별로 task가 실행 시각부터 워커가 꺼낼 때까지 기다린 시간
+    // update_wait_stats를 부를 때마다 지난 호출 이후 구간의 값으로 바뀐다
+    void update_wait_stats();
+    long long get_wait_count(HardTaskPriority priority) const { return m_current_wait_count[static_cast<int>(priority)]; }
+    double get_wait_avg_us(HardTaskPriority priority) const { return m_current_wait_avg_us[static_cast<int>(priority)]; }
+    long long get_wait_max_us(HardTaskPriority priority) const { return m_current_wait_max_us[static_cast<int>(priority)]; }
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<iTask*> queues[HARD_TASK_PRIORITY_COUNT];
+        std::atomic<int> counts[HARD_TASK_PRIORITY_COUNT] = {}; // 락 없이 비었는지 보려고 따로 센다
+        std::atomic<bool> is_running{ false };                   // 내려간 자리의 deque에 남은 task도 다른 워커가 훔쳐 간다
+        std::thread thread;
+    };
+
+    struct DelayedTaskCompare
+    {
+        bool operator()(const iTask* a, const iTask* b) const { return a->execute_time > b->execute_time; }
+    };
+
+    void worker_thread_work(int index);
+    iTask* pop_task(int index);
+    static bool try_pop_from(Worker& worker, int priority, iTask*& task);
+    void push_to_worker(Worker& worker, iTask* task);
+    void move_due_delayed_tasks(int index);
+    bool has_ready_task() const;
+    void park();
+    void wake_one();
+    void execute(iTask* task);
+    void record_wait(int priority, long long wait_us);
+
+    // 자동 조절 (m_scale_mutex를 잡고 워커 자리를 켜고 끈다)
+    void scaler_thread_work();
+    bool start_worker();
+    bool try_retire_worker(int index, bool is_idle_long);
+    long long get_oldest_wait_us() const;
+
+private:
+    static constexpr int MAX_PARK_MS = 100;
+
+    class NetworkCore* m_owner = nullptr;
+    std::vector<std::unique_ptr<Worker>> m_workers; // 최대 워커 수만큼의 자리
+    std::atomic<unsigned int> m_next_worker{ 0 };
+
+    std::mutex m_delayed_mutex;
+    std::priority_queue<iTask*, std::vector<iTask*>, DelayedTaskCompare> m_delayed_tasks;
+    std::atomic<long long> m_next_delayed_time{ LLONG_MAX }; // 힙 맨 앞 task의 실행 시각 (steady_clock ns). 비었으면 LLONG_MAX
+
+    std::mutex m_park_mutex;
+    std::condition_variable m_park_cv;
+    std::atomic<int> m_parked_count{ 0 };
+
+    std::mutex m_scale_mutex;
+    std::thread m_scaler_thread;
+    int m_min_thread_count = 0;
+    std::atomic<int> m_max_thread_count{ 0 };
+    std::atomic<int> m_thread_count{ 0 };
+    std::atomic<int> m_blocked_count{ 0 };
+    std::atomic<long long> m_grow_count{ 0 };
+    std::atomic<long long> m_shrink_count{ 0 };
+
+    // 대기 시간 측정 (워커들이 누적하고 update_wait_stats가 비운다)
+    std::atomic<long long> m_wait_count[HARD_TASK_PRIORITY_COUNT] = {};
+    std::atomic<long long> m_wait_total_us[HARD_TASK_PRIORITY_COUNT] = {};
+    std::atomic<long long> m_wait_max_us[HARD_TASK_PRIORITY_COUNT] = {};
+    long long m_current_wait_count[HARD_TASK_PRIORITY_COUNT] = {};
+    double m_current_wait_avg_us[HARD_TASK_PRIORITY_COUNT] = {};
+    long long m_current_wait_max_us[HARD_TASK_PRIORITY_COUNT] = {};
+};
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "IoEngine.h"
+
+const char* get_io_engine_name(IoEngineType type)
+{
+    switch (type)
+    {
+    case IoEngineType::EPOLL:
+        return "epoll";
+    case IoEngineType::IO_URING:
+        return "io_uring";
+    default:
+#ifdef _WIN32
+        return "iocp";
+#else
+        return "epoll";
+#endif
+    }
+}
+
+#ifndef _WIN32
+
+SocketTable<std::atomic<IoEngine*>> IoEngine::s_socket_owners;
+
+IoEngine* IoEngine::create(IoEngineType type)
+{
+    if (IoEngineType::IO_URING == type)
+    {
+        IoEngine* engine = xnew IoUringEngine;
+        if (engine->init())
+            return engine;
+
+        // 커널이 io_uring(멀티샷, 버퍼 링)을 지원하지 않으면 epoll로 대신한다
+        std::cout << "io_uring is not available, fallback to epoll" << std::endl;
+        xdelete engine;
+    }
+
+    IoEngine* engine = xnew EpollReactor;
+    if (engine->init())
+        return engine;
+
+    xdelete engine;
+    return nullptr;
+}
+
+IoEngine* IoEngine::find_engine(SOCKET socket)
+{
+    std::atomic<IoEngine*>* owner = s_socket_owners.find(socket);
+    if (nullptr == owner)
+        return nullptr;
+
+    return owner->load(std::memory_order_acquire);
+}
+
+void IoEngine::bind_socket(SOCKET socket, IoEngine* engine)
+{
+    std::atomic<IoEngine*>* owner = s_socket_owners.get_or_create(socket);
+    if (nullptr != owner)
+        owner->store(engine, std::memory_order_release);
+}
+
+#endif
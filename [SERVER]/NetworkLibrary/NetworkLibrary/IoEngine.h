@@ -0,0 +1,108 @@
+#pragma once
+
+// NetworkCore가 사용할 I/O 엔진. DEFAULT는 윈도우에서 IOCP, 리눅스에서 epoll
+enum class IoEngineType
+{
+    DEFAULT,
+    EPOLL,
+    IO_URING,
+};
+
+const char* get_io_engine_name(IoEngineType type);
+
+#ifndef _WIN32
+
+struct IoCompletion
+{
+    NetworkIO* io;
+    int bytes_transferred;
+};
+
+// fd를 인덱스로 바로 찾는 소켓별 테이블
+// 청크 단위로 할당하고 엔진이 살아있는 동안 해제하지 않으므로 조회에는 락이 필요없다
+template<typename T>
+class SocketTable
+{
+public:
+    SocketTable() = default;
+    ~SocketTable()
+    {
+        for (std::atomic<T*>& chunk : m_chunks)
+            xdelete[] chunk.load();
+    }
+
+public:
+    T* find(SOCKET socket)
+    {
+        if (socket < 0 || socket >= CHUNK_SIZE * CHUNK_COUNT)
+            return nullptr;
+
+        T* chunk = m_chunks[socket / CHUNK_SIZE].load(std::memory_order_acquire);
+        if (nullptr == chunk)
+            return nullptr;
+
+        return &chunk[socket % CHUNK_SIZE];
+    }
+
+    T* get_or_create(SOCKET socket)
+    {
+        if (socket < 0 || socket >= CHUNK_SIZE * CHUNK_COUNT)
+        {
+            std::cout << "socket fd out of range: " << socket << std::endl;
+            return nullptr;
+        }
+
+        T* entry = find(socket);
+        if (nullptr != entry)
+            return entry;
+
+        std::lock_guard<std::mutex> lock(m_chunks_mutex);
+        std::atomic<T*>& chunk = m_chunks[socket / CHUNK_SIZE];
+        if (nullptr == chunk.load(std::memory_order_relaxed))
+            chunk.store(xnew T[CHUNK_SIZE](), std::memory_order_release);
+
+        return find(socket);
+    }
+
+private:
+    static constexpr int CHUNK_SIZE = 1024;
+    static constexpr int CHUNK_COUNT = 1024;
+
+    std::atomic<T*> m_chunks[CHUNK_COUNT] = {};
+    std::mutex m_chunks_mutex;
+};
+
+// 리눅스 I/O 엔진 공통 인터페이스
+// 요청은 소켓을 등록한 엔진으로 전달되고, 완료는 IOCP처럼 get_queued_completions로 모아 on_iocp_io에 넘긴다
+class IoEngine
+{
+public:
+    virtual ~IoEngine() = default;
+
+public:
+    static IoEngine* create(IoEngineType type);
+    static IoEngine* find_engine(SOCKET socket);
+
+public:
+    virtual IoEngineType get_type() const abstract;
+    virtual bool init() abstract;
+    virtual bool register_socket(SOCKET socket) abstract;
+    virtual bool get_queued_completions(std::vector<IoCompletion>& completions, DWORD timeout_ms) abstract;
+    virtual void post_completion(NetworkIO* io, int bytes_transferred) abstract;
+
+public:
+    virtual bool accept(SOCKET listen_socket, AcceptIO* io) abstract;
+    virtual bool connect(SOCKET socket, ConnectIO* io, const sockaddr_in& addr, bool& is_not_pending) abstract;
+    virtual bool send(SOCKET socket, SendIO* io, bool& is_not_pending, DWORD& send_byte_size) abstract;
+    virtual bool receive(SOCKET socket, RecvIO* io) abstract;
+    virtual bool disconnect(SOCKET socket, DisconnectIO* io) abstract;
+
+protected:
+    // register_socket에서 호출해 이후 NetworkUtil의 요청이 이 엔진으로 오게 한다
+    static void bind_socket(SOCKET socket, IoEngine* engine);
+
+private:
+    static SocketTable<std::atomic<IoEngine*>> s_socket_owners;
+};
+
+#endif
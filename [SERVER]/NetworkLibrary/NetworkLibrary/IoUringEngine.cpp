@@ -0,0 +1,824 @@
+#include "pch.h"
+#include "IoUringEngine.h"
+
+#ifndef _WIN32
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace
+{
+    constexpr unsigned CQE_BATCH = 256;
+    constexpr int SEND_IOV_MAX = 1024;
+
+    // 타임아웃 SQE는 제출될 때 시간을 읽으므로, 언제 제출되든 살아 있도록 정적으로 둔다
+    const __kernel_timespec ACCEPT_RETRY_DELAY{ 0, 100 * 1000 * 1000 };
+
+    int sys_io_uring_setup(unsigned entries, io_uring_params* params)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int sys_io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, void* arg, size_t arg_size)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size));
+    }
+
+    int sys_io_uring_register(int ring_fd, unsigned opcode, void* arg, unsigned arg_count)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_register, ring_fd, opcode, arg, arg_count));
+    }
+
+    // 커널과 공유하는 링 인덱스는 acquire / release로만 읽고 쓴다
+    template<typename T>
+    T load_acquire(const T* value) { return __atomic_load_n(value, __ATOMIC_ACQUIRE); }
+
+    template<typename T>
+    void store_release(T* value, T new_value) { __atomic_store_n(value, new_value, __ATOMIC_RELEASE); }
+}
+
+IoUringEngine::IoUringEngine()
+    : m_ring_fd(-1), m_event_fd(-1),
+      m_sq_ring(MAP_FAILED), m_sq_ring_size(0), m_cq_ring(MAP_FAILED), m_cq_ring_size(0), m_sqes(nullptr), m_sqes_size(0),
+      m_sq_head(nullptr), m_sq_tail(nullptr), m_sq_mask(0), m_sq_entries(0),
+      m_cq_head(nullptr), m_cq_tail(nullptr), m_cq_mask(0), m_cqes(nullptr),
+      m_is_waiting(false), m_wakeup_pending(false),
+      m_buffer_memory(nullptr), m_buffer_ring(nullptr), m_buffer_ring_size(0), m_buffer_ring_tail(0)
+{
+}
+
+IoUringEngine::~IoUringEngine()
+{
+    if (-1 != m_ring_fd)
+        ::close(m_ring_fd);
+    if (-1 != m_event_fd)
+        ::close(m_event_fd);
+
+    if (nullptr != m_sqes)
+        ::munmap(m_sqes, m_sqes_size);
+    if (MAP_FAILED != m_cq_ring && m_cq_ring != m_sq_ring)
+        ::munmap(m_cq_ring, m_cq_ring_size);
+    if (MAP_FAILED != m_sq_ring)
+        ::munmap(m_sq_ring, m_sq_ring_size);
+
+    // 링 fd를 닫아 커널이 버퍼 링 등록을 푼 뒤에 메모리를 놓는다
+    if (nullptr != m_buffer_ring)
+        ::munmap(m_buffer_ring, m_buffer_ring_size);
+    xdelete[] m_buffer_memory;
+}
+
+bool IoUringEngine::init()
+{
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = CQ_ENTRIES;
+
+    m_ring_fd = sys_io_uring_setup(SQ_ENTRIES, &params);
+    if (m_ring_fd < 0)
+    {
+        std::cout << "io_uring_setup error: " << errno << std::endl;
+        return false;
+    }
+
+    if (false == map_rings(params))
+        return false;
+
+    m_event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (-1 == m_event_fd)
+    {
+        std::cout << "eventfd error: " << errno << std::endl;
+        return false;
+    }
+
+    if (false == setup_recv_buffers())
+        return false;
+
+    arm_wakeup_poll();
+    return true;
+}
+
+bool IoUringEngine::register_socket(SOCKET socket)
+{
+    SocketContext* context = m_contexts.get_or_create(socket);
+    if (nullptr == context)
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(context->lock);
+
+        // 같은 fd로 재사용된 소켓이 이전 소켓의 완료를 받지 않도록 세대를 올린다
+        ++context->generation;
+        context->is_disconnecting = false;
+        context->is_accept_armed = false;
+        context->accept_ios.clear();
+        for (SOCKET accepted_socket : context->accepted_sockets)
+            ::close(accepted_socket);
+        context->accepted_sockets.clear();
+        context->connect_io = nullptr;
+        context->is_recv_armed = false;
+        context->is_recv_closed = false;
+        context->recv_io = nullptr;
+        release_recv_chunks(context);
+        context->send_io = nullptr;
+    }
+    bind_socket(socket, this);
+
+    return true;
+}
+
+bool IoUringEngine::get_queued_completions(std::vector<IoCompletion>& completions, DWORD timeout_ms)
+{
+    io_uring_cqe cqes[CQE_BATCH];
+    unsigned cqe_count = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_cq_lock);
+
+        unsigned head = *m_cq_head;
+        if (head == load_acquire(m_cq_tail))
+        {
+            // 잠들기 직전에 m_is_waiting을 세워두면, 이후 SQE를 넣거나 완료를 게시하는 스레드가 깨워준다
+            m_wakeup_pending.store(false);
+            m_is_waiting.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            bool has_posted = false;
+            {
+                std::lock_guard<std::mutex> posted_lock(m_posted_lock);
+                has_posted = false == m_posted_completions.empty();
+            }
+
+            submit_and_wait(has_posted ? 0 : 1, timeout_ms);
+            m_is_waiting.store(false);
+        }
+        else
+        {
+            submit_and_wait(0, timeout_ms);
+        }
+
+        const unsigned tail = load_acquire(m_cq_tail);
+        for (; head != tail && cqe_count < CQE_BATCH; ++head)
+            cqes[cqe_count++] = m_cqes[head & m_cq_mask];
+
+        store_release(m_cq_head, head);
+
+        // 락을 놓은 뒤에 처리하면 다른 I/O 스레드가 다음 배치를 먼저 처리해, 같은 소켓의 recv 데이터가 CQ 순서와 다르게 쌓일 수 있다
+        // 세션 처리(on_iocp_io)는 락 밖에서 하므로 여기서는 데이터를 순서대로 붙이는 일만 직렬화된다
+        for (unsigned i = 0; i < cqe_count; ++i)
+            on_cqe(cqes[i], completions);
+    }
+
+    drain_posted_completions(completions);
+    return true;
+}
+
+void IoUringEngine::post_completion(NetworkIO* io, int bytes_transferred)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_posted_lock);
+        m_posted_completions.push_back({ io, bytes_transferred });
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_is_waiting.load())
+        wake_up();
+}
+
+bool IoUringEngine::accept(SOCKET listen_socket, AcceptIO* io)
+{
+    SocketContext* context = m_contexts.find(listen_socket);
+    if (nullptr == context)
+    {
+        std::cout << "accept error: listen socket is not registered" << std::endl;
+        return false;
+    }
+
+    // 멀티샷 accept가 새 소켓을 만들어 주므로 AcceptEx용으로 미리 만들어 둔 소켓은 필요없다
+    if (INVALID_SOCKET != io->m_socket)
+    {
+        ::close(io->m_socket);
+        io->m_socket = INVALID_SOCKET;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (false == context->accepted_sockets.empty())
+    {
+        fill_accept_io(io, context->accepted_sockets.front());
+        context->accepted_sockets.pop_front();
+        post_completion(io, 0);
+        return true;
+    }
+
+    context->accept_ios.push_back(io);
+    if (false == context->is_accept_armed)
+        arm_accept(listen_socket, context);
+
+    return true;
+}
+
+bool IoUringEngine::connect(SOCKET socket, ConnectIO* io, const sockaddr_in& addr, bool& is_not_pending)
+{
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+    {
+        std::cout << "connect error: socket is not registered" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    context->connect_io = io;
+    context->connect_addr = addr;
+
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_CONNECT;
+    sqe.fd = socket;
+    sqe.addr = reinterpret_cast<uint64_t>(&context->connect_addr);
+    sqe.off = sizeof(context->connect_addr);
+    sqe.user_data = make_user_data(socket, context->generation, OP_CONNECT);
+    push_sqe(sqe);
+
+    is_not_pending = false;
+    return true;
+}
+
+bool IoUringEngine::send(SOCKET socket, SendIO* io, bool& is_not_pending, DWORD& send_byte_size)
+{
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+    {
+        std::cout << "send error: socket is not registered" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (context->is_disconnecting)
+        return false;
+
+    context->send_io = io;
+    if (false == arm_send(socket, context))
+    {
+        // 보낼 것이 없으면 IOCP처럼 0 바이트 완료로 돌려준다
+        context->send_io = nullptr;
+        is_not_pending = true;
+        send_byte_size = 0;
+        post_completion(io, 0);
+    }
+
+    return true;
+}
+
+bool IoUringEngine::receive(SOCKET socket, RecvIO* io)
+{
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+    {
+        std::cout << "recv error: socket is not registered" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (context->is_disconnecting)
+        return false;
+
+    // 이전 recv 이후 이미 받아둔 데이터가 있으면 바로 완료로 돌려준다
+    if (false == context->recv_chunks.empty() || context->is_recv_closed)
+    {
+        post_completion(io, copy_recv_chunks(context, io));
+        return true;
+    }
+
+    context->recv_io = io;
+    if (false == context->is_recv_armed)
+        arm_recv(socket, context);
+
+    return true;
+}
+
+bool IoUringEngine::disconnect(SOCKET socket, DisconnectIO* io)
+{
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+        return false;
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (context->is_disconnecting)
+        return false;
+
+    // DisconnectEx와 같이 끊기 요청 이후에는 걸려있던 I/O의 완료를 돌려주지 않는다
+    // 걸려있던 멀티샷 recv는 shutdown으로 0 바이트를 받고 스스로 끝난다
+    // 걸려있던 send만 0 바이트 완료로 돌려주어, 보내는 동안 세션을 잡아둔 MultiSender가 놓게 한다
+    context->is_disconnecting = true;
+    context->connect_io = nullptr;
+    context->recv_io = nullptr;
+    if (nullptr != context->send_io)
+        post_completion(context->send_io, 0);
+    context->send_io = nullptr;
+    release_recv_chunks(context);
+
+    if (-1 == ::shutdown(socket, SHUT_RDWR) && ENOTCONN != errno)
+    {
+        std::cout << "disconnect error: " << errno << std::endl;
+        return false;
+    }
+
+    post_completion(io, 0);
+    return true;
+}
+
+uint64_t IoUringEngine::make_user_data(SOCKET socket, uint32_t generation, OpType op)
+{
+    // [세대 32bit][fd 24bit][op 8bit]
+    return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(socket & 0xFFFFFF) << 8) | op;
+}
+
+bool IoUringEngine::map_rings(const io_uring_params& params)
+{
+    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    const bool is_single_mmap = 0 != (params.features & IORING_FEAT_SINGLE_MMAP);
+    if (is_single_mmap)
+        m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+
+    m_sq_ring = ::mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+    if (MAP_FAILED == m_sq_ring)
+    {
+        std::cout << "io_uring sq ring mmap error: " << errno << std::endl;
+        return false;
+    }
+
+    m_cq_ring = is_single_mmap ? m_sq_ring
+        : ::mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_CQ_RING);
+    if (MAP_FAILED == m_cq_ring)
+    {
+        std::cout << "io_uring cq ring mmap error: " << errno << std::endl;
+        return false;
+    }
+
+    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES);
+    if (MAP_FAILED == sqes)
+    {
+        std::cout << "io_uring sqes mmap error: " << errno << std::endl;
+        return false;
+    }
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq_ring = static_cast<char*>(m_sq_ring);
+    m_sq_head = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.head);
+    m_sq_tail = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+    m_sq_mask = *reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+    m_sq_entries = params.sq_entries;
+
+    // SQE는 항상 링 순서대로 쓰므로 인덱스 배열은 한 번만 채워둔다
+    unsigned* sq_array = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+    for (unsigned i = 0; i < m_sq_entries; ++i)
+        sq_array[i] = i;
+
+    char* cq_ring = static_cast<char*>(m_cq_ring);
+    m_cq_head = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+    m_cq_mask = *reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+
+    return true;
+}
+
+bool IoUringEngine::setup_recv_buffers()
+{
+    m_buffer_memory = xnew char[static_cast<size_t>(RECV_BUFFER_COUNT) * RECV_BUFFER_SIZE];
+
+    // 커널과 공유하는 링은 페이지 단위로 정렬되어 있어야 하므로 mmap으로 잡는다
+    m_buffer_ring_size = RECV_BUFFER_COUNT * sizeof(io_uring_buf);
+    void* ring = ::mmap(nullptr, m_buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (MAP_FAILED == ring)
+    {
+        std::cout << "io_uring buffer ring mmap error: " << errno << std::endl;
+        return false;
+    }
+    m_buffer_ring = static_cast<io_uring_buf_ring*>(ring);
+
+    io_uring_buf_reg buffer_reg{};
+    buffer_reg.ring_addr = reinterpret_cast<uint64_t>(m_buffer_ring);
+    buffer_reg.ring_entries = RECV_BUFFER_COUNT;
+    buffer_reg.bgid = RECV_BUFFER_GROUP;
+    if (sys_io_uring_register(m_ring_fd, IORING_REGISTER_PBUF_RING, &buffer_reg, 1) < 0)
+    {
+        std::cout << "io_uring register buffer ring error: " << errno << std::endl;
+        return false;
+    }
+
+    // 커널은 tail까지만 가져가므로, tail을 올리지 않으면 링이 비어 있는 것으로 보고 모든 recv가 ENOBUFS로 끝난다
+    std::lock_guard<std::mutex> lock(m_buffer_lock);
+    for (unsigned i = 0; i < RECV_BUFFER_COUNT; ++i)
+        push_recv_buffer(static_cast<uint16_t>(i));
+    store_release(&m_buffer_ring->tail, m_buffer_ring_tail);
+
+    return true;
+}
+
+void IoUringEngine::push_sqe(const io_uring_sqe& sqe)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sq_lock);
+
+        const unsigned tail = *m_sq_tail;
+        while (tail - load_acquire(m_sq_head) >= m_sq_entries)
+        {
+            // SQ가 가득 차면 I/O 스레드를 기다리지 않고 직접 제출해 자리를 만든다
+            if (sys_io_uring_enter(m_ring_fd, m_sq_entries, 0, 0, nullptr, 0) < 0)
+                std::this_thread::yield();
+        }
+
+        m_sqes[tail & m_sq_mask] = sqe;
+        store_release(m_sq_tail, tail + 1);
+    }
+
+    // I/O 스레드가 깨어 있으면 다음 io_uring_enter에서 함께 제출되므로 깨우지 않는다
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_is_waiting.load())
+        wake_up();
+}
+
+void IoUringEngine::submit_and_wait(unsigned wait_count, DWORD timeout_ms)
+{
+    const unsigned to_submit = load_acquire(m_sq_tail) - load_acquire(m_sq_head);
+    if (0 == to_submit && 0 == wait_count)
+        return;
+
+    unsigned flags = 0 < wait_count ? IORING_ENTER_GETEVENTS : 0;
+    void* arg = nullptr;
+    size_t arg_size = 0;
+
+    __kernel_timespec timeout{};
+    io_uring_getevents_arg getevents_arg{};
+    if (0 < wait_count && INFINITE != timeout_ms)
+    {
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+        getevents_arg.ts = reinterpret_cast<uint64_t>(&timeout);
+
+        flags |= IORING_ENTER_EXT_ARG;
+        arg = &getevents_arg;
+        arg_size = sizeof(getevents_arg);
+    }
+
+    if (sys_io_uring_enter(m_ring_fd, to_submit, wait_count, flags, arg, arg_size) < 0)
+    {
+        // EBUSY / EAGAIN: CQ가 넘쳐 있으므로 먼저 수확한 뒤 다음 호출에서 다시 제출한다
+        if (EINTR != errno && ETIME != errno && EBUSY != errno && EAGAIN != errno)
+            std::cout << "io_uring_enter error: " << errno << std::endl;
+    }
+}
+
+void IoUringEngine::wake_up()
+{
+    // 잠든 I/O 스레드 하나만 깨우면 되므로 다음 대기 전까지의 중복 깨우기는 생략한다
+    if (true == m_wakeup_pending.exchange(true))
+        return;
+
+    const uint64_t wake = 1;
+    if (-1 == ::write(m_event_fd, &wake, sizeof(wake)))
+        std::cout << "eventfd write error: " << errno << std::endl;
+}
+
+void IoUringEngine::arm_wakeup_poll()
+{
+    // eventfd에 멀티샷 poll을 걸어두어 깨울 때마다 다시 걸 필요가 없게 한다
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = m_event_fd;
+    sqe.len = IORING_POLL_ADD_MULTI;
+    sqe.poll32_events = POLLIN;
+    sqe.user_data = make_user_data(0, 0, OP_WAKEUP);
+    push_sqe(sqe);
+}
+
+void IoUringEngine::arm_accept(SOCKET socket, SocketContext* context)
+{
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_ACCEPT;
+    sqe.fd = socket;
+    sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe.accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe.user_data = make_user_data(socket, context->generation, OP_ACCEPT);
+
+    context->is_accept_armed = true;
+    push_sqe(sqe);
+}
+
+void IoUringEngine::arm_accept_retry(SOCKET socket, SocketContext* context)
+{
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_TIMEOUT;
+    sqe.addr = reinterpret_cast<uint64_t>(&ACCEPT_RETRY_DELAY);
+    sqe.len = 1;
+    sqe.user_data = make_user_data(socket, context->generation, OP_ACCEPT_RETRY);
+
+    // 기다리는 동안 accept 요청이 와도 다시 걸지 않도록 걸린 것으로 둔다
+    context->is_accept_armed = true;
+    push_sqe(sqe);
+}
+
+void IoUringEngine::arm_recv(SOCKET socket, SocketContext* context)
+{
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_RECV;
+    sqe.fd = socket;
+    sqe.ioprio = IORING_RECV_MULTISHOT;
+    sqe.flags = IOSQE_BUFFER_SELECT;
+    sqe.buf_group = RECV_BUFFER_GROUP;
+    sqe.user_data = make_user_data(socket, context->generation, OP_RECV);
+
+    context->is_recv_armed = true;
+    push_sqe(sqe);
+}
+
+bool IoUringEngine::arm_send(SOCKET socket, SocketContext* context)
+{
+    SendIO* io = context->send_io;
+
+    // InternalHigh까지는 이미 보냈으므로 그 뒤부터 iovec을 구성한다
+    context->send_vectors.clear();
+    size_t skip = io->InternalHigh;
+    for (WSABUF& buffer : io->m_buffers)
+    {
+        if (skip >= buffer.len)
+        {
+            skip -= buffer.len;
+            continue;
+        }
+
+        context->send_vectors.push_back({ buffer.buf + skip, buffer.len - skip });
+        skip = 0;
+
+        if (SEND_IOV_MAX == static_cast<int>(context->send_vectors.size()))
+            break;
+    }
+
+    if (context->send_vectors.empty())
+        return false;
+
+    context->send_message = msghdr{};
+    context->send_message.msg_iov = context->send_vectors.data();
+    context->send_message.msg_iovlen = context->send_vectors.size();
+
+    io_uring_sqe sqe{};
+    sqe.opcode = IORING_OP_SENDMSG;
+    sqe.fd = socket;
+    sqe.addr = reinterpret_cast<uint64_t>(&context->send_message);
+    sqe.len = 1;
+    sqe.msg_flags = MSG_NOSIGNAL;
+    sqe.user_data = make_user_data(socket, context->generation, OP_SEND);
+    push_sqe(sqe);
+
+    return true;
+}
+
+void IoUringEngine::on_cqe(const io_uring_cqe& cqe, std::vector<IoCompletion>& completions)
+{
+    const OpType op = static_cast<OpType>(cqe.user_data & 0xFF);
+    if (OP_WAKEUP == op)
+    {
+        uint64_t wake_count = 0;
+        while (sizeof(wake_count) == ::read(m_event_fd, &wake_count, sizeof(wake_count))) {}
+
+        if (0 == (cqe.flags & IORING_CQE_F_MORE))
+            arm_wakeup_poll();
+        return;
+    }
+
+    const SOCKET socket = static_cast<SOCKET>((cqe.user_data >> 8) & 0xFFFFFF);
+    const uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32);
+
+    SocketContext* context = m_contexts.find(socket);
+    if (nullptr == context)
+        return;
+
+    std::lock_guard<std::mutex> lock(context->lock);
+    if (generation != context->generation)
+    {
+        // 재등록되기 전 소켓의 완료는 자원만 돌려주고 버린다
+        if (cqe.flags & IORING_CQE_F_BUFFER)
+            recycle_recv_buffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+        if (OP_ACCEPT == op && cqe.res >= 0)
+            ::close(cqe.res);
+        return;
+    }
+
+    switch (op)
+    {
+    case OP_ACCEPT:
+        on_accept_cqe(socket, context, cqe, completions);
+        break;
+    case OP_ACCEPT_RETRY:
+        // 그래도 fd가 모자라면 멀티샷 accept가 곧바로 같은 에러로 끝나 다시 여기로 온다
+        arm_accept(socket, context);
+        break;
+    case OP_CONNECT:
+        if (nullptr == context->connect_io)
+            break;
+
+        if (0 == cqe.res)
+            completions.push_back({ context->connect_io, 0 });
+        else
+            std::cout << "connect error: " << -cqe.res << std::endl;
+        context->connect_io = nullptr;
+        break;
+    case OP_RECV:
+        on_recv_cqe(socket, context, cqe, completions);
+        break;
+    case OP_SEND:
+        on_send_cqe(socket, context, cqe, completions);
+        break;
+    default:
+        break;
+    }
+}
+
+void IoUringEngine::on_accept_cqe(SOCKET socket, SocketContext* context, const io_uring_cqe& cqe, std::vector<IoCompletion>& completions)
+{
+    const bool is_starved = -EMFILE == cqe.res || -ENFILE == cqe.res || -ENOBUFS == cqe.res || -ENOMEM == cqe.res;
+    if (cqe.res >= 0)
+    {
+        if (context->is_accept_starved)
+        {
+            std::cout << "accept resumed" << std::endl;
+            context->is_accept_starved = false;
+        }
+
+        if (context->accept_ios.empty())
+        {
+            // 걸어둔 AcceptIO가 모두 처리 중이면 다음 accept 요청까지 보관한다
+            context->accepted_sockets.push_back(cqe.res);
+        }
+        else
+        {
+            AcceptIO* io = context->accept_ios.front();
+            context->accept_ios.pop_front();
+            fill_accept_io(io, cqe.res);
+            completions.push_back({ io, 0 });
+        }
+    }
+    else if (is_starved)
+    {
+        // 다시 시도할 때마다 찍으면 로그가 넘치므로 모자라기 시작할 때만 남긴다
+        if (false == context->is_accept_starved)
+            std::cout << "accept error: out of fds or memory (" << -cqe.res << "), retry every " << ACCEPT_RETRY_DELAY.tv_nsec / 1000000 << " ms" << std::endl;
+        context->is_accept_starved = true;
+    }
+    else if (-ECONNABORTED != cqe.res && -EINTR != cqe.res)
+    {
+        std::cout << "accept error: " << -cqe.res << std::endl;
+    }
+
+    if (0 == (cqe.flags & IORING_CQE_F_MORE))
+    {
+        context->is_accept_armed = false;
+
+        // 대기 중인 연결이 큐에 남아 있으므로 바로 다시 걸면 같은 에러로 끝나기를 반복한다. fd가 풀릴 시간을 두고 다시 건다
+        if (is_starved)
+            arm_accept_retry(socket, context);
+        // 리슨 소켓이 닫힌 경우가 아니면 멀티샷 accept를 다시 건다
+        else if (-EBADF != cqe.res && -EINVAL != cqe.res)
+            arm_accept(socket, context);
+    }
+}
+
+void IoUringEngine::on_recv_cqe(SOCKET socket, SocketContext* context, const io_uring_cqe& cqe, std::vector<IoCompletion>& completions)
+{
+    const bool has_buffer = 0 != (cqe.flags & IORING_CQE_F_BUFFER);
+    const uint16_t buffer_id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+    if (cqe.res > 0 && has_buffer && false == context->is_disconnecting)
+    {
+        context->recv_chunks.push_back({ buffer_id, 0, static_cast<uint32_t>(cqe.res) });
+    }
+    else
+    {
+        if (has_buffer)
+            recycle_recv_buffer(buffer_id);
+
+        // 버퍼 링이 비어 멈춘 경우(ENOBUFS)만 다시 걸고, 0 바이트나 그 외 에러는 연결 종료로 본다
+        if (cqe.res <= 0 && -ENOBUFS != cqe.res)
+            context->is_recv_closed = true;
+    }
+
+    if (0 == (cqe.flags & IORING_CQE_F_MORE))
+    {
+        context->is_recv_armed = false;
+
+        // 받을 곳이 없으면 다음 receive 요청 때 다시 건다
+        if (false == context->is_recv_closed && false == context->is_disconnecting && nullptr != context->recv_io)
+            arm_recv(socket, context);
+    }
+
+    if (nullptr != context->recv_io && (false == context->recv_chunks.empty() || context->is_recv_closed))
+    {
+        completions.push_back({ context->recv_io, copy_recv_chunks(context, context->recv_io) });
+        context->recv_io = nullptr;
+    }
+}
+
+void IoUringEngine::on_send_cqe(SOCKET socket, SocketContext* context, const io_uring_cqe& cqe, std::vector<IoCompletion>& completions)
+{
+    SendIO* io = context->send_io;
+    if (nullptr == io)
+        return;
+
+    // 실패도 IOCP처럼 0 바이트 완료로 돌려주어, 보내는 동안 세션을 잡아둔 MultiSender가 놓게 한다
+    if (cqe.res < 0 && -EAGAIN != cqe.res && -EINTR != cqe.res)
+    {
+        std::cout << "send error: " << -cqe.res << std::endl;
+        completions.push_back({ io, 0 });
+        context->send_io = nullptr;
+        return;
+    }
+
+    if (cqe.res > 0)
+        io->InternalHigh += static_cast<ULONG_PTR>(cqe.res);
+
+    // 일부만 보내졌으면 남은 부분으로 다시 요청한다
+    if (arm_send(socket, context))
+        return;
+
+    completions.push_back({ io, static_cast<int>(io->InternalHigh) });
+    context->send_io = nullptr;
+}
+
+void IoUringEngine::fill_accept_io(AcceptIO* io, SOCKET socket)
+{
+    // 멀티샷 accept는 요청마다 주소 버퍼를 줄 수 없으므로 getpeername으로 채운다
+    sockaddr_in remote_addr{};
+    socklen_t addr_length = sizeof(remote_addr);
+    ::getpeername(socket, reinterpret_cast<sockaddr*>(&remote_addr), &addr_length);
+
+    io->m_socket = socket;
+    ::memcpy(io->m_accept_buffer, &remote_addr, sizeof(remote_addr));
+}
+
+int IoUringEngine::copy_recv_chunks(SocketContext* context, RecvIO* io)
+{
+    // 세션 버퍼는 복사할 때만 풀에서 빌린다 (멀티샷 recv가 걸려 있는 동안은 커널의 제공 버퍼에 쌓인다)
+    RecvBuffer& recv_buffer = io->get_session()->get_recv_buffer();
+    if (false == recv_buffer.EnsureBuffer())
+        return 0;
+
+    const int remaining_size = recv_buffer.GetRemainingSize();
+
+    int copied_size = 0;
+    while (false == context->recv_chunks.empty() && copied_size < remaining_size)
+    {
+        RecvChunk& chunk = context->recv_chunks.front();
+        const uint32_t copy_size = std::min<uint32_t>(chunk.length - chunk.offset, static_cast<uint32_t>(remaining_size - copied_size));
+
+        const char* source = m_buffer_memory + static_cast<size_t>(chunk.buffer_id) * RECV_BUFFER_SIZE + chunk.offset;
+        ::memcpy(recv_buffer.GetWritePos() + copied_size, source, copy_size);
+        copied_size += static_cast<int>(copy_size);
+
+        chunk.offset += copy_size;
+        if (chunk.offset == chunk.length)
+        {
+            recycle_recv_buffer(chunk.buffer_id);
+            context->recv_chunks.pop_front();
+        }
+    }
+
+    return copied_size;
+}
+
+void IoUringEngine::release_recv_chunks(SocketContext* context)
+{
+    for (RecvChunk& chunk : context->recv_chunks)
+        recycle_recv_buffer(chunk.buffer_id);
+    context->recv_chunks.clear();
+}
+
+void IoUringEngine::recycle_recv_buffer(uint16_t buffer_id)
+{
+    std::lock_guard<std::mutex> lock(m_buffer_lock);
+    push_recv_buffer(buffer_id);
+    store_release(&m_buffer_ring->tail, m_buffer_ring_tail);
+}
+
+void IoUringEngine::push_recv_buffer(uint16_t buffer_id)
+{
+    // 항목 배열은 링의 시작부터다. C++에서는 헤더의 bufs 멤버 앞에 빈 구조체가 1바이트를 차지해 bufs가 8바이트 밀리므로 쓰지 않는다
+    // 첫 항목의 resv 자리가 링의 tail이므로 구조체를 통째로 덮어쓰지 않고 필드만 쓴다
+    io_uring_buf& buffer = reinterpret_cast<io_uring_buf*>(m_buffer_ring)[m_buffer_ring_tail & (RECV_BUFFER_COUNT - 1)];
+    buffer.addr = reinterpret_cast<uint64_t>(m_buffer_memory + static_cast<size_t>(buffer_id) * RECV_BUFFER_SIZE);
+    buffer.len = RECV_BUFFER_SIZE;
+    buffer.bid = buffer_id;
+    ++m_buffer_ring_tail;
+}
+
+void IoUringEngine::drain_posted_completions(std::vector<IoCompletion>& completions)
+{
+    std::lock_guard<std::mutex> lock(m_posted_lock);
+    completions.insert(completions.end(), m_posted_completions.begin(), m_posted_completions.end());
+    m_posted_completions.clear();
+}
+
+#endif
@@ -0,0 +1,155 @@
+#pragma once
+
+#ifndef _WIN32
+#include <deque>
+
+struct io_uring_params;
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+// io_uring(liburing 없이 시스템 콜로 직접 링을 다룬다) 위에서 IOCP의 완료 통지 모델을 제공하는 엔진
+// - accept: 리슨 소켓마다 멀티샷 accept 하나를 걸어두고, 올라오는 소켓을 대기 중인 AcceptIO에 나눠준다
+//           fd가 모자라 끝나면 바로 다시 걸지 않고 타임아웃 SQE로 잠시 기다린 뒤 다시 건다
+// - recv: 소켓마다 멀티샷 recv 하나를 걸어두고 커널에 등록한 버퍼 링(IORING_REGISTER_PBUF_RING)에서 버퍼를 골라 채운다
+//         RecvIO가 걸려 있으면 세션의 RecvBuffer로 복사해 완료를 돌려주고, 없으면 다음 receive까지 보관한다
+//         링 버퍼를 세션에 그대로 넘기지 않고 복사하는 이유: 패킷이 16KB 버퍼 경계를 넘나들어 어차피 이어 붙여야 하고,
+//         받은 패킷 슬라이스가 링 버퍼를 잡고 있으면 모든 소켓이 같이 쓰는 1024개 버퍼가 금방 말라 모든 recv가 ENOBUFS로 멈춘다
+//         고정 버퍼(IORING_REGISTER_BUFFERS)는 send가 보낼 패킷 버퍼마다 달라 쓰지 않는다
+// - send: SQE는 링에 쌓기만 하고, I/O 스레드가 다음 io_uring_enter에서 한꺼번에 제출한다 (잠들어 있을 때만 eventfd로 깨운다)
+class IoUringEngine : public IoEngine
+{
+public:
+    IoUringEngine();
+    ~IoUringEngine() override;
+
+public:
+    IoEngineType get_type() const override { return IoEngineType::IO_URING; }
+    bool init() override;
+    bool register_socket(SOCKET socket) override;
+    bool get_queued_completions(std::vector<IoCompletion>& completions, DWORD timeout_ms) override;
+    void post_completion(NetworkIO* io, int bytes_transferred) override;
+
+public:
+    bool accept(SOCKET listen_socket, AcceptIO* io) override;
+    bool connect(SOCKET socket, ConnectIO* io, const sockaddr_in& addr, bool& is_not_pending) override;
+    bool send(SOCKET socket, SendIO* io, bool& is_not_pending, DWORD& send_byte_size) override;
+    bool receive(SOCKET socket, RecvIO* io) override;
+    bool disconnect(SOCKET socket, DisconnectIO* io) override;
+
+private:
+    enum OpType : uint8_t
+    {
+        OP_WAKEUP,
+        OP_ACCEPT,
+        OP_CONNECT,
+        OP_RECV,
+        OP_SEND,
+        OP_ACCEPT_RETRY,
+    };
+
+    struct RecvChunk
+    {
+        uint16_t buffer_id;
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct SocketContext
+    {
+        std::mutex lock;
+        uint32_t generation = 0;
+        bool is_disconnecting = false;
+
+        bool is_accept_armed = false;
+        bool is_accept_starved = false; // fd가 모자라 accept를 잠시 쉬는 중 (로그를 한 번만 남긴다)
+        std::deque<AcceptIO*> accept_ios;
+        std::deque<SOCKET> accepted_sockets;
+
+        ConnectIO* connect_io = nullptr;
+        sockaddr_in connect_addr{};
+
+        bool is_recv_armed = false;
+        bool is_recv_closed = false;
+        RecvIO* recv_io = nullptr;
+        std::deque<RecvChunk> recv_chunks;
+
+        SendIO* send_io = nullptr;
+        msghdr send_message{};
+        std::vector<iovec> send_vectors;
+    };
+
+    static constexpr unsigned SQ_ENTRIES = 4096;
+    static constexpr unsigned CQ_ENTRIES = SQ_ENTRIES * 4;
+    static constexpr unsigned RECV_BUFFER_COUNT = 1024; // 버퍼 링의 크기이기도 하므로 2의 거듭제곱 (32768 이하)
+    static constexpr unsigned RECV_BUFFER_SIZE = 16 * 1024;
+    static constexpr uint16_t RECV_BUFFER_GROUP = 0;
+
+    static uint64_t make_user_data(SOCKET socket, uint32_t generation, OpType op);
+
+    bool map_rings(const io_uring_params& params);
+    bool setup_recv_buffers();
+
+    void push_sqe(const io_uring_sqe& sqe);
+    void submit_and_wait(unsigned wait_count, DWORD timeout_ms);
+    void wake_up();
+
+    void arm_wakeup_poll();
+    void arm_accept(SOCKET socket, SocketContext* context);
+    void arm_accept_retry(SOCKET socket, SocketContext* context);
+    void arm_recv(SOCKET socket, SocketContext* context);
+    bool arm_send(SOCKET socket, SocketContext* context);
+
+    void on_cqe(const io_uring_cqe& cqe, std::vector<IoCompletion>& completions);
+    void on_accept_cqe(SOCKET socket, SocketContext* context, const io_uring_cqe& cqe, std::vector<IoCompletion>& completions);
+    void on_recv_cqe(SOCKET socket, SocketContext* context, const io_uring_cqe& cqe, std::vector<IoCompletion>& completions);
+    void on_send_cqe(SOCKET socket, SocketContext* context, const io_uring_cqe& cqe, std::vector<IoCompletion>& completions);
+
+    static void fill_accept_io(AcceptIO* io, SOCKET socket);
+    int copy_recv_chunks(SocketContext* context, RecvIO* io);
+    void release_recv_chunks(SocketContext* context);
+    void recycle_recv_buffer(uint16_t buffer_id);
+    void push_recv_buffer(uint16_t buffer_id); // m_buffer_lock을 잡은 채로 부른다. tail은 부른 쪽이 올린다
+    void drain_posted_completions(std::vector<IoCompletion>& completions);
+
+private:
+    int m_ring_fd;
+    int m_event_fd;
+
+    // SQ / CQ 링 (mmap)
+    void* m_sq_ring;
+    size_t m_sq_ring_size;
+    void* m_cq_ring;
+    size_t m_cq_ring_size;
+    io_uring_sqe* m_sqes;
+    size_t m_sqes_size;
+
+    unsigned* m_sq_head;
+    unsigned* m_sq_tail;
+    unsigned m_sq_mask;
+    unsigned m_sq_entries;
+
+    unsigned* m_cq_head;
+    unsigned* m_cq_tail;
+    unsigned m_cq_mask;
+    io_uring_cqe* m_cqes;
+
+    std::mutex m_sq_lock;
+    std::mutex m_cq_lock;
+    std::atomic<bool> m_is_waiting;
+    std::atomic<bool> m_wakeup_pending;
+
+    // 멀티샷 recv가 골라 쓰는 버퍼와 그 버퍼를 커널에 건네는 링. 다 쓴 버퍼는 링의 tail에 바로 다시 넣는다 (SQE가 필요없다)
+    char* m_buffer_memory;
+    io_uring_buf_ring* m_buffer_ring;
+    size_t m_buffer_ring_size;
+    std::mutex m_buffer_lock;
+    uint16_t m_buffer_ring_tail;
+
+    std::mutex m_posted_lock;
+    std::vector<IoCompletion> m_posted_completions;
+
+    SocketTable<SocketContext> m_contexts;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "MessageArena.h"
+
+namespace
+{
+    thread_local MessageArena* t_current_arena = nullptr;
+}
+
+MessageArena::~MessageArena()
+{
+    // 아레나가 첫 블록을 쓰고 있으므로 블록보다 먼저 지운다
+    m_arena.reset();
+}
+
+void MessageArena::init(int initial_block_size)
+{
+    google::protobuf::ArenaOptions options;
+    if (0 < initial_block_size)
+    {
+        m_initial_block = std::make_unique<char[]>(initial_block_size);
+        options.initial_block = m_initial_block.get();
+        options.initial_block_size = initial_block_size;
+        // 첫 블록이 모자라면 그만한 블록을 더 받는다 (기본값은 8KB까지만 키운다)
+        options.start_block_size = initial_block_size;
+        options.max_block_size = initial_block_size;
+    }
+    options.block_alloc = &MessageArena::allocate_block;
+    options.block_dealloc = &MessageArena::deallocate_block;
+
+    m_arena = std::make_unique<google::protobuf::Arena>(options);
+}
+
+MessageArena* MessageArena::get_current()
+{
+    return t_current_arena;
+}
+
+void MessageArena::set_current(MessageArena* arena)
+{
+    t_current_arena = arena;
+}
+
+void MessageArena::reset()
+{
+    if (0 == m_created_since_reset)
+        return;
+
+    const long long used_bytes = static_cast<long long>(m_arena->SpaceUsed());
+    if (used_bytes > m_peak_used_bytes.load(std::memory_order_relaxed))
+        m_peak_used_bytes.store(used_bytes, std::memory_order_relaxed);
+
+    m_arena->Reset();
+    m_created_since_reset = 0;
+    m_reset_count.store(m_reset_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void* MessageArena::allocate_block(size_t size)
+{
+    // 아레나는 자기를 쓰는 스레드에서만 블록을 받으므로 그 스레드의 아레나에 센다
+    if (nullptr != t_current_arena)
+        t_current_arena->m_block_alloc_count.store(t_current_arena->m_block_alloc_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return ::malloc(size);
+}
+
+void MessageArena::deallocate_block(void* block, size_t)
+{
+    ::free(block);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <google/protobuf/arena.h>
+
+// 섹션 스레드가 받은 메시지를 디코딩하고 보낼 메시지를 만드는 protobuf 아레나
+// 섹션마다 하나씩 두고, 섹션 스레드가 task 묶음이나 tick을 끝낼 때 reset으로 한꺼번에 비운다
+// 메시지의 문자열과 repeated 필드를 하나씩 힙에 할당하지 않고 아레나 블록에서 잘라 쓴다
+// 첫 블록(message_arena_initial_block_size)은 직접 들고 있다가 reset 뒤에도 다시 쓰므로, 묶음 하나가 첫 블록 안에 들어가면 힙 할당이 없다
+// 아레나에서 만든 메시지는 reset 뒤에 쓰면 안 된다 (핸들러가 나중에 쓸 값은 복사해 둔다)
+class MessageArena
+{
+public:
+    MessageArena() = default;
+    ~MessageArena();
+    MessageArena(const MessageArena&) = delete;
+    MessageArena& operator=(const MessageArena&) = delete;
+
+public:
+    void init(int initial_block_size);
+
+    // 지금 스레드가 쓰는 아레나 (섹션 스레드가 아니거나 message_arena_mode가 꺼져 있으면 nullptr)
+    static MessageArena* get_current();
+    static void set_current(MessageArena* arena);
+
+    // 보낼 메시지도 여기서 만들면 필드를 힙에 할당하지 않는다 (do_send가 바로 직렬화하므로 묶음이 끝날 때까지만 살아 있으면 된다)
+    template<typename MessageT>
+    MessageT* create()
+    {
+        m_created_count.store(m_created_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        ++m_created_since_reset;
+        return google::protobuf::Arena::CreateMessage<MessageT>(m_arena.get());
+    }
+
+    // 만든 메시지가 있을 때만 비운다
+    void reset();
+
+public:
+    // 통계 (섹션 스레드가 쓰고 아무 스레드에서나 읽는다)
+    // block alloc은 첫 블록이 모자라 아레나가 힙에서 블록을 새로 받은 횟수
+    long long get_created_count() const { return m_created_count.load(std::memory_order_relaxed); }
+    long long get_block_alloc_count() const { return m_block_alloc_count.load(std::memory_order_relaxed); }
+    long long get_reset_count() const { return m_reset_count.load(std::memory_order_relaxed); }
+    long long get_peak_used_bytes() const { return m_peak_used_bytes.load(std::memory_order_relaxed); }
+
+private:
+    static void* allocate_block(size_t size);
+    static void deallocate_block(void* block, size_t size);
+
+private:
+    std::unique_ptr<char[]> m_initial_block;
+    std::unique_ptr<google::protobuf::Arena> m_arena;
+    long long m_created_since_reset = 0;
+
+    std::atomic<long long> m_created_count{ 0 };
+    std::atomic<long long> m_block_alloc_count{ 0 };
+    std::atomic<long long> m_reset_count{ 0 };
+    std::atomic<long long> m_peak_used_bytes{ 0 };
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+
+// 여러 스레드가 넣고 한 스레드만 꺼내는 락 없는 침습형 큐 (Dmitry Vyukov의 intrusive MPSC queue)
+// 원소가 MpscNode를 상속해 다음 노드 포인터를 직접 들고 있으므로 push에 할당도 복사도 없다 (exchange 한 번)
+// try_pop은 꺼내는 스레드 하나만 호출해야 하고, 한 원소는 동시에 한 큐에만 들어갈 수 있다
+// 큐는 원소를 소유하지 않는다
+struct MpscNode
+{
+    MpscNode() = default;
+    // 복사본은 어느 큐에도 들어있지 않은 새 노드다
+    MpscNode(const MpscNode&) {}
+    MpscNode& operator=(const MpscNode&) { return *this; }
+
+    std::atomic<MpscNode*> mpsc_next{ nullptr };
+};
+
+template<typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : m_head(&m_stub), m_tail(&m_stub) {}
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+public:
+    void push(T* value) { push_node(static_cast<MpscNode*>(value)); }
+
+    // 넣는 중인 스레드가 아직 연결을 마치지 않은 원소는 꺼내지 못하고 false를 돌려준다 (곧 다시 시도하면 된다)
+    bool try_pop(T*& out)
+    {
+        MpscNode* tail = m_tail;
+        MpscNode* next = tail->mpsc_next.load(std::memory_order_acquire);
+        if (&m_stub == tail)
+        {
+            if (nullptr == next)
+                return false;
+
+            m_tail = next;
+            tail = next;
+            next = next->mpsc_next.load(std::memory_order_acquire);
+        }
+
+        if (nullptr != next)
+        {
+            m_tail = next;
+            out = static_cast<T*>(tail);
+            return true;
+        }
+
+        if (tail != m_head.load(std::memory_order_acquire))
+            return false;
+
+        // 마지막 원소를 꺼내려면 뒤에 stub을 다시 붙여 tail이 가리킬 곳을 만든다
+        push_node(&m_stub);
+        next = tail->mpsc_next.load(std::memory_order_acquire);
+        if (nullptr == next)
+            return false;
+
+        m_tail = next;
+        out = static_cast<T*>(tail);
+        return true;
+    }
+
+    // 아무 스레드에서나 불러도 된다. 넣고 있는 중인 원소가 있으면 비어있지 않다고 본다
+    bool empty() const { return &m_stub == m_head.load(std::memory_order_acquire); }
+
+private:
+    void push_node(MpscNode* node)
+    {
+        node->mpsc_next.store(nullptr, std::memory_order_relaxed);
+        MpscNode* prev = m_head.exchange(node, std::memory_order_acq_rel);
+        prev->mpsc_next.store(node, std::memory_order_release);
+    }
+
+private:
+    // 넣는 쪽(head)과 꺼내는 쪽(tail)이 같은 캐시 라인을 두고 다투지 않도록 떨어뜨려 둔다
+    alignas(64) std::atomic<MpscNode*> m_head;
+    alignas(64) MpscNode* m_tail;
+    alignas(64) MpscNode m_stub;
+};
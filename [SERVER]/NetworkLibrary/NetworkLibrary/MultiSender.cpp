@@ -1,77 +1,435 @@
 ﻿#include "pch.h"
 #include "MultiSender.h"
+#include <unordered_set>
 
-MultiSender::MultiSender(Session* session) : m_owner(session)
+std::atomic<SendPolicy> MultiSender::s_send_policies[MultiSender::MAX_PROTOCOL_COUNT] = {};
+std::atomic<long long> MultiSender::s_send_call_count{ 0 };
+std::atomic<long long> MultiSender::s_sent_packet_count{ 0 };
+std::atomic<long long> MultiSender::s_dropped_packet_count{ 0 };
+std::atomic<long long> MultiSender::s_conflated_packet_count{ 0 };
+std::atomic<long long> MultiSender::s_slow_consumer_count{ 0 };
+std::atomic<long long> MultiSender::s_partial_send_count{ 0 };
+
+MultiSender::MultiSender(Session* session) : m_coalesce_buffer(nullptr), m_sending_flag(false), m_is_flush_deferred(false), m_owner(session)
 {
     m_send_io.set_session(session);
 }
 
 MultiSender::~MultiSender()
 {
-    
+    release_coalesce_buffer();
+}
+
+void MultiSender::set_send_policy(unsigned short protocol_number, SendPolicy policy)
+{
+    if (protocol_number >= MAX_PROTOCOL_COUNT)
+        return;
+
+    s_send_policies[protocol_number].store(policy, std::memory_order_relaxed);
+}
+
+SendPolicy MultiSender::get_send_policy(unsigned short protocol_number)
+{
+    if (protocol_number >= MAX_PROTOCOL_COUNT)
+        return SendPolicy::RELIABLE;
+
+    return s_send_policies[protocol_number].load(std::memory_order_relaxed);
 }
 
 bool MultiSender::register_packet(std::shared_ptr<Packet> packet)
 {
-    m_register_packet.push(packet);
-    
+    if (false == enqueue_packet(std::move(packet)))
+        return false;
+
+    // 섹션 스레드에서 보낸 패킷은 섹션이 task를 다 처리한 뒤(또는 지연 시간 뒤) 한 번에 내보낸다
+    if (SendFlushPolicy::IMMEDIATE != send_flush_policy)
+    {
+        NetworkSection* section = NetworkSection::get_current_section();
+        if (nullptr != section && section->defer_flush(m_owner, send_flush_policy))
+            return true;
+    }
+
+    return flush();
+}
+
+bool MultiSender::enqueue_packet(std::shared_ptr<Packet> packet)
+{
+    // 느린 클라이언트로 끊는 중이면 더 쌓지 않는다
+    if (m_is_slow_consumer.load(std::memory_order_relaxed))
+        return false;
+
+    // 받은 패킷(슬라이스)을 그대로 돌려보내면 m_buffer가 비어 있으므로, 보내는 쪽은 항상 자기 버퍼를 가진 복사본을 쓴다
+    // do_send와 섹션의 broadcast가 모두 여기를 지나므로 한 곳에서만 복사한다
+    if (packet->is_slice())
+        packet = xmake_shared(Packet, packet.get());
+
+    // 워커가 압축하는 중일 수 있으므로 크기와 packet_number는 압축 전 값을 쓴다
+    const int packet_size = packet->get_original_size();
+    if (m_queued_bytes.load(std::memory_order_relaxed) + packet_size > send_queue_max_bytes
+        || m_queued_packet_count.load(std::memory_order_relaxed) >= send_queue_max_packets)
+    {
+        // 버릴 수 있는 패킷이면 새 패킷을 버리고, 아니면 기다려도 따라잡지 못하는 클라이언트로 보고 끊는다
+        if (SendPolicy::RELIABLE != get_send_policy(packet->get_original_protocol()))
+        {
+            s_dropped_packet_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        disconnect_slow_consumer();
+        return false;
+    }
+
+    void* block = PacketBufferPool::get_instance().allocate(sizeof(RegisteredPacket));
+    RegisteredPacket* node = new (block) RegisteredPacket;
+    node->packet = std::move(packet);
+    m_register_packet.push(node);
+
+    const long long queued_bytes = m_queued_bytes.fetch_add(packet_size, std::memory_order_relaxed) + packet_size;
+    m_queued_packet_count.fetch_add(1, std::memory_order_relaxed);
+
+    // high watermark를 처음 넘은 시각을 남긴다. 이미 넘어 있었으면 얼마나 오래 넘어 있었는지 본다
+    if (queued_bytes > send_queue_high_watermark_bytes)
+    {
+        const long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        long long over_watermark_since = 0;
+        if (false == m_over_watermark_since.compare_exchange_strong(over_watermark_since, now, std::memory_order_relaxed))
+            check_slow_consumer();
+    }
+
+    return true;
+}
+
+void MultiSender::check_slow_consumer()
+{
+    const long long over_watermark_since = m_over_watermark_since.load(std::memory_order_relaxed);
+    if (0 == over_watermark_since || 0 >= slow_consumer_disconnect_ms || false == m_owner->is_connected())
+        return;
+
+    const long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (now - over_watermark_since > slow_consumer_disconnect_ms * 1000000LL)
+        disconnect_slow_consumer();
+}
+
+bool MultiSender::pop_registered_packet(std::shared_ptr<Packet>& out)
+{
+    RegisteredPacket* node = nullptr;
+    if (false == m_register_packet.try_pop(node))
+        return false;
+
+    out = std::move(node->packet);
+    node->~RegisteredPacket();
+    PacketBufferPool::get_instance().deallocate(node, sizeof(RegisteredPacket));
+    return true;
+}
+
+bool MultiSender::pop_next_packet(std::shared_ptr<Packet>& out)
+{
+    if (false == m_backlog.empty())
+    {
+        out = std::move(m_backlog.front());
+        m_backlog.pop_front();
+        return true;
+    }
+
+    return pop_registered_packet(out);
+}
+
+bool MultiSender::flush()
+{
     bool compare_to = false;
     if(true == m_sending_flag.compare_exchange_strong(compare_to, true))
         return send();
 
-
     return true;
 }
 
-bool MultiSender::on_send()
+bool MultiSender::on_send(int bytes_transferred)
 {
+    // 일부만 보내졌으면 패킷과 복사 버퍼를 잡아둔 채 나머지를 다시 보낸다 (0이면 끊기는 중이라 다시 보내지 않는다)
+    if(0 < bytes_transferred && bytes_transferred < m_send_size)
+        return resend_remaining(bytes_transferred);
+
+    // 보낼 것이 있었는데 0 바이트로 끝났으면 send가 실패했거나 끊기는 중이다 (엔진은 실패한 send도 0 바이트 완료로 돌려준다)
+    const bool is_failed = 0 == bytes_transferred && 0 < m_send_size;
+
     while(false == m_sending_packet.empty())
         m_sending_packet.pop();
+    release_coalesce_buffer();
+
+    release_queued(m_in_flight_size, m_in_flight_count);
+    m_in_flight_size = 0;
+    m_in_flight_count = 0;
+    m_send_size = 0;
+
+    // 다시 보내지 않는다. 플래그는 세운 채로 두어(finalize의 clear가 내린다) 더 보내지 않고, 잡아둔 세션은 놓는다
+    if(is_failed)
+    {
+        m_sending_owner.reset();
+        return false;
+    }
 
     if(false == is_register_queue_empty())
-        send();
-    else
-        m_sending_flag.store(false);
+        return send();
+
+    // 플래그를 내리면 다른 스레드가 바로 send를 걸 수 있으므로 그 전에 놓는다
+    m_sending_owner.reset();
+    m_sending_flag.store(false);
+
+    // 비어 있는 걸 확인한 뒤 플래그를 내리기 전에 들어온 패킷은 register_packet의 CAS가 실패했으므로 여기서 보낸다
+    if(false == m_register_packet.empty())
+        return flush();
     
     return true;
 }
 
 void MultiSender::clear()
 {
-    while (false == m_register_packet.empty())
-    {
-        std::shared_ptr<Packet> p;
-        m_register_packet.try_pop(p);
-    }
+    std::shared_ptr<Packet> p;
+    while (pop_registered_packet(p))
+        p.reset();
 
-    while (false == m_register_packet.empty())
+    while (false == m_sending_packet.empty())
         m_sending_packet.pop();
+
+    m_pending_packet.reset();
+    m_backlog.clear();
+    release_coalesce_buffer();
+    m_send_size = 0;
+    m_in_flight_size = 0;
+    m_in_flight_count = 0;
+
+    m_queued_bytes.store(0);
+    m_queued_packet_count.store(0);
+    m_over_watermark_since.store(0);
+    m_is_slow_consumer.store(false);
+
+    // 끊기는 중에 send가 실패하면 플래그가 세워진 채 남으므로, 세션을 다시 쓸 수 있게 내린다
+    m_sending_flag.store(false);
+    m_is_flush_deferred.store(false);
 }
 
 bool MultiSender::send()
 {
-    m_send_io.Clear();
+    // 밀려 있으면 보내기 전에 큐를 추린다
+    if(m_queued_bytes.load(std::memory_order_relaxed) > send_queue_high_watermark_bytes)
+        trim_backlog();
+
+    long long packet_count = 0;
 
-    while(false == m_register_packet.empty())
+    while(true)
     {
-        std::shared_ptr<Packet> packet;
-        
-        if(false == m_register_packet.try_pop(packet))
-            continue;
+        m_send_io.Clear();
+        m_send_size = 0;
+        int coalesced_size = 0;
+        bool is_last_coalesced = false;
+        bool is_waiting_compression = false;
+
+        while(true)
+        {
+            std::shared_ptr<Packet> packet = std::move(m_pending_packet);
+            if(nullptr == packet && false == pop_next_packet(packet))
+                break;
+
+            // 워커가 아직 압축 중인 패킷이면 순서를 지키기 위해 여기서 끊는다. 압축을 끝낸 워커가 다시 flush 한다
+            if(false == PacketCompressor::is_ready_or_wait(*packet, m_owner))
+            {
+                m_pending_packet = std::move(packet);
+                is_waiting_compression = true;
+                break;
+            }
+
+            const int packet_size = packet->get_size();
+            if(send_coalescing_mode && packet_size <= send_coalescing_threshold && packet_size <= send_coalescing_buffer_size)
+            {
+                // 버퍼가 차면 순서를 지키기 위해 여기서 끊고 나머지는 다음 send로 넘긴다
+                if(coalesced_size + packet_size > send_coalescing_buffer_size)
+                {
+                    m_pending_packet = std::move(packet);
+                    break;
+                }
+
+                if(nullptr == m_coalesce_buffer)
+                    m_coalesce_buffer = static_cast<char*>(PacketBufferPool::get_instance().allocate(send_coalescing_buffer_size));
+
+                // 복사했으니 패킷은 send 완료까지 잡아둘 필요가 없다
+                char* dest = m_coalesce_buffer + coalesced_size;
+                ::memcpy(dest, packet->get_buffer().data(), packet_size);
+                coalesced_size += packet_size;
+
+                if(is_last_coalesced)
+                {
+                    m_send_io.m_buffers.back().len += packet_size;
+                }
+                else
+                {
+                    WSABUF buf;
+                    buf.buf = dest;
+                    buf.len = packet_size;
+                    m_send_io.m_buffers.emplace_back(buf);
+                }
+                is_last_coalesced = true;
+            }
+            else
+            {
+                WSABUF buf;
+                buf.buf = packet->get_buffer().data();
+                buf.len = packet_size;
             
-        WSABUF buf;
-        buf.buf = packet->get_buffer().data();
-        buf.len = packet->get_size();
-        
-        m_send_io.m_buffers.emplace_back(buf);
-        m_sending_packet.push(packet);
+                m_send_io.m_buffers.emplace_back(buf);
+                m_sending_packet.push(packet);
+                is_last_coalesced = false;
+            }
+            m_send_size += packet_size;
+            m_in_flight_size += packet->get_original_size();
+            ++m_in_flight_count;
+            ++packet_count;
+        }
+
+        if(false == m_send_io.m_buffers.empty())
+            break;
+
+        if(is_waiting_compression)
+        {
+            // 압축을 기다리는 패킷이 맨 앞이라 보낼 게 없다. 플래그를 내리기 전에 압축이 끝났으면 워커의 flush는 실패했으므로 여기서 보낸다
+            std::shared_ptr<Packet> waiting_packet = m_pending_packet;
+            m_sending_owner.reset();
+            m_sending_flag.store(false);
+            if(PacketCompressor::is_ready(*waiting_packet))
+                return flush();
+            return true;
+        }
+
+        // 지연 flush 사이에 이전 send 완료가 이미 다 보낸 경우
+        m_sending_flag.store(false);
+        if(true == m_register_packet.empty())
+            return true;
+
+        // 다른 스레드가 push를 끝내지 못해 아직 꺼낼 수 없는 패킷이 있다
+        // 다시 flush를 부르며 재귀하면 그 스레드가 선점된 동안 스택이 넘치므로, 양보한 뒤 보내기 권한을 다시 얻어 반복한다
+        std::this_thread::yield();
+        bool compare_to = false;
+        if(false == m_sending_flag.compare_exchange_strong(compare_to, true))
+            return true;
+    }
+
+    s_send_call_count.fetch_add(1, std::memory_order_relaxed);
+    s_sent_packet_count.fetch_add(packet_count, std::memory_order_relaxed);
+
+    return post_send();
+}
+
+bool MultiSender::resend_remaining(int bytes_transferred)
+{
+    s_partial_send_count.fetch_add(1, std::memory_order_relaxed);
+
+    // 다 보낸 버퍼는 빼고, 걸쳐 있는 버퍼는 보낸 만큼 앞을 당긴다
+    std::vector<WSABUF>& buffers = m_send_io.m_buffers;
+    size_t skip = static_cast<size_t>(bytes_transferred);
+    size_t sent_buffer_count = 0;
+    while(skip >= buffers[sent_buffer_count].len)
+    {
+        skip -= buffers[sent_buffer_count].len;
+        ++sent_buffer_count;
     }
+    buffers[sent_buffer_count].buf += skip;
+    buffers[sent_buffer_count].len -= skip;
+    buffers.erase(buffers.begin(), buffers.begin() + sent_buffer_count);
+    m_send_size -= bytes_transferred;
+
+    // OVERLAPPED(InternalHigh 포함)만 새로 하고 버퍼는 그대로 쓴다
+    m_send_io.Init();
+    return post_send();
+}
+
+bool MultiSender::post_send()
+{
+    // 완료가 세션이 섹션에서 나간 뒤에 와도 세션이 살아 있게 한다
+    if(nullptr == m_sending_owner)
+        m_sending_owner = m_owner->weak_from_this().lock();
 
     bool is_not_pending = false;
     DWORD send_byte_size = 0;
-    
-    if(false == NetworkUtil::send(&m_send_io, is_not_pending, send_byte_size))
+
+    // 끊긴 세션이면 보내지 않는다 (소켓을 잡은 동안은 닫히지 않는다)
+    bool is_sent = false;
+    if(m_owner->acquire_socket())
+    {
+        is_sent = NetworkUtil::send(&m_send_io, is_not_pending, send_byte_size);
+        m_owner->release_socket();
+    }
+
+    if(false == is_sent)
+    {
+        // 끊기는 중이라 완료가 오지 않는다. 플래그는 세운 채로 두어 더 보내지 않고, 잡아둔 세션은 놓는다 (마지막 참조면 여기서 지워진다)
+        std::shared_ptr<Session> owner = std::move(m_sending_owner);
         return false;
+    }
 
     return true;
 }
+
+void MultiSender::trim_backlog()
+{
+    std::shared_ptr<Packet> packet;
+    while(pop_registered_packet(packet))
+        m_backlog.push_back(std::move(packet));
+
+    // CONFLATE 패킷은 같은 키의 마지막 것만 남긴다 (뒤에서부터 보며 이미 본 키면 버린다)
+    std::unordered_set<unsigned long long> conflate_keys;
+    for(auto it = m_backlog.rbegin(); it != m_backlog.rend(); ++it)
+    {
+        const unsigned short protocol_number = (*it)->get_original_protocol();
+        if(SendPolicy::CONFLATE != get_send_policy(protocol_number))
+            continue;
+
+        const unsigned long long conflate_key = (static_cast<unsigned long long>(protocol_number) << 32) | (*it)->get_conflate_key();
+        if(conflate_keys.insert(conflate_key).second)
+            continue;
+
+        release_queued((*it)->get_original_size(), 1);
+        s_conflated_packet_count.fetch_add(1, std::memory_order_relaxed);
+        it->reset();
+    }
+
+    // 그래도 high watermark를 넘으면 오래된 DROPPABLE 패킷부터 버린다
+    for(std::shared_ptr<Packet>& queued_packet : m_backlog)
+    {
+        if(m_queued_bytes.load(std::memory_order_relaxed) <= send_queue_high_watermark_bytes)
+            break;
+        if(nullptr == queued_packet || SendPolicy::DROPPABLE != get_send_policy(queued_packet->get_original_protocol()))
+            continue;
+
+        release_queued(queued_packet->get_original_size(), 1);
+        s_dropped_packet_count.fetch_add(1, std::memory_order_relaxed);
+        queued_packet.reset();
+    }
+
+    m_backlog.erase(std::remove(m_backlog.begin(), m_backlog.end(), nullptr), m_backlog.end());
+}
+
+void MultiSender::release_queued(int packet_size, int packet_count)
+{
+    const long long queued_bytes = m_queued_bytes.fetch_sub(packet_size, std::memory_order_relaxed) - packet_size;
+    m_queued_packet_count.fetch_sub(packet_count, std::memory_order_relaxed);
+    if(queued_bytes <= send_queue_high_watermark_bytes)
+        m_over_watermark_since.store(0, std::memory_order_relaxed);
+}
+
+void MultiSender::disconnect_slow_consumer()
+{
+    if(m_is_slow_consumer.exchange(true))
+        return;
+
+    s_slow_consumer_count.fetch_add(1, std::memory_order_relaxed);
+    std::cout << "slow consumer => session id " << m_owner->get_id() << ", queued " << get_queued_bytes() << " bytes, " << get_queued_packet_count() << " packets" << std::endl;
+    m_owner->do_disconnect();
+}
+
+void MultiSender::release_coalesce_buffer()
+{
+    if(nullptr == m_coalesce_buffer)
+        return;
+
+    PacketBufferPool::get_instance().deallocate(m_coalesce_buffer, send_coalescing_buffer_size);
+    m_coalesce_buffer = nullptr;
+}
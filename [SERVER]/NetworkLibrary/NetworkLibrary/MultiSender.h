@@ -1,6 +1,28 @@
 ﻿#pragma once
 #include <queue>
+#include <deque>
 
+// 세션 send 큐가 밀렸을 때 packet_number별로 패킷을 어떻게 다룰지 (MultiSender::set_send_policy)
+enum class SendPolicy : char
+{
+    RELIABLE,  // 버리지 않는다. 큐 최대를 넘으면 세션을 끊는다
+    DROPPABLE, // high watermark를 넘으면 오래된 것부터 버리고, 큐 최대를 넘으면 새 패킷을 버린다
+    CONFLATE,  // high watermark를 넘으면 같은 키(packet_number + Packet::set_conflate_key)의 마지막 것만 보내고, 큐 최대를 넘으면 새 패킷을 버린다
+};
+
+// 모든 세션의 send 큐 깊이를 모은 값 (NetworkSection::collect_send_queue_depth)
+struct SendQueueDepth
+{
+    long long total_bytes = 0;
+    long long max_bytes = 0;
+    int max_packet_count = 0;
+    int over_watermark_session_count = 0;
+};
+
+// 세션의 send 큐
+// 아무 스레드나 패킷을 넣고, m_sending_flag를 잡은 스레드 하나가 모아서 소켓에 넘긴다
+// 넣은 뒤 아직 다 보내지 못한 패킷(보내는 중인 것 포함)의 바이트와 수를 세어 send_queue_max_bytes / send_queue_max_packets를 넘지 않게 한다 (config.h)
+// 일부만 보내졌다는 완료가 오면 보낸 만큼만 버퍼를 당겨 나머지를 다시 보낸다
 class MultiSender
 {
 public:
@@ -8,20 +30,90 @@ public:
     ~MultiSender();
 
 public:
-    bool is_register_queue_empty() { return m_register_packet.empty(); }
+    bool is_register_queue_empty() { return m_register_packet.empty() && m_backlog.empty() && nullptr == m_pending_packet; }
 public:
     bool register_packet(std::shared_ptr<Packet> packet);
-    bool on_send();
+    // flush 없이 큐에만 넣는다. 큐 제한으로 버렸거나 느린 클라이언트로 끊었으면 false
+    bool enqueue_packet(std::shared_ptr<Packet> packet);
+    bool flush();
+    bool on_send(int bytes_transferred);
     void clear();
+    // 걸어둔 send가 끝날 때까지 세션을 잡아두는 참조 (완료를 처리하는 쪽이 복사해 두고 on_send를 부른다)
+    std::shared_ptr<Session> get_sending_owner() const { return m_sending_owner; }
+
+    // 섹션의 지연 flush 목록에 한 번만 오르도록 표시한다
+    bool try_mark_flush_deferred() { return false == m_is_flush_deferred.exchange(true); }
+    void clear_flush_deferred() { m_is_flush_deferred.store(false); }
+
+public:
+    // 서버를 열기 전에 부른다 (기본은 모두 RELIABLE)
+    static void set_send_policy(unsigned short protocol_number, SendPolicy policy);
+    static SendPolicy get_send_policy(unsigned short protocol_number);
+
+public:
+    // 이 세션의 send 큐 깊이 (아무 스레드에서나 읽는다)
+    long long get_queued_bytes() const { return m_queued_bytes.load(std::memory_order_relaxed); }
+    int get_queued_packet_count() const { return m_queued_packet_count.load(std::memory_order_relaxed); }
+    bool is_over_watermark() const { return 0 != m_over_watermark_since.load(std::memory_order_relaxed); }
+    // high watermark를 slow_consumer_disconnect_ms 넘게 계속 넘어 있으면 느린 클라이언트로 끊는다
+    // 패킷을 넣을 때와, 더 보내지 않는 세션도 끊기도록 섹션이 주기적으로 부른다
+    void check_slow_consumer();
+
+    // 소켓 send 요청 수와 그 요청으로 내보낸 패킷 수 (프로세스 전체 누적)
+    static long long get_send_call_count() { return s_send_call_count.load(std::memory_order_relaxed); }
+    static long long get_sent_packet_count() { return s_sent_packet_count.load(std::memory_order_relaxed); }
+    // 큐 제한으로 버린 패킷 수, CONFLATE로 합쳐 버린 패킷 수, 느린 클라이언트로 끊은 세션 수, 일부만 보내져 나머지를 다시 보낸 수 (프로세스 전체 누적)
+    static long long get_dropped_packet_count() { return s_dropped_packet_count.load(std::memory_order_relaxed); }
+    static long long get_conflated_packet_count() { return s_conflated_packet_count.load(std::memory_order_relaxed); }
+    static long long get_slow_consumer_count() { return s_slow_consumer_count.load(std::memory_order_relaxed); }
+    static long long get_partial_send_count() { return s_partial_send_count.load(std::memory_order_relaxed); }
 private:
+    // 한 패킷을 여러 세션에 broadcast 할 수 있어 Packet 자체를 큐 노드로 쓸 수 없으므로, 풀에서 빌린 노드에 담아 넣는다
+    struct RegisteredPacket : public MpscNode
+    {
+        std::shared_ptr<Packet> packet;
+    };
+
     bool send();
+    bool post_send();
+    bool resend_remaining(int bytes_transferred);
+    bool pop_registered_packet(std::shared_ptr<Packet>& out);
+    bool pop_next_packet(std::shared_ptr<Packet>& out);
+    void trim_backlog();
+    void release_queued(int packet_size, int packet_count);
+    void disconnect_slow_consumer();
+    void release_coalesce_buffer();
 
 private:
-    Concurrency::concurrent_queue<std::shared_ptr<Packet>> m_register_packet;
+    MpscQueue<RegisteredPacket> m_register_packet; // 아무 스레드나 넣고, m_sending_flag를 잡은 스레드만 꺼낸다
     std::queue<std::shared_ptr<Packet>> m_sending_packet; // send중인 패킷
+    std::shared_ptr<Packet> m_pending_packet; // 복사 버퍼가 차서 다음 send로 넘긴 패킷
+    std::deque<std::shared_ptr<Packet>> m_backlog; // high watermark를 넘어 큐에서 꺼내 추려둔 패킷 (m_register_packet보다 먼저 보낸다)
+    char* m_coalesce_buffer; // 작은 패킷을 이어 붙여 보내는 버퍼 (send 중에만 풀에서 빌린다)
+    int m_send_size = 0;       // 걸어둔 send의 남은 바이트
+    int m_in_flight_size = 0;  // 걸어둔 send에 담은 패킷의 큐 크기 합과 수 (send가 끝나야 큐 깊이에서 뺀다)
+    int m_in_flight_count = 0;
 
     std::atomic<bool> m_sending_flag;
+    std::atomic<bool> m_is_flush_deferred;
+
+    // 큐 깊이 (넣을 때 더하고, 다 보내거나 버릴 때 뺀다)
+    std::atomic<long long> m_queued_bytes{ 0 };
+    std::atomic<int> m_queued_packet_count{ 0 };
+    std::atomic<long long> m_over_watermark_since{ 0 }; // high watermark를 넘은 시각 (steady_clock ns). 아래면 0
+    std::atomic<bool> m_is_slow_consumer{ false };
+
+    static constexpr int MAX_PROTOCOL_COUNT = 256;
+    static std::atomic<SendPolicy> s_send_policies[MAX_PROTOCOL_COUNT];
+
+    static std::atomic<long long> s_send_call_count;
+    static std::atomic<long long> s_sent_packet_count;
+    static std::atomic<long long> s_dropped_packet_count;
+    static std::atomic<long long> s_conflated_packet_count;
+    static std::atomic<long long> s_slow_consumer_count;
+    static std::atomic<long long> s_partial_send_count;
 
     Session* m_owner;
+    std::shared_ptr<Session> m_sending_owner; // send가 걸려 있는 동안 세션이 지워지지 않게 잡아둔다 (shared_ptr로 만든 세션만)
     SendIO m_send_io;
 };
@@ -1,7 +1,13 @@
 #include "pch.h"
 
+namespace
+{
+    thread_local const NetworkCore* t_io_thread_owner = nullptr;
+    thread_local int t_io_thread_index = -1;
+}
+
 NetworkCore::NetworkCore()
-    :m_iocp_handle(nullptr)
+    :m_iocp_handle(nullptr), m_io_engine_type(IoEngineType::DEFAULT), m_io_thread_count(0)
 {
 }
 
@@ -10,8 +16,12 @@ NetworkCore::~NetworkCore()
     
 }
 
-void NetworkCore::init(int iocp_thread_count)
+void NetworkCore::init(int iocp_thread_count, IoEngineType io_engine_type)
 {
+#ifdef _WIN32
+    if (IoEngineType::DEFAULT != io_engine_type)
+        std::cout << get_io_engine_name(io_engine_type) << " is not supported on windows, use iocp" << std::endl;
+
     m_iocp_handle = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 0);
     if(nullptr == m_iocp_handle)
     {
@@ -19,16 +29,54 @@ void NetworkCore::init(int iocp_thread_count)
         // TODO: Crash
         return;
     }
+#else
+    IoEngine* engine = IoEngine::create(io_engine_type);
+    if(nullptr == engine)
+    {
+        std::cout << "IoEngine init Error" << std::endl;
+        // TODO: Crash
+        return;
+    }
+    m_iocp_handle = engine;
+    m_io_engine_type = engine->get_type();
+#endif
     
     m_is_running = true;
+    m_io_thread_count = iocp_thread_count;
     
     for(int i = 0; i < iocp_thread_count; ++i)
-        m_iocp_threads.emplace_back([this](){ iocp_thread_work(); });
+        m_iocp_threads.emplace_back([this, i](){ iocp_thread_work(i); });
 
 }
 
-void NetworkCore::iocp_thread_work()
+int NetworkCore::get_current_io_thread_index() const
+{
+    return this == t_io_thread_owner ? t_io_thread_index : -1;
+}
+
+void NetworkCore::iocp_thread_work(int io_thread_index)
 {
+    t_io_thread_owner = this;
+    t_io_thread_index = io_thread_index;
+
+#ifndef _WIN32
+    IoEngine* engine = static_cast<IoEngine*>(m_iocp_handle);
+    std::vector<IoCompletion> completions;
+
+    while(m_is_running == true)
+    {
+        completions.clear();
+        if(false == engine->get_queued_completions(completions, INFINITE))
+        {
+            std::cout << "get_queued_completions error: " << errno << std::endl;
+            // TODO: error log
+            continue;
+        }
+
+        for(IoCompletion& completion : completions)
+            on_iocp_io(completion.io, completion.bytes_transferred);
+    }
+#else
     while(m_is_running == true)
     {
         DWORD bytes_transferred = 0;
@@ -39,9 +87,14 @@ void NetworkCore::iocp_thread_work()
             const int err_no = ::WSAGetLastError();
             std::cout << "GQCS error: " << err_no << std::endl; 
             // TODO: error log
+
+            // 실패한 send/recv도 0 바이트 완료로 넘겨 세션이 끊기 처리를 하고 send 동안 잡아둔 참조를 놓게 한다
+            if (nullptr != io && (IoType::SEND == io->get_type() || IoType::RECV == io->get_type()))
+                on_iocp_io(io, 0);
             continue;
         }
 
         on_iocp_io(io, bytes_transferred);
     }
+#endif
 }
\ No newline at end of file
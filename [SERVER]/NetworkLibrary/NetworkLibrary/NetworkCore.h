@@ -9,25 +9,31 @@ public:
 
 public:
     HANDLE get_iocp_handle() { return m_iocp_handle; }
+    IoEngineType get_io_engine_type() const { return m_io_engine_type; }
     
 public:
-    virtual void init(int iocp_thread_count);
+    virtual void init(int iocp_thread_count, IoEngineType io_engine_type = IoEngineType::DEFAULT);
 public:
     bool is_running() { return m_is_running; }
+    int get_io_thread_count() const { return m_io_thread_count; }
+    // 지금 스레드가 이 코어의 I/O 스레드면 그 번호 (0 ~ get_io_thread_count() - 1), 아니면 -1
+    int get_current_io_thread_index() const;
 
 public:
     void push_packet(Packet* packet) { m_packet_queue.push(packet); }
     
 protected:
-    void iocp_thread_work();
+    void iocp_thread_work(int io_thread_index);
     virtual void on_iocp_io(NetworkIO* io, int bytes_transferred) abstract;
     
 protected:
     std::atomic<bool> m_is_running;
     
     HANDLE m_iocp_handle;
+    IoEngineType m_io_engine_type;
+    int m_io_thread_count;
     std::vector<std::thread> m_iocp_threads;
     
-    concurrency::concurrent_queue<Packet*> m_packet_queue;
+    MpscQueue<Packet> m_packet_queue; // I/O 스레드들이 넣고 ClientBase의 job 스레드 하나가 꺼낸다 (서버의 ClientSession은 섹션으로 바로 넘긴다)
 };
 
@@ -34,6 +34,7 @@ class AcceptIO : public NetworkIO
 public:
     AcceptIO() : NetworkIO(IoType::ACCEPT) { }
 
+    SOCKET m_listen_socket = INVALID_SOCKET; // 이 accept를 건 리슨 소켓 (다시 걸 때 쓴다)
     SOCKET m_socket;
     char m_accept_buffer[1024];
 };
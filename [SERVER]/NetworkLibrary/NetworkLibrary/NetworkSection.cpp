@@ -1,6 +1,11 @@
 ﻿#include "pch.h"
 #include "NetworkSection.h"
 
+namespace
+{
+    thread_local NetworkSection* t_current_section = nullptr;
+}
+
 void NetworkSection::init(ServerBase* owner, int section_id)
 {
     m_owner = owner;
@@ -20,6 +25,23 @@ void NetworkSection::init(ServerBase* owner, int section_id)
         m_send_count = 0;
         m_current_send_tps = 0;
     }
+
+    for (int i = 0; i < m_owner->get_io_thread_count(); ++i)
+        m_packet_queues.emplace_back(std::make_unique<SpscQueue<SectionPacket>>());
+    m_packet_sequence = 0;
+    m_has_remote_packets = false;
+    m_is_sleeping = false;
+
+    m_message_arena.init(message_arena_initial_block_size);
+
+    m_tick_rate = section_tick_rate;
+    if (0 < m_tick_rate)
+    {
+        m_tick_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / m_tick_rate));
+        m_tick_budget = m_tick_period;
+        if (0 < section_tick_budget_us)
+            m_tick_budget = std::min(m_tick_budget, std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::microseconds(section_tick_budget_us)));
+    }
     
     m_section_thread= std::thread([this](){ section_thread_work(); });
 }
@@ -35,64 +57,539 @@ HANDLE NetworkSection::get_iocp_handle()
     return m_owner->get_iocp_handle();
 }
 
-std::shared_ptr<ClientSession> NetworkSection::find_session(unsigned int session_id)
+std::shared_ptr<ClientSession> NetworkSection::find_session(int session_id)
 {
-    std::shared_lock<std::shared_mutex> lock(m_sessions_mutex);
-    auto it = m_sessions.find(session_id);
-    if (it == m_sessions.end())
+    std::shared_ptr<ClientSession> session = m_owner->get_session_registry().find(session_id);
+    if (nullptr == session)
         return nullptr;
-    return it->second;
+
+    std::shared_lock<std::shared_mutex> lock(m_sessions_mutex);
+    return contains_session(session) ? session : nullptr;
+}
+
+bool NetworkSection::contains_session(const std::shared_ptr<ClientSession>& session) const
+{
+    const int index = session->get_section_index();
+    return 0 <= index && index < static_cast<int>(m_sessions.size()) && m_sessions[index] == session;
+}
+
+bool NetworkSection::erase_session(const std::shared_ptr<ClientSession>& session)
+{
+    if (false == contains_session(session))
+        return false;
+
+    const int index = session->get_section_index();
+    if (index != static_cast<int>(m_sessions.size()) - 1)
+    {
+        m_sessions[index] = std::move(m_sessions.back());
+        m_sessions[index]->set_section_index(index);
+    }
+    m_sessions.pop_back();
+    m_session_count.store(static_cast<int>(m_sessions.size()), std::memory_order_relaxed);
+    session->set_section_index(-1);
+    return true;
+}
+
+long long NetworkSection::get_queued_count() const
+{
+    const unsigned long long executed_count = m_executed_packet_count.load(std::memory_order_relaxed);
+    const unsigned long long pushed_count = m_packet_sequence.load(std::memory_order_relaxed);
+    const long long packet_count = pushed_count > executed_count ? static_cast<long long>(pushed_count - executed_count) : 0;
+    return packet_count + m_ready_task_count.load(std::memory_order_relaxed);
+}
+
+void NetworkSection::collect_send_queue_depth(SendQueueDepth& depth) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_sessions_mutex);
+    for (const std::shared_ptr<ClientSession>& session : m_sessions)
+    {
+        const MultiSender& multi_sender = session->get_multi_sender();
+        const long long queued_bytes = multi_sender.get_queued_bytes();
+        depth.total_bytes += queued_bytes;
+        depth.max_bytes = std::max(depth.max_bytes, queued_bytes);
+        depth.max_packet_count = std::max(depth.max_packet_count, multi_sender.get_queued_packet_count());
+        if (multi_sender.is_over_watermark())
+            ++depth.over_watermark_session_count;
+    }
 }
 
 void NetworkSection::enter_section(std::shared_ptr<ClientSession> session)
 {
     {
         std::unique_lock<std::shared_mutex> lock(m_sessions_mutex);
-        if (m_sessions.count(session->get_id()) != 0)
+        if (-1 != session->get_section_index())
         {
             session->do_disconnect();
             return;
         }
-        m_sessions.emplace(session->get_id(), session);
+        session->set_section_index(static_cast<int>(m_sessions.size()));
         session->set_section(shared_from_this());
+        m_sessions.push_back(std::move(session));
+        m_session_count.store(static_cast<int>(m_sessions.size()), std::memory_order_relaxed);
     }
 }
 
-void NetworkSection::exit_section(int session_id)
+void NetworkSection::exit_section(std::shared_ptr<ClientSession> session)
 {
-    std::unique_lock<std::shared_mutex> lock(m_sessions_mutex);
-    auto it = m_sessions.find(session_id);
-    if (it == m_sessions.end())
+    {
+        std::unique_lock<std::shared_mutex> lock(m_sessions_mutex);
+        if (false == erase_session(session))
+            return;
+        session->set_section(nullptr);
+    }
+
+    if (this == get_current_section())
         return;
-    it->second->set_section(nullptr);
-    m_sessions.erase(it);
+
+    iTask* task = xnew iTask;
+    task->func = [session = std::move(session)]() {};
+    push_task(task);
 }
 
 void NetworkSection::push_task(iTask* task)
 {
     task->execute_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(task->delay_time);
-    m_task_queue.push(task);
+    enqueue_task(task);
+}
+
+void NetworkSection::enqueue_task(iTask* task)
+{
+    m_task_inbox.push(task);
+    wake_up();
+}
+
+TimerHandle NetworkSection::push_timer(iTask* task)
+{
+    task->cancel_flag = std::make_shared<std::atomic<bool>>(false);
+    TimerHandle handle(task->cancel_flag);
+    push_task(task);
+    return handle;
+}
+
+void NetworkSection::push_packet(Packet* packet)
+{
+    SectionPacket entry;
+    entry.sequence = m_packet_sequence.fetch_add(1, std::memory_order_relaxed);
+    entry.packet = packet;
+    entry.session_id = packet->get_owner()->get_id();
+
+    const int io_thread_index = m_owner->get_current_io_thread_index();
+    if (0 <= io_thread_index && io_thread_index < static_cast<int>(m_packet_queues.size()))
+    {
+        m_packet_queues[io_thread_index]->push(std::move(entry));
+        wake_up();
+    }
+    else
+        push_remote_packet(std::move(entry));
+}
+
+void NetworkSection::push_remote_packet(SectionPacket&& entry)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_remote_packets_mutex);
+        m_remote_packets.push_back(std::move(entry));
+        m_has_remote_packets.store(true, std::memory_order_release);
+    }
+
+    wake_up();
+}
+
+bool NetworkSection::migrate_session(std::shared_ptr<ClientSession> session, std::shared_ptr<NetworkSection> target)
+{
+    if (nullptr == session || nullptr == target || this == target.get())
+        return false;
+
+    // 이걸 잡은 뒤로는 이 섹션에 이 세션의 패킷이 더 들어오지 않는다
+    std::lock_guard<std::mutex> dispatch_lock(session->get_dispatch_mutex());
+    {
+        std::shared_lock<std::shared_mutex> lock(m_sessions_mutex);
+        if (false == contains_session(session) || nullptr != session->get_arriving_section())
+            return false;
+        session->set_arriving_section(target.get());
+    }
+    session->set_section(target);
+
+    // 이 표시보다 앞선 순번의 패킷이 이 세션이 이 섹션에서 받은 마지막 패킷들이다
+    SectionPacket entry;
+    entry.session_id = session->get_id();
+    entry.migration = xnew SessionMigration{ std::move(session), std::move(target), std::chrono::steady_clock::now() };
+    entry.sequence = m_packet_sequence.fetch_add(1, std::memory_order_relaxed);
+    push_remote_packet(std::move(entry));
+    return true;
+}
+
+void NetworkSection::hand_over_session(SessionMigration* migration)
+{
+    // 이미 들어와 있던 task도 넘기기 전에 실행한다 (실행 중 다시 넣은 반복 task는 빼고)
+    drain_task_inbox();
+    for (size_t ready_count = m_ready_tasks.size(); 0 < ready_count; --ready_count)
+    {
+        iTask* task = m_ready_tasks.front();
+        m_ready_tasks.pop_front();
+        execute_task(task);
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(m_sessions_mutex);
+        erase_session(migration->session);
+    }
+
+    // 도착할 섹션의 순번으로 다시 넣어, 그 섹션이 이미 받아 들고 있는 패킷 뒤에서 넘겨받게 한다
+    NetworkSection* target = migration->target.get();
+    SectionPacket entry;
+    entry.session_id = migration->session->get_id();
+    entry.migration = migration;
+    entry.sequence = target->m_packet_sequence.fetch_add(1, std::memory_order_relaxed);
+    target->push_remote_packet(std::move(entry));
+}
+
+void NetworkSection::take_over_session(SessionMigration* migration)
+{
+    std::shared_ptr<ClientSession>& session = migration->session;
+    std::vector<SectionPacket> arrived_packets;
+    auto it = m_arriving_packets.find(session->get_id());
+    if (it != m_arriving_packets.end())
+    {
+        arrived_packets = std::move(it->second);
+        m_arriving_packets.erase(it);
+    }
+
+    // 옮기는 중에 끊겼으면 들어가지 않는다 (끊을 때 id를 무효로 만든 뒤 섹션 락을 잡으므로 락 안에서 본다)
+    SessionRegistry& registry = m_owner->get_session_registry();
+    bool is_alive = false;
+    {
+        std::unique_lock<std::shared_mutex> lock(m_sessions_mutex);
+        is_alive = registry.is_alive(session->get_id());
+        if (is_alive)
+        {
+            session->set_section_index(static_cast<int>(m_sessions.size()));
+            m_sessions.push_back(session);
+            m_session_count.store(static_cast<int>(m_sessions.size()), std::memory_order_relaxed);
+        }
+    }
+    session->set_arriving_section(nullptr);
+
+    for (SectionPacket& entry : arrived_packets)
+    {
+        if (is_alive && registry.is_alive(entry.session_id))
+            session->execute_packet(entry.packet);
+        else
+            xdelete entry.packet;
+    }
+
+    const long long pause_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - migration->start_time).count();
+    m_migrated_in_count.fetch_add(1, std::memory_order_relaxed);
+    m_migration_pause_total_us.fetch_add(pause_us, std::memory_order_relaxed);
+    if (pause_us > m_migration_pause_max_us.load(std::memory_order_relaxed))
+        m_migration_pause_max_us.store(pause_us, std::memory_order_relaxed);
+
+    xdelete migration;
 }
 
 void NetworkSection::broadcast(std::shared_ptr<Packet> packet)
 {
+    if (nullptr == packet)
+        return;
+
     std::shared_lock<std::shared_mutex> lock(m_sessions_mutex);
     for (auto& session : m_sessions)
-        session.second->do_send(packet);
+        broadcast_to(packet, *session);
 }
 
 void NetworkSection::broadcast(std::shared_ptr<Packet> packet, Session* exception_session)
 {
+    if (nullptr == packet)
+        return;
+
     std::shared_lock<std::shared_mutex> lock(m_sessions_mutex);
     for (auto& session : m_sessions)
     {
-        if (session.second->get_id() == exception_session->get_id()) continue;
-        session.second->do_send(packet);
+        if (session.get() == exception_session) continue;
+        broadcast_to(packet, *session);
+    }
+}
+
+void NetworkSection::broadcast_to(const std::shared_ptr<Packet>& packet, ClientSession& session)
+{
+    // 섹션 스레드에서는 큐에만 넣어두고, 한 묶음 동안 몇 번을 broadcast 하든 세션마다 send는 묶음 끝에 한 번만 한다
+    if (deferred_broadcast_mode && this == get_current_section())
+    {
+        const SendFlushPolicy policy = SendFlushPolicy::IMMEDIATE == send_flush_policy ? SendFlushPolicy::END_OF_BATCH : send_flush_policy;
+        if (performance_check_mode)
+            increment_send_count_for_tps();
+
+        session.get_multi_sender().enqueue_packet(packet);
+        if (defer_flush(&session, policy))
+            return;
+
+        session.get_multi_sender().flush();
+        return;
+    }
+
+    session.do_send(packet);
+}
+
+NetworkSection* NetworkSection::get_current_section()
+{
+    return t_current_section;
+}
+
+bool NetworkSection::defer_flush(Session* session, SendFlushPolicy policy)
+{
+    std::weak_ptr<Session> weak_session = session->weak_from_this();
+    if (weak_session.expired())
+        return false;
+
+    // 이미 목록에 있으면 그때 함께 나간다
+    if (false == session->get_multi_sender().try_mark_flush_deferred())
+        return true;
+
+    auto flush_time = std::chrono::steady_clock::now();
+    if (SendFlushPolicy::DELAYED == policy)
+        flush_time += std::chrono::microseconds(send_flush_delay_us);
+
+    m_deferred_flushes.push_back({ std::move(weak_session), flush_time });
+    return true;
+}
+
+void NetworkSection::drain_task_inbox()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    iTask* task = nullptr;
+    while (m_task_inbox.try_pop(task))
+    {
+        if (task->execute_time <= now)
+            m_ready_tasks.push_back(task);
+        else
+            m_timer_wheel.add(task);
+    }
+
+    m_timer_wheel.advance(now, m_ready_tasks);
+}
+
+void NetworkSection::execute_task(iTask* task)
+{
+    if (task->is_cancelled())
+    {
+        xdelete task;
+        return;
+    }
+
+    // 세션이 이 섹션을 떠났으면 실행 시각은 그대로 두고 옮겨간 섹션으로 넘긴다 (넘기기 전까지는 이 섹션에 남아 있다)
+    if (0 != task->session_id)
+    {
+        std::shared_ptr<ClientSession> session = m_owner->get_session_registry().find(task->session_id);
+        bool is_departed = false;
+        if (nullptr != session)
+        {
+            std::shared_lock<std::shared_mutex> lock(m_sessions_mutex);
+            is_departed = false == contains_session(session);
+        }
+
+        std::shared_ptr<NetworkSection> section = is_departed ? session->get_section() : nullptr;
+        if (nullptr != section && this != section.get())
+        {
+            section->enqueue_task(task);
+            return;
+        }
+    }
+
+    // 나중에 들어온게 먼저 끝난다면? -> 원자성 있게 DB 작업 한 번 만 하도록 하기
+    task->func();
+
+    if (nullptr != task->post_processing_func)
+        task->post_processing_func();
+
+    if(task->is_repeat && false == task->is_cancelled())
+    {
+        task->execute_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(task->delay_time);
+        if (0 < task->delay_time)
+            m_timer_wheel.add(task);
+        else
+            m_ready_tasks.push_back(task);
+    }
+    else
+        xdelete task;
+}
+
+int NetworkSection::execute_packets(int max_count)
+{
+    int executed_count = 0;
+    while (executed_count < max_count)
+    {
+        // 같은 세션의 앞선 패킷이 I/O 스레드가 아닌 곳에서 들어왔을 수 있으므로 고를 때마다 확인한다
+        if (m_has_remote_packets.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(m_remote_packets_mutex);
+            for (SectionPacket& entry : m_remote_packets)
+                m_pending_remote_packets.push_back(std::move(entry));
+            m_remote_packets.clear();
+            m_has_remote_packets.store(false, std::memory_order_relaxed);
+        }
+
+        SectionPacket* next = nullptr;
+        SpscQueue<SectionPacket>* next_queue = nullptr;
+        for (auto& queue : m_packet_queues)
+        {
+            SectionPacket* front = queue->front();
+            if (nullptr != front && (nullptr == next || front->sequence < next->sequence))
+            {
+                next = front;
+                next_queue = queue.get();
+            }
+        }
+
+        if (false == m_pending_remote_packets.empty() && (nullptr == next || m_pending_remote_packets.front().sequence < next->sequence))
+        {
+            next = &m_pending_remote_packets.front();
+            next_queue = nullptr;
+        }
+
+        if (nullptr == next)
+            break;
+
+        SectionPacket entry = std::move(*next);
+        if (nullptr != next_queue)
+            next_queue->pop();
+        else
+            m_pending_remote_packets.pop_front();
+        ++executed_count;
+        m_executed_packet_count.store(m_executed_packet_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (nullptr != entry.migration)
+        {
+            if (this == entry.migration->target.get())
+                take_over_session(entry.migration);
+            else
+                hand_over_session(entry.migration);
+            continue;
+        }
+
+        if (false == m_owner->get_session_registry().is_alive(entry.session_id))
+        {
+            xdelete entry.packet;
+            continue;
+        }
+
+        // 옮겨오는 중인 세션의 패킷은 떠난 섹션이 앞선 패킷을 다 실행할 때까지 들고 있는다
+        ClientSession* owner = static_cast<ClientSession*>(entry.packet->get_owner());
+        if (this == owner->get_arriving_section())
+        {
+            m_arriving_packets[entry.session_id].push_back(std::move(entry));
+            continue;
+        }
+        owner->execute_packet(entry.packet);
+    }
+
+    return executed_count;
+}
+
+void NetworkSection::wait_for_work()
+{
+    const auto now = std::chrono::steady_clock::now();
+    auto wake_time = now + std::chrono::milliseconds(MAX_IDLE_WAIT_MS);
+    std::chrono::steady_clock::time_point timer_deadline;
+    if (m_timer_wheel.get_next_deadline(timer_deadline))
+    {
+        // 깨어나는 데 걸리는 시간만큼 일찍 일어나 남은 시간은 돌면서 기다린다
+        timer_deadline -= std::chrono::microseconds(TIMER_SPIN_US);
+        if (timer_deadline <= now)
+            return;
+        wake_time = std::min(wake_time, timer_deadline);
+    }
+    if (false == m_deferred_flushes.empty())
+        wake_time = std::min(wake_time, m_deferred_flushes.front().flush_time);
+
+    std::unique_lock<std::mutex> lock(m_wake_mutex);
+    m_is_sleeping.store(true, std::memory_order_relaxed);
+
+    // 넣는 쪽은 넣은 뒤 m_is_sleeping을 보고, 여기서는 m_is_sleeping을 올린 뒤 큐를 보므로 둘 중 한 쪽은 상대를 본다
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool has_work = false == m_task_inbox.empty() || m_has_remote_packets.load(std::memory_order_relaxed);
+    for (auto& queue : m_packet_queues)
+        has_work = has_work || nullptr != queue->front();
+
+    if (false == has_work)
+    {
+        m_wake_cv.wait_until(lock, wake_time);
+        m_idle_time += std::chrono::steady_clock::now() - now;
+    }
+    m_is_sleeping.store(false, std::memory_order_relaxed);
+}
+
+void NetworkSection::wake_up()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (false == m_is_sleeping.load(std::memory_order_relaxed))
+        return;
+
+    // 섹션 스레드가 잠들기 직전이면 wait에 들어갈 때까지 기다렸다가 깨운다
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+    }
+    m_wake_cv.notify_one();
+}
+
+void NetworkSection::update_load_signals()
+{
+    m_ready_task_count.store(static_cast<int>(m_ready_tasks.size()), std::memory_order_relaxed);
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto elapsed = now - m_load_window_start;
+    if (elapsed < std::chrono::milliseconds(section_load_window_ms))
+        return;
+
+    const double idle_ratio = std::chrono::duration<double>(m_idle_time).count() / std::chrono::duration<double>(elapsed).count();
+    m_load.store(std::clamp(1.0 - idle_ratio, 0.0, 1.0), std::memory_order_relaxed);
+    m_load_window_start = now;
+    m_idle_time = std::chrono::steady_clock::duration::zero();
+
+    // 부하를 새로 잴 때마다(section_load_window_ms) 같이 본다
+    check_slow_consumers();
+}
+
+void NetworkSection::check_slow_consumers()
+{
+    std::shared_lock<std::shared_mutex> lock(m_sessions_mutex);
+    for (const std::shared_ptr<ClientSession>& session : m_sessions)
+        session->get_multi_sender().check_slow_consumer();
+}
+
+void NetworkSection::flush_deferred_sends(bool is_forced)
+{
+    if (m_deferred_flushes.empty())
+        return;
+
+    const auto now = std::chrono::steady_clock::now();
+    while (false == m_deferred_flushes.empty() && (is_forced || m_deferred_flushes.front().flush_time <= now))
+    {
+        std::shared_ptr<Session> session = m_deferred_flushes.front().session.lock();
+        m_deferred_flushes.pop_front();
+        if (nullptr == session)
+            continue;
+
+        session->get_multi_sender().clear_flush_deferred();
+        session->get_multi_sender().flush();
     }
 }
 
 void NetworkSection::section_thread_work()
 {
+    t_current_section = this;
+    MessageArena::set_current(message_arena_mode ? &m_message_arena : nullptr);
+    m_load_window_start = std::chrono::steady_clock::now();
+
+    if (0 < m_tick_rate)
+        tick_loop();
+    else
+        event_loop();
+}
+
+void NetworkSection::event_loop()
+{
+    int batch_task_count = 0;
+
     while(m_owner->is_running() == true)
     {
         if (performance_check_mode)
@@ -101,39 +598,112 @@ void NetworkSection::section_thread_work()
             update_recv_tps_info();
             update_send_tps_info();
         }
-        
-        if(m_task_queue.empty()) 
+
+        drain_task_inbox();
+
+        // 받은 패킷을 먼저 실행하고, 실행 시각이 된 task가 있으면 하나 실행한다
+        int executed_count = execute_packets(MAX_TASK_BATCH - batch_task_count);
+
+        if(false == m_ready_tasks.empty())
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            continue;
+            iTask* task = m_ready_tasks.front();
+            m_ready_tasks.pop_front();
+            execute_task(task);
+            ++executed_count;
         }
-        
-        iTask* task = nullptr;
-        if(false == m_task_queue.try_pop(task)) continue;
-        
-        if(std::chrono::steady_clock::now() < task->execute_time)
+
+        // 실행할 게 없거나 한 묶음을 처리했으면 미뤄둔 send를 내보낸다
+        batch_task_count += executed_count;
+        if(0 == executed_count || batch_task_count >= MAX_TASK_BATCH)
         {
-            m_task_queue.push(task);
-            continue;
+            flush_deferred_sends();
+            m_message_arena.reset();
+            batch_task_count = 0;
         }
 
-        // 나중에 들어온게 먼저 끝난다면? -> 원자성 있게 DB 작업 한 번 만 하도록 하기
-        task->func();
+        update_load_signals();
+
+        if(0 == executed_count)
+            wait_for_work();
+    }
+}
+
+void NetworkSection::tick_loop()
+{
+    const double tick_period_seconds = std::chrono::duration<double>(m_tick_period).count();
+    auto next_tick_time = std::chrono::steady_clock::now() + m_tick_period;
+
+    while(m_owner->is_running() == true)
+    {
+        // 깨어나는 데 걸리는 시간만큼 일찍 일어나 남은 시간은 돌면서 기다린다
+        const auto wait_start_time = std::chrono::steady_clock::now();
+        const auto wake_time = next_tick_time - std::chrono::microseconds(TIMER_SPIN_US);
+        if (wait_start_time < wake_time)
+            std::this_thread::sleep_until(wake_time);
+        while (std::chrono::steady_clock::now() < next_tick_time) {}
+        m_idle_time += std::chrono::steady_clock::now() - wait_start_time;
+
+        const auto lateness = std::chrono::steady_clock::now() - next_tick_time;
+        if (lateness > m_tick_period / LATE_TICK_DIVISOR)
+            m_late_tick_count.fetch_add(1, std::memory_order_relaxed);
 
-        if (nullptr != task->post_processing_func)
-            task->post_processing_func();
+        // 주기 하나 이상 밀렸으면 그만큼 tick을 놓친 것이다. 다음 tick은 원래 박자에 맞춘다
+        const long long missed_count = lateness / m_tick_period;
+        next_tick_time += m_tick_period * (1 + missed_count);
 
-         if(task->is_repeat)
+        long long run_count = 1;
+        double delta_time = tick_period_seconds;
+        if (0 < missed_count)
         {
-            task->execute_time = std::chrono::steady_clock::now() + std::chrono::microseconds(task->delay_time);
-            m_task_queue.push(task);
+            if (TickCatchUpPolicy::CATCH_UP == section_tick_catch_up_policy)
+                run_count = std::min<long long>(1 + missed_count, std::max(1, section_max_catch_up_ticks));
+            else
+                delta_time *= static_cast<double>(1 + missed_count);
+            m_skipped_tick_count.fetch_add(1 + missed_count - run_count, std::memory_order_relaxed);
         }
-        else
-            xdelete task;
-            
+
+        for (long long i = 0; i < run_count; ++i)
+        {
+            const auto tick_start_time = std::chrono::steady_clock::now();
+            run_tick(delta_time, tick_start_time + m_tick_budget);
+
+            const auto work_time = std::chrono::steady_clock::now() - tick_start_time;
+            if (work_time > m_tick_budget)
+                m_overrun_tick_count.fetch_add(1, std::memory_order_relaxed);
+            m_max_tick_work_us = std::max<long long>(m_max_tick_work_us, std::chrono::duration_cast<std::chrono::microseconds>(work_time).count());
+
+            if (performance_check_mode)
+            {
+                update_fps_info();
+                update_recv_tps_info();
+                update_send_tps_info();
+            }
+        }
+
+        update_load_signals();
     }
 }
 
+void NetworkSection::run_tick(double delta_time, std::chrono::steady_clock::time_point budget_end)
+{
+    drain_task_inbox();
+
+    // 예산 안에서 받은 패킷을 처리하고, 남은 패킷은 다음 tick으로 넘긴다
+    while (std::chrono::steady_clock::now() < budget_end && 0 < execute_packets(MAX_TASK_BATCH)) {}
+
+    // tick을 시작할 때 실행 시각이 된 task만 실행한다 (실행 중에 다시 넣은 반복 task는 다음 tick에)
+    for (size_t ready_count = m_ready_tasks.size(); 0 < ready_count && std::chrono::steady_clock::now() < budget_end; --ready_count)
+    {
+        iTask* task = m_ready_tasks.front();
+        m_ready_tasks.pop_front();
+        execute_task(task);
+    }
+
+    on_tick(delta_time);
+    flush_deferred_sends(true);
+    m_message_arena.reset();
+}
+
 void NetworkSection::update_fps_info()
 {
     m_frame_count++;
@@ -145,6 +715,8 @@ void NetworkSection::update_fps_info()
     {
         m_current_fps = m_frame_count / delta_time;
         m_frame_count = 0;
+        m_current_max_tick_work_us = m_max_tick_work_us;
+        m_max_tick_work_us = 0;
         m_last_frame_time = current_time;
     }
 }
@@ -1,12 +1,7 @@
 ﻿#pragma once
-
-struct task_cmp
-{
-    bool operator()(const iTask* a, const iTask* b) const
-    {
-        return a->execute_time > b->execute_time;
-    }
-};
+#include <deque>
+#include <unordered_map>
+#include <condition_variable>
 
 class NetworkSection : public std::enable_shared_from_this<NetworkSection>
 {
@@ -24,18 +19,71 @@ public:
     NetworkCore* get_network_core() { return m_owner; }
 
 public:
-    std::shared_ptr<ClientSession> find_session(unsigned int session_id);
+    // 서버의 SessionRegistry에서 찾고, 이 섹션에 있는 세션일 때만 돌려준다
+    std::shared_ptr<ClientSession> find_session(int session_id);
+    int get_session_count() const { return m_session_count.load(std::memory_order_relaxed); }
+
+    // 섹션을 고를 때 쓰는 부하 지표 (락 없이 아무 스레드에서나 읽는다)
+    // 아직 실행하지 않은 패킷과 실행 시각이 된 task 수
+    long long get_queued_count() const;
+    // 지난 section_load_window_ms 동안 섹션 스레드가 잠들거나 tick을 기다리지 않고 일한 시간의 비율 (0 ~ 1)
+    double get_load() const { return m_load.load(std::memory_order_relaxed); }
+    // 이 섹션 세션들의 send 큐 깊이를 depth에 더한다 (아무 스레드에서나)
+    void collect_send_queue_depth(struct SendQueueDepth& depth) const;
 
 public:
     virtual void enter_section(std::shared_ptr<ClientSession> session);
-    virtual void exit_section(int session_id);
+    // 섹션이 쥔 참조는 섹션 스레드에서 놓는다 (섹션 스레드가 이 세션의 패킷을 실행하는 중일 수 있으므로)
+    virtual void exit_section(std::shared_ptr<ClientSession> session);
+    // 이 섹션의 session을 target으로 옮긴다 (아무 스레드에서나). 이 섹션에 없거나 이미 옮기는 중이면 false
+    // 부른 뒤로 받은 패킷은 target으로 가고, 이 섹션은 그 전에 받은 패킷과 실행 시각이 된 task를 다 실행한 뒤 target에 넘긴다
+    // target은 넘겨받을 때까지 이 세션의 패킷을 들고 있으므로 패킷은 순서대로 한 번씩만 실행된다
+    bool migrate_session(std::shared_ptr<ClientSession> session, std::shared_ptr<NetworkSection> target);
+    // delay_time(ms) 뒤에 섹션 스레드에서 실행한다 (0이면 바로)
     void push_task(iTask* task);
+    // push_task와 같고, 실행 전에 취소할 수 있는 핸들을 돌려준다
+    TimerHandle push_timer(iTask* task);
+    // 받은 패킷을 섹션 스레드에서 실행하도록 넘긴다 (I/O 스레드에서는 그 스레드 전용 큐로 락 없이 들어간다)
+    void push_packet(Packet* packet);
 
     void broadcast(std::shared_ptr<Packet> packet);
     void broadcast(std::shared_ptr<Packet> packet, Session* exception_session);
+    // 메시지는 한 번만 직렬화하고 그 패킷을 모든 세션이 같이 보낸다
+    template<typename MessageT, typename = std::enable_if_t<std::is_base_of_v<google::protobuf::Message, MessageT>>>
+    void broadcast(const MessageT& message) { broadcast(Packet::create(message)); }
+    template<typename MessageT, typename = std::enable_if_t<std::is_base_of_v<google::protobuf::Message, MessageT>>>
+    void broadcast(const MessageT& message, Session* exception_session) { broadcast(Packet::create(message), exception_session); }
+private:
+    void broadcast_to(const std::shared_ptr<Packet>& packet, ClientSession& session);
+
+public:
+    // 지금 스레드가 섹션 스레드면 그 섹션 (아니면 nullptr)
+    static NetworkSection* get_current_section();
+    // policy에 따라 세션의 send를 미뤄둔다. 미룰 수 없는 세션(shared_ptr로 관리되지 않는)이면 false
+    bool defer_flush(Session* session, SendFlushPolicy policy);
+    // 섹션 스레드에서 받은 메시지를 디코딩하는 아레나 (섹션 스레드에서는 MessageArena::get_current로도 얻는다)
+    MessageArena& get_message_arena() { return m_message_arena; }
+
+protected:
+    // section_tick_rate가 0보다 크면 섹션 스레드가 매 tick 받은 패킷과 task를 처리한 뒤 부른다. 이 뒤에 미뤄둔 send를 모두 내보낸다
+    // delta_time은 이번 tick이 맡은 시간(초)으로, CATCH_UP이면 항상 tick 주기이고 SKIP이면 밀린 시간이 더해질 수 있다
+    virtual void on_tick(double /*delta_time*/) {}
     
 private:
     void section_thread_work();
+    void event_loop();
+    void tick_loop();
+    void run_tick(double delta_time, std::chrono::steady_clock::time_point budget_end);
+    void enqueue_task(iTask* task);
+    void drain_task_inbox();
+    void execute_task(iTask* task);
+    int execute_packets(int max_count);
+    void flush_deferred_sends(bool is_forced = false);
+    void wait_for_work();
+    void wake_up();
+    void update_load_signals();
+    // 더 보내지 않아 패킷을 넣을 때 확인하지 못하는 세션도 high watermark를 오래 넘어 있으면 끊는다
+    void check_slow_consumers();
 
 public:
     double get_fps() const { return m_current_fps; }
@@ -46,17 +94,108 @@ public:
     double get_send_tps() const { return m_current_send_tps; }
     void update_send_tps_info();
     void increment_send_count_for_tps();
+
+    int get_tick_rate() const { return m_tick_rate; }
+    long long get_late_tick_count() const { return m_late_tick_count.load(std::memory_order_relaxed); }
+    long long get_overrun_tick_count() const { return m_overrun_tick_count.load(std::memory_order_relaxed); }
+    long long get_skipped_tick_count() const { return m_skipped_tick_count.load(std::memory_order_relaxed); }
+    long long get_max_tick_work_us() const { return m_current_max_tick_work_us; }
+
+    // 이 섹션으로 옮겨온 세션 수와, 옮기기 시작해서 이 섹션이 넘겨받을 때까지 걸린 시간 (누적)
+    long long get_migrated_in_count() const { return m_migrated_in_count.load(std::memory_order_relaxed); }
+    long long get_migration_pause_total_us() const { return m_migration_pause_total_us.load(std::memory_order_relaxed); }
+    long long get_migration_pause_max_us() const { return m_migration_pause_max_us.load(std::memory_order_relaxed); }
     
 private:
     unsigned int m_section_id;
 
     class ServerBase* m_owner; 
     std::thread m_section_thread;
-    std::map<unsigned int, std::shared_ptr<ClientSession>> m_sessions;
+    // 빈 자리 없이 모아두고 나갈 때는 마지막 세션을 그 자리로 옮긴다. 세션마다 자기 위치(section_index)를 들고 있다
+    std::vector<std::shared_ptr<ClientSession>> m_sessions;
     mutable std::shared_mutex m_sessions_mutex;
+    std::atomic<int> m_session_count{ 0 };
     
-    Concurrency::concurrent_priority_queue<iTask*, task_cmp> m_task_queue;
+    // 다른 스레드는 m_task_inbox에 넣기만 하고, 섹션 스레드가 꺼내 바로 실행할 task는 m_ready_tasks에, 나중에 실행할 task는 타이밍 휠에 넣는다
+    // m_ready_tasks와 m_timer_wheel은 섹션 스레드만 접근한다
+    MpscQueue<iTask> m_task_inbox;
+    std::deque<iTask*> m_ready_tasks;
+    TimerWheel m_timer_wheel{ std::chrono::steady_clock::now() };
+    static constexpr int TIMER_SPIN_US = 50; // 타이머 시각보다 이만큼 먼저 깨어나 남은 시간은 잠들지 않고 기다린다
+
+    // 받은 패킷은 I/O 스레드마다 따로 둔 SPSC 큐로 받고, I/O 스레드가 아닌 곳에서 온 패킷만 락을 잡고 m_remote_packets에 넣는다
+    // 한 세션의 recv 완료는 매번 다른 I/O 스레드에서 올 수 있으므로 넣을 때 붙인 순번이 작은 것부터 꺼내 세션별 순서를 지킨다
+    // 세션은 id로만 들고 있다가, 실행할 때 SessionRegistry에서 id가 아직 유효한지 보고 packet의 owner로 실행한다
+    // (나간 세션은 id를 먼저 무효로 만들고, 섹션이 쥔 참조는 섹션 스레드에서 놓으므로 유효하면 owner도 살아 있다)
+    // migration이 있으면 패킷 대신 세션을 옮기는 표시다. 떠나는 섹션에서는 앞선 패킷을 다 실행했다는 뜻이고, 도착할 섹션에서는 넘겨받으라는 뜻이다
+    struct SessionMigration
+    {
+        std::shared_ptr<ClientSession> session; // 옮기는 동안 세션을 살려둔다 (도착한 섹션 스레드에서 놓는다)
+        std::shared_ptr<NetworkSection> target;
+        std::chrono::steady_clock::time_point start_time;
+    };
+    struct SectionPacket
+    {
+        unsigned long long sequence = 0;
+        Packet* packet = nullptr;
+        int session_id = 0;
+        SessionMigration* migration = nullptr;
+    };
+    // m_sessions_mutex를 잡고 부른다
+    bool contains_session(const std::shared_ptr<ClientSession>& session) const;
+    bool erase_session(const std::shared_ptr<ClientSession>& session);
+    void push_remote_packet(SectionPacket&& entry);
+    void hand_over_session(SessionMigration* migration);
+    void take_over_session(SessionMigration* migration);
+    std::vector<std::unique_ptr<SpscQueue<SectionPacket>>> m_packet_queues;
+    std::atomic<unsigned long long> m_packet_sequence;
+    std::mutex m_remote_packets_mutex;
+    std::vector<SectionPacket> m_remote_packets;
+    std::atomic<bool> m_has_remote_packets;
+    std::deque<SectionPacket> m_pending_remote_packets; // 섹션 스레드가 m_remote_packets에서 옮겨둔 것
+    std::unordered_map<int, std::vector<SectionPacket>> m_arriving_packets; // 옮겨오는 중인 세션의 패킷 (섹션 스레드만 접근)
+
+    std::atomic<long long> m_migrated_in_count{ 0 };
+    std::atomic<long long> m_migration_pause_total_us{ 0 };
+    std::atomic<long long> m_migration_pause_max_us{ 0 };
+
+    // 할 일이 없으면 섹션 스레드는 잠들고, 패킷이나 task를 넣는 쪽이 깨운다
+    static constexpr int MAX_IDLE_WAIT_MS = 100;
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake_cv;
+    std::atomic<bool> m_is_sleeping;
+
+    // send를 미뤄둔 세션 (섹션 스레드만 접근). 미룬 순서대로 flush 시각이 정해지므로 앞에서부터 꺼낸다
+    struct DeferredFlush
+    {
+        std::weak_ptr<Session> session;
+        std::chrono::steady_clock::time_point flush_time;
+    };
+    static constexpr int MAX_TASK_BATCH = 256;
+    std::deque<DeferredFlush> m_deferred_flushes;
+
+    // task 묶음이나 tick이 끝나 미뤄둔 send를 내보낸 뒤 비운다 (섹션 스레드만 접근)
+    MessageArena m_message_arena;
+
+    // 고정 주기 tick (m_tick_rate가 0이면 쓰지 않는다)
+    // 예정 시각보다 주기의 1/LATE_TICK_DIVISOR 넘게 늦게 시작한 tick은 late, 일한 시간이 예산을 넘긴 tick은 overrun으로 센다
+    static constexpr int LATE_TICK_DIVISOR = 10;
+    int m_tick_rate = 0;
+    std::chrono::steady_clock::duration m_tick_period{};
+    std::chrono::steady_clock::duration m_tick_budget{};
+    std::atomic<long long> m_late_tick_count{ 0 };
+    std::atomic<long long> m_overrun_tick_count{ 0 };
+    std::atomic<long long> m_skipped_tick_count{ 0 };
+    long long m_max_tick_work_us = 0;          // 이번 FPS 측정 구간에서 가장 오래 걸린 tick
+    long long m_current_max_tick_work_us = 0;  // 지난 FPS 측정 구간에서 가장 오래 걸린 tick
     
+    // 부하 지표 (섹션 스레드가 쓴다). 섹션 스레드는 잠들거나 tick을 기다린 시간만 m_idle_time에 더한다
+    std::atomic<unsigned long long> m_executed_packet_count{ 0 };
+    std::atomic<int> m_ready_task_count{ 0 };
+    std::atomic<double> m_load{ 0 };
+    std::chrono::steady_clock::time_point m_load_window_start;
+    std::chrono::steady_clock::duration m_idle_time{};
+
     // FPS 측정 관련
     std::chrono::high_resolution_clock::time_point m_last_frame_time;
     int m_frame_count;
@@ -6,6 +6,7 @@ extern NetworkUtil* g_network_util = xnew NetworkUtil;
 
 NetworkUtil::NetworkUtil()
 {
+#ifdef _WIN32
     WORD req_version = 0;
     req_version = MAKEWORD(2, 2);
     
@@ -27,10 +28,12 @@ NetworkUtil::NetworkUtil()
         // TODO: LOG 
         // TODO: QUIT PROGRAM 
     }
+#endif
 }
 
 sockaddr* NetworkUtil::get_remote_sockaddr(char* lpOutputBuffer)
 {
+#ifdef _WIN32
     sockaddr* local_addr = nullptr;
     sockaddr* remote_addr = nullptr;
     int remote_addr_len = 0;
@@ -38,16 +41,28 @@ sockaddr* NetworkUtil::get_remote_sockaddr(char* lpOutputBuffer)
     GetAcceptExSockaddrs(lpOutputBuffer, 0, sizeof(sockaddr_in) + 16, sizeof(sockaddr_in) + 16, &local_addr, &local_addr_len, &remote_addr, &remote_addr_len);
 
     return remote_addr;
+#else
+    // 리눅스 엔진들은 accept한 소켓의 주소를 버퍼 앞에 그대로 기록한다
+    return reinterpret_cast<sockaddr*>(lpOutputBuffer);
+#endif
 }
 
 SOCKET NetworkUtil::create_socket()
 {
+#ifdef _WIN32
     return ::WSASocket(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
+#else
+    return ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+#endif
 }
 
 bool NetworkUtil::register_socket(HANDLE iocp_handle, SOCKET socket)
 {
+#ifdef _WIN32
     return ::CreateIoCompletionPort(reinterpret_cast<HANDLE>(socket), iocp_handle,0,0);
+#else
+    return static_cast<IoEngine*>(iocp_handle)->register_socket(socket);
+#endif
 }
 
 bool NetworkUtil::bind(SOCKET socket, const char* ip, int port)
@@ -93,8 +108,28 @@ bool NetworkUtil::listen(SOCKET socket, int backlog)
     return true;
 }
 
+bool NetworkUtil::set_reuse_port(SOCKET socket)
+{
+#ifdef _WIN32
+    return false;
+#else
+    int enable = 1;
+    if (SOCKET_ERROR == ::setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)))
+    {
+        std::cout << "SO_REUSEPORT error: " << errno << std::endl;
+        return false;
+    }
+
+    return true;
+#endif
+}
+
 bool NetworkUtil::accept(SOCKET listen_socket, AcceptIO* io)
 {
+#ifndef _WIN32
+    IoEngine* engine = IoEngine::find_engine(listen_socket);
+    return nullptr != engine && engine->accept(listen_socket, io);
+#else
     constexpr DWORD addr_length = sizeof(sockaddr_in) + 16;
     DWORD dwBytes = 0;
     
@@ -113,6 +148,7 @@ bool NetworkUtil::accept(SOCKET listen_socket, AcceptIO* io)
 	}
     
 	return true;
+#endif
 }
 
 bool NetworkUtil::connect(SOCKET socket, ConnectIO* io, bool& is_not_pending)
@@ -122,6 +158,10 @@ bool NetworkUtil::connect(SOCKET socket, ConnectIO* io, bool& is_not_pending)
     inet_pton(AF_INET, io->m_ip.c_str(), &(addr.sin_addr.s_addr));
     addr.sin_port = htons(io->m_port);
 
+#ifndef _WIN32
+    IoEngine* engine = IoEngine::find_engine(socket);
+    return nullptr != engine && engine->connect(socket, io, addr, is_not_pending);
+#else
     auto result = ::WSAConnect(socket,reinterpret_cast<sockaddr*>(&addr), sizeof(addr), nullptr, nullptr, nullptr, nullptr);
 
     if (0 == result)
@@ -139,11 +179,21 @@ bool NetworkUtil::connect(SOCKET socket, ConnectIO* io, bool& is_not_pending)
 
 
     return true;
+#endif
 }
 
 bool NetworkUtil::send(SendIO* io, bool& is_not_pending, DWORD& send_byte_size)
 {
-    auto result = ::WSASend(io->get_session()->get_socket(), io->m_buffers.data(), static_cast<DWORD>(io->m_buffers.size()), &send_byte_size, 0, io,  nullptr);
+    // 이미 닫은 세션이면 보내지 않는다 (같은 번호의 소켓이 다른 연결에 쓰이고 있을 수 있다)
+    const SOCKET socket = io->get_session()->get_socket();
+    if (INVALID_SOCKET == socket)
+        return false;
+
+#ifndef _WIN32
+    IoEngine* engine = IoEngine::find_engine(socket);
+    return nullptr != engine && engine->send(socket, io, is_not_pending, send_byte_size);
+#else
+    auto result = ::WSASend(socket, io->m_buffers.data(), static_cast<DWORD>(io->m_buffers.size()), &send_byte_size, 0, io,  nullptr);
 
     if(result == 0)
         is_not_pending = true;
@@ -160,13 +210,26 @@ bool NetworkUtil::send(SendIO* io, bool& is_not_pending, DWORD& send_byte_size)
     }
     
     return true;
+#endif
 }
 
 bool NetworkUtil::receive(SOCKET socket, RecvIO* io)
 {
+    if (INVALID_SOCKET == socket)
+        return false;
+
+#ifndef _WIN32
+    IoEngine* engine = IoEngine::find_engine(socket);
+    return nullptr != engine && engine->receive(socket, io);
+#else
+    // 버퍼를 풀에 돌려둔 상태면 0 바이트 recv로 데이터가 올 때까지 기다리고, 완료되면 Session이 버퍼를 빌려 다시 건다
+    RecvBuffer& recv_buffer = io->get_session()->get_recv_buffer();
+    if(recv_buffer.HasBuffer() && false == recv_buffer.EnsureBuffer())
+        return false;
+
     WSABUF buf;
-    buf.buf = io->get_session()->get_recv_buffer().GetReadPos();
-    buf.len = io->get_session()->get_recv_buffer().GetRemainingSize();
+    buf.buf = recv_buffer.HasBuffer() ? recv_buffer.GetWritePos() : nullptr;
+    buf.len = recv_buffer.HasBuffer() ? recv_buffer.GetRemainingSize() : 0;
 
     DWORD recv_bytes = 0;
     DWORD flag = 0;
@@ -183,10 +246,18 @@ bool NetworkUtil::receive(SOCKET socket, RecvIO* io)
         }
     }
     return true;
+#endif
 }
 
 bool NetworkUtil::disconnect(SOCKET socket, class DisconnectIO* io)
 {
+    if (INVALID_SOCKET == socket)
+        return false;
+
+#ifndef _WIN32
+    IoEngine* engine = IoEngine::find_engine(socket);
+    return nullptr != engine && engine->disconnect(socket, io);
+#else
     if (false == g_network_util->DisconnectEx(socket, io, TF_REUSE_SOCKET, 0))
     {
         int err_code = ::GetLastError();
@@ -198,4 +269,5 @@ bool NetworkUtil::disconnect(SOCKET socket, class DisconnectIO* io)
         }
     }
     return true;
+#endif
 }
\ No newline at end of file
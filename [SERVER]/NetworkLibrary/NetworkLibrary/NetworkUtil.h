@@ -15,14 +15,18 @@ public:
    static bool bind(SOCKET socket, const char* ip, int port);
    static bool bind(SOCKET socket, SOCKADDR_IN addr);
    static bool listen(SOCKET socket, int backlog = 1);
+   // bind 전에 호출해 같은 포트에 리슨 소켓 여러 개를 열 수 있게 한다 (리눅스 SO_REUSEPORT, 윈도우는 지원하지 않아 false)
+   static bool set_reuse_port(SOCKET socket);
    static bool accept(SOCKET listen_socket, class AcceptIO* io);
    static bool connect(SOCKET socket, class ConnectIO* io, bool& is_not_pending);
    static bool send(class SendIO* io, bool& is_not_pending, DWORD& send_byte_size);
    static bool receive(SOCKET socket, class RecvIO* io);
    static bool disconnect(SOCKET socket, class DisconnectIO* io);
 
+#ifdef _WIN32
 public:
    LPFN_DISCONNECTEX DisconnectEx;
+#endif
 };
 
 extern NetworkUtil* g_network_util;
\ No newline at end of file
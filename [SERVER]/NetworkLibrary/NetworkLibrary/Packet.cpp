@@ -1,19 +1,24 @@
 #include "pch.h"
 #include "Packet.h"
 
-Packet::Packet() : m_current_idx(0), m_owner(nullptr)
+Packet::Packet() : m_current_idx(0), m_owner(nullptr), m_recv_block(nullptr), m_slice_data(nullptr)
 {
 }
 
-Packet::Packet(Packet* packet)
+Packet::Packet(Packet* packet) : m_recv_block(nullptr), m_slice_data(nullptr)
 {
     m_owner = packet->m_owner;
-    m_buffer = packet->m_buffer;
+    if (packet->is_slice())
+        m_buffer.assign(packet->get_data(), packet->get_data() + packet->get_size());
+    else
+        m_buffer = packet->m_buffer;
     m_current_idx = packet->m_current_idx;
 }
 
 Packet::~Packet()
 {
+    if (nullptr != m_recv_block)
+        m_recv_block->release();
 }
 
 void Packet::reserve_packet_buffer(int size)
@@ -23,7 +28,74 @@ void Packet::reserve_packet_buffer(int size)
 
 void Packet::set_packet(char* data, int size)
 {
+    if (nullptr != m_recv_block)
+    {
+        m_recv_block->release();
+        m_recv_block = nullptr;
+    }
     m_buffer.assign(data, data + size);
+    m_original_size = 0;
+}
+
+void Packet::set_packet(RecvBlock* block, char* data)
+{
+    // 패킷 하나가 블록 끝을 넘어가도 미러 매핑 덕분에 data부터 헤더의 크기만큼 연속이다
+    block->add_ref();
+    if (nullptr != m_recv_block)
+        m_recv_block->release();
+
+    m_recv_block = block;
+    m_slice_data = data;
+}
+
+void Packet::set_packet(PacketBuffer&& buffer)
+{
+    if (nullptr != m_recv_block)
+    {
+        m_recv_block->release();
+        m_recv_block = nullptr;
+        m_slice_data = nullptr;
+    }
+    m_buffer = std::move(buffer);
+    m_original_size = 0;
+}
+
+std::shared_ptr<Packet> Packet::create(unsigned short protocol_number, const google::protobuf::Message& message)
+{
+    std::shared_ptr<Packet> packet = xmake_shared(Packet);
+    if (false == packet->set_message(protocol_number, message))
+        return nullptr;
+
+    // 압축을 켠 packet_number면 여기서 요청해, 브로드캐스트로 여러 세션에 보내도 한 번만 압축한다
+    if (packet_compression_mode)
+        PacketCompressor::get_instance().request(packet);
+    return packet;
+}
+
+bool Packet::set_message(unsigned short protocol_number, const google::protobuf::Message& message)
+{
+    // 헤더의 크기가 넘쳐 감기면 받는 쪽이 스트림을 엉뚱한 곳에서 자르므로 아예 만들지 않는다
+    const size_t message_size = message.ByteSizeLong();
+    if (message_size > PACKET_MAX_SIZE - PACKET_HEADER_SIZEOF)
+    {
+        std::cout << "packet too large. protocol " << protocol_number << ", body " << message_size << std::endl;
+        return false;
+    }
+    const int packet_size = PACKET_HEADER_SIZEOF + static_cast<int>(message_size);
+
+    m_buffer.clear();
+    m_buffer.reserve(packet_size);
+    m_buffer.resize(packet_size);
+
+    PacketHeader header;
+    header.packet_size = static_cast<unsigned short>(packet_size);
+    header.protocol_no = protocol_number;
+    ::memcpy(m_buffer.data(), &header, PACKET_HEADER_SIZEOF);
+    message.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(m_buffer.data() + PACKET_HEADER_SIZEOF));
+    m_current_idx = packet_size;
+    m_original_size = packet_size;
+    m_original_protocol = protocol_number;
+    return true;
 }
 
 void Packet::set_owner(Session* session)
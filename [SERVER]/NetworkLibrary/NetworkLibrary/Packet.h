@@ -12,9 +12,24 @@ enum
     PACKET_SIZE_SIZEOF = sizeof(unsigned short),
     PACKET_PROTOCOL_SIZEOF = sizeof(unsigned short),
     PACKET_HEADER_SIZEOF = sizeof(struct PacketHeader),
+    PACKET_COMPRESSED_SIZE_SIZEOF = sizeof(unsigned short),
+    PACKET_MAX_SIZE = USHRT_MAX, // 헤더의 packet_size가 unsigned short라 헤더를 포함해 이보다 클 수 없다
 };
 
-class Packet
+// protocol_no에 이 비트가 있으면 본문이 압축되어 있다 (PacketCompressor)
+// 압축된 본문은 [원래 본문 크기(unsigned short)][deflate 데이터(zlib 헤더 없음)]이고, C# 클라이언트(Packet.cs)도 같은 형식으로 푼다
+constexpr unsigned short PACKET_COMPRESSED_FLAG = 0x8000;
+
+using PacketBuffer = std::vector<char, PacketBufferAllocator<char>>;
+
+// 메시지 타입 -> packet_number. 메시지마다의 특수화는 생성된 PacketDispatcher.h에 있다
+template<typename MessageT> struct ProtocolOf;
+
+// 보낼 패킷은 m_buffer에 직접 쓰고, 받은 패킷은 수신 버퍼 블록을 참조하는 읽기 전용 슬라이스로 만든다
+// 슬라이스는 블록의 참조를 잡고 있으므로 복사 없이 네트워크 바이트에서 바로 pop / pop_message 할 수 있다
+// 슬라이스에 push 할 수는 없고, 다시 보내거나 고쳐 쓰려면 Packet(Packet*)로 복사본을 만든다
+// 받은 패킷은 I/O 스레드에서 NetworkCore의 MpscQueue로 넘어가므로 노드를 직접 들고 있다
+class Packet : public MpscNode
 {
 
 public:
@@ -24,15 +39,42 @@ public:
 
     void reserve_packet_buffer(int size);
     void set_packet(char* data, int size);
+    void set_packet(struct RecvBlock* block, char* data);
+    void set_packet(PacketBuffer&& buffer); // 슬라이스였으면 블록을 놓고 buffer를 가진다
+    bool is_slice() const { return nullptr != m_recv_block; }
     void set_owner(class Session* session);
     Session* get_owner(); 
+
+    // 헤더와 메시지가 딱 들어가는 버퍼를 패킷 버퍼 풀에서 한 번만 잡고 메시지를 바로 직렬화한다
+    // 크기는 ByteSizeLong으로 한 번만 재고, 직렬화는 메시지에 캐시된 크기를 쓴다
+    // 같은 메시지를 여러 세션에 보낼 때(브로드캐스트)는 한 번 만든 패킷을 같이 보낸다 (보낸 뒤에는 고쳐 쓰지 않는다)
+    // 헤더까지 PACKET_MAX_SIZE를 넘는 메시지는 만들지 않는다 (create는 nullptr, set_message는 false)
+    static std::shared_ptr<Packet> create(unsigned short protocol_number, const google::protobuf::Message& message);
+    template<typename MessageT>
+    static std::shared_ptr<Packet> create(const MessageT& message) { return create(ProtocolOf<MessageT>::value, message); }
+    bool set_message(unsigned short protocol_number, const google::protobuf::Message& message);
 public:
 
 
-    unsigned short get_size() const { return *m_buffer.data(); }
-    unsigned short get_body_size() const { return (*m_buffer.data()) - PACKET_HEADER_SIZEOF; }
-    unsigned short get_protocol() const { return *(m_buffer.data() + PACKET_SIZE_SIZEOF); }
-    std::vector<char>& get_buffer() {return m_buffer; }
+    unsigned short get_size() const { return *reinterpret_cast<const unsigned short*>(get_data()); }
+    unsigned short get_body_size() const { return get_size() - PACKET_HEADER_SIZEOF; }
+    unsigned short get_protocol() const { return get_raw_protocol() & ~PACKET_COMPRESSED_FLAG; }
+    unsigned short get_raw_protocol() const { return *reinterpret_cast<const unsigned short*>(get_data() + PACKET_SIZE_SIZEOF); }
+    bool is_compressed() const { return 0 != (get_raw_protocol() & PACKET_COMPRESSED_FLAG); }
+    const char* get_data() const { return nullptr != m_recv_block ? m_slice_data : m_buffer.data(); }
+    PacketBuffer& get_buffer() {return m_buffer; }
+
+    // 압축 전의 크기와 packet_number. 워커가 버퍼를 압축하는 중에도 읽을 수 있어 send 큐 제한(MultiSender)이 쓴다
+    // set_message / finalize가 적어두고, 그 밖의 패킷(복사본, 받은 패킷)은 압축하지 않으므로 버퍼에서 읽는다
+    int get_original_size() const { return 0 < m_original_size ? m_original_size : get_size(); }
+    unsigned short get_original_protocol() const { return 0 < m_original_size ? m_original_protocol : get_protocol(); }
+    // 같은 packet_number의 CONFLATE 패킷 중 무엇끼리 합칠지 (MultiSender::set_send_policy). 기본은 packet_number마다 하나
+    unsigned int get_conflate_key() const { return m_conflate_key; }
+    void set_conflate_key(unsigned int conflate_key) { m_conflate_key = conflate_key; }
+
+    // 워커에서 압축 중이면 그 작업 (PacketCompressor). 큐에 넣기 전에 붙이고 바꾸지 않는다
+    const std::shared_ptr<struct CompressJob>& get_compress_job() const { return m_compress_job; }
+    void set_compress_job(std::shared_ptr<struct CompressJob> job) { m_compress_job = std::move(job); }
     
     void initialize(unsigned short protocol_number)
     {
@@ -40,7 +82,12 @@ public:
         m_current_idx = PACKET_HEADER_SIZEOF;
         ::memcpy_s(get_protocol_ptr(), PACKET_PROTOCOL_SIZEOF, &protocol_number, PACKET_PROTOCOL_SIZEOF);
     }
-    void finalize() { *(static_cast<unsigned short*>(get_size_ptr())) = static_cast<unsigned short>(m_current_idx); }
+    void finalize()
+    {
+        *(static_cast<unsigned short*>(get_size_ptr())) = static_cast<unsigned short>(m_current_idx);
+        m_original_size = m_current_idx;
+        m_original_protocol = get_protocol();
+    }
 
 public:
     
@@ -79,9 +126,10 @@ public:
     
     void push(google::protobuf::Message& message)
     {
-        m_buffer.resize(m_buffer.size() + message.ByteSizeLong());
-        message.SerializeToArray(get_current_idx_ptr(), message.ByteSizeLong());
-        m_current_idx += message.ByteSizeLong();
+        const int message_size = static_cast<int>(message.ByteSizeLong());
+        m_buffer.resize(m_buffer.size() + message_size);
+        message.SerializeWithCachedSizesToArray(static_cast<uint8_t*>(get_current_idx_ptr()));
+        m_current_idx += message_size;
     }
     
     template <typename... Types>
@@ -129,7 +177,7 @@ public:
     
     void pop_message(google::protobuf::Message& message)
     { 
-        message.ParseFromArray(m_buffer.data() + PACKET_HEADER_SIZEOF, get_size() - PACKET_HEADER_SIZEOF);
+        message.ParseFromArray(get_data() + PACKET_HEADER_SIZEOF, get_body_size());
     }
     
     template <typename... Types>
@@ -141,14 +189,21 @@ public:
 private:
     void* get_protocol_ptr() { return m_buffer.data() + PACKET_SIZE_SIZEOF; }
     void* get_size_ptr() { return m_buffer.data(); }
-    void* get_current_idx_ptr() {return (m_buffer.data() + m_current_idx); }
+    void* get_current_idx_ptr() {return (nullptr != m_recv_block ? m_slice_data : m_buffer.data()) + m_current_idx; }
 
 private:
-    std::vector<char> m_buffer; // TODO: use buffer pool
+    PacketBuffer m_buffer;
     int m_current_idx;
 
     // For Read 
     Session* m_owner;
+    struct RecvBlock* m_recv_block;
+    char* m_slice_data;
+
+    std::shared_ptr<struct CompressJob> m_compress_job;
+    int m_original_size = 0;
+    unsigned short m_original_protocol = 0;
+    unsigned int m_conflate_key = 0;
 };
 
 #define DEFINE_SERIALIZER(...) \
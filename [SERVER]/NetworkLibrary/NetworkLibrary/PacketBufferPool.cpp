@@ -0,0 +1,248 @@
+#include "pch.h"
+#include "PacketBufferPool.h"
+#include <algorithm>
+
+struct PacketBufferPool::ThreadCache
+{
+    ThreadCache();
+    ~ThreadCache();
+
+    // 이 스레드만 쓰므로 읽기-쓰기로 더해도 된다 (다른 스레드는 통계를 읽기만 한다)
+    static void add(std::atomic<long long>& counter, long long value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::vector<void*> free_blocks[SIZE_CLASS_COUNT];
+    std::atomic<long long> hit_count{ 0 };
+    std::atomic<long long> miss_count{ 0 };
+    std::atomic<long long> outstanding_bytes{ 0 };
+};
+
+namespace
+{
+    // 스레드가 끝나며 캐시가 소멸된 뒤에도 다른 thread_local 소멸자에서 해제가 올 수 있다
+    thread_local bool t_is_cache_destroyed = false;
+}
+
+PacketBufferPool::ThreadCache::ThreadCache()
+{
+    for (int size_class = 0; size_class < SIZE_CLASS_COUNT; ++size_class)
+        free_blocks[size_class].reserve(get_thread_cache_limit(size_class) + 1);
+
+    PacketBufferPool::get_instance().register_thread_cache(this);
+}
+
+PacketBufferPool::ThreadCache::~ThreadCache()
+{
+    PacketBufferPool& pool = PacketBufferPool::get_instance();
+    for (int size_class = 0; size_class < SIZE_CLASS_COUNT; ++size_class)
+        pool.spill(*this, size_class, 0);
+
+    pool.unregister_thread_cache(this);
+    t_is_cache_destroyed = true;
+}
+
+PacketBufferPool& PacketBufferPool::get_instance()
+{
+    // shared_ptr로 잡힌 패킷이 정적 객체 소멸 중에 돌아올 수 있으므로 풀은 해제하지 않는다
+    static PacketBufferPool* pool = xnew PacketBufferPool;
+    return *pool;
+}
+
+void* PacketBufferPool::allocate(size_t size)
+{
+    ThreadCache* cache = t_is_cache_destroyed ? nullptr : &get_thread_cache();
+
+    const int size_class = get_size_class(size);
+    const size_t block_size = -1 == size_class ? size : get_class_size(size_class);
+
+    void* block = nullptr;
+    if (-1 != size_class && nullptr != cache)
+    {
+        std::vector<void*>& free_blocks = cache->free_blocks[size_class];
+        if (free_blocks.empty())
+            refill(*cache, size_class);
+
+        if (false == free_blocks.empty())
+        {
+            block = free_blocks.back();
+            free_blocks.pop_back();
+        }
+    }
+    else if (-1 != size_class)
+    {
+        SharedClass& shared_class = m_shared_classes[size_class];
+        std::lock_guard<std::mutex> lock(shared_class.lock);
+        if (false == shared_class.free_blocks.empty())
+        {
+            block = shared_class.free_blocks.back();
+            shared_class.free_blocks.pop_back();
+        }
+    }
+
+    const bool is_hit = nullptr != block;
+    if (nullptr == block)
+        block = ::operator new(block_size);
+
+    if (nullptr != cache)
+    {
+        ThreadCache::add(is_hit ? cache->hit_count : cache->miss_count, 1);
+        ThreadCache::add(cache->outstanding_bytes, static_cast<long long>(block_size));
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_caches_lock);
+        ++(is_hit ? m_retired_hit_count : m_retired_miss_count);
+        m_retired_outstanding_bytes += static_cast<long long>(block_size);
+    }
+
+    return block;
+}
+
+void PacketBufferPool::deallocate(void* block, size_t size)
+{
+    if (nullptr == block)
+        return;
+
+    ThreadCache* cache = t_is_cache_destroyed ? nullptr : &get_thread_cache();
+
+    const int size_class = get_size_class(size);
+    const size_t block_size = -1 == size_class ? size : get_class_size(size_class);
+
+    if (nullptr != cache)
+    {
+        ThreadCache::add(cache->outstanding_bytes, -static_cast<long long>(block_size));
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_caches_lock);
+        m_retired_outstanding_bytes -= static_cast<long long>(block_size);
+    }
+
+    if (-1 == size_class)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    if (nullptr != cache)
+    {
+        // 캐시가 한도를 넘으면 절반만 남기고 공용 목록으로 넘긴다
+        std::vector<void*>& free_blocks = cache->free_blocks[size_class];
+        free_blocks.push_back(block);
+        if (free_blocks.size() > get_thread_cache_limit(size_class))
+            spill(*cache, size_class, get_thread_cache_limit(size_class) / 2);
+        return;
+    }
+
+    {
+        SharedClass& shared_class = m_shared_classes[size_class];
+        std::lock_guard<std::mutex> lock(shared_class.lock);
+        if ((shared_class.free_blocks.size() + 1) * block_size <= MAX_SHARED_BYTES_PER_CLASS)
+        {
+            shared_class.free_blocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
+
+long long PacketBufferPool::get_hit_count()
+{
+    std::lock_guard<std::mutex> lock(m_caches_lock);
+    long long hit_count = m_retired_hit_count;
+    for (ThreadCache* cache : m_caches)
+        hit_count += cache->hit_count.load(std::memory_order_relaxed);
+    return hit_count;
+}
+
+long long PacketBufferPool::get_miss_count()
+{
+    std::lock_guard<std::mutex> lock(m_caches_lock);
+    long long miss_count = m_retired_miss_count;
+    for (ThreadCache* cache : m_caches)
+        miss_count += cache->miss_count.load(std::memory_order_relaxed);
+    return miss_count;
+}
+
+long long PacketBufferPool::get_outstanding_bytes()
+{
+    std::lock_guard<std::mutex> lock(m_caches_lock);
+    long long outstanding_bytes = m_retired_outstanding_bytes;
+    for (ThreadCache* cache : m_caches)
+        outstanding_bytes += cache->outstanding_bytes.load(std::memory_order_relaxed);
+    return outstanding_bytes;
+}
+
+int PacketBufferPool::get_size_class(size_t size)
+{
+    size_t class_size = MIN_BLOCK_SIZE;
+    for (int size_class = 0; size_class < SIZE_CLASS_COUNT; ++size_class, class_size <<= 1)
+    {
+        if (size <= class_size)
+            return size_class;
+    }
+
+    return -1;
+}
+
+size_t PacketBufferPool::get_thread_cache_limit(int size_class)
+{
+    return std::clamp<size_t>(THREAD_CACHE_BYTES_PER_CLASS / get_class_size(size_class), 4, 256);
+}
+
+PacketBufferPool::ThreadCache& PacketBufferPool::get_thread_cache()
+{
+    thread_local ThreadCache cache;
+    return cache;
+}
+
+void PacketBufferPool::register_thread_cache(ThreadCache* cache)
+{
+    std::lock_guard<std::mutex> lock(m_caches_lock);
+    m_caches.push_back(cache);
+}
+
+void PacketBufferPool::unregister_thread_cache(ThreadCache* cache)
+{
+    std::lock_guard<std::mutex> lock(m_caches_lock);
+    m_retired_hit_count += cache->hit_count.load(std::memory_order_relaxed);
+    m_retired_miss_count += cache->miss_count.load(std::memory_order_relaxed);
+    m_retired_outstanding_bytes += cache->outstanding_bytes.load(std::memory_order_relaxed);
+    m_caches.erase(std::remove(m_caches.begin(), m_caches.end(), cache), m_caches.end());
+}
+
+void PacketBufferPool::refill(ThreadCache& cache, int size_class)
+{
+    SharedClass& shared_class = m_shared_classes[size_class];
+    std::vector<void*>& free_blocks = cache.free_blocks[size_class];
+
+    std::lock_guard<std::mutex> lock(shared_class.lock);
+    const size_t move_count = std::min(shared_class.free_blocks.size(), get_thread_cache_limit(size_class) / 2);
+    free_blocks.insert(free_blocks.end(), shared_class.free_blocks.end() - move_count, shared_class.free_blocks.end());
+    shared_class.free_blocks.resize(shared_class.free_blocks.size() - move_count);
+}
+
+void PacketBufferPool::spill(ThreadCache& cache, int size_class, size_t keep_count)
+{
+    SharedClass& shared_class = m_shared_classes[size_class];
+    std::vector<void*>& free_blocks = cache.free_blocks[size_class];
+    const size_t max_shared_count = MAX_SHARED_BYTES_PER_CLASS / get_class_size(size_class);
+
+    {
+        std::lock_guard<std::mutex> lock(shared_class.lock);
+        while (free_blocks.size() > keep_count && shared_class.free_blocks.size() < max_shared_count)
+        {
+            shared_class.free_blocks.push_back(free_blocks.back());
+            free_blocks.pop_back();
+        }
+    }
+
+    // 공용 목록도 가득 찼으면 힙에 돌려준다
+    while (free_blocks.size() > keep_count)
+    {
+        ::operator delete(free_blocks.back());
+        free_blocks.pop_back();
+    }
+}
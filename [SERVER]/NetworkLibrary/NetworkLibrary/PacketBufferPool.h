@@ -0,0 +1,102 @@
+#pragma once
+
+// 패킷 버퍼(Packet::m_buffer)와 xmake_shared로 만드는 객체에 쓰는 크기별(64B ~ 64KB) 메모리 풀
+// 스레드마다 클래스별 캐시를 두고 락 없이 꺼내 쓰며, 캐시가 넘치거나 비면 공용 목록과 묶음 단위로 주고받는다
+// 다른 스레드에서 해제된 블록(보낸 패킷 등)은 해제한 스레드의 캐시로 들어간다
+// 64KB를 넘는 요청은 그대로 힙에서 할당한다
+class PacketBufferPool
+{
+public:
+    static constexpr size_t MIN_BLOCK_SIZE = 64;
+    static constexpr size_t MAX_BLOCK_SIZE = 64 * 1024;
+    static constexpr int SIZE_CLASS_COUNT = 11;
+    static constexpr size_t THREAD_CACHE_BYTES_PER_CLASS = 256 * 1024;
+    static constexpr size_t MAX_SHARED_BYTES_PER_CLASS = 8 * 1024 * 1024;
+
+public:
+    static PacketBufferPool& get_instance();
+
+    template<typename T, typename... Args>
+    static std::shared_ptr<T> make_shared(Args&&... args);
+
+public:
+    void* allocate(size_t size);
+    void deallocate(void* block, size_t size);
+
+public:
+    // 캐시(스레드 캐시 또는 공용 목록)에서 꺼낸 횟수 / 힙에서 새로 할당한 횟수 / 할당되어 아직 돌아오지 않은 바이트
+    long long get_hit_count();
+    long long get_miss_count();
+    long long get_outstanding_bytes();
+
+private:
+    struct ThreadCache;
+
+    PacketBufferPool() = default;
+
+    static int get_size_class(size_t size);
+    static size_t get_class_size(int size_class) { return MIN_BLOCK_SIZE << size_class; }
+    static size_t get_thread_cache_limit(int size_class);
+
+    ThreadCache& get_thread_cache();
+    void register_thread_cache(ThreadCache* cache);
+    void unregister_thread_cache(ThreadCache* cache);
+
+    void refill(ThreadCache& cache, int size_class);
+    void spill(ThreadCache& cache, int size_class, size_t keep_count);
+
+private:
+    struct SharedClass
+    {
+        std::mutex lock;
+        std::vector<void*> free_blocks;
+    };
+
+    SharedClass m_shared_classes[SIZE_CLASS_COUNT];
+
+    // 통계는 스레드 캐시마다 따로 세고 읽을 때 합친다 (끝난 스레드의 값은 retired에 더해둔다)
+    std::mutex m_caches_lock;
+    std::vector<ThreadCache*> m_caches;
+    long long m_retired_hit_count = 0;
+    long long m_retired_miss_count = 0;
+    long long m_retired_outstanding_bytes = 0;
+};
+
+// STL 컨테이너와 std::allocate_shared가 PacketBufferPool을 쓰게 하는 할당자
+template<typename T>
+struct PacketAllocator
+{
+    using value_type = T;
+
+    PacketAllocator() = default;
+    template<typename U>
+    PacketAllocator(const PacketAllocator<U>&) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(PacketBufferPool::get_instance().allocate(count * sizeof(T))); }
+    void deallocate(T* block, size_t count) { PacketBufferPool::get_instance().deallocate(block, count * sizeof(T)); }
+
+    template<typename U>
+    bool operator==(const PacketAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const PacketAllocator<U>&) const { return false; }
+};
+
+// 패킷 버퍼(PacketBuffer)용. resize로 늘린 자리를 0으로 채우지 않는다 (늘린 자리는 바로 덮어쓰므로)
+template<typename T>
+struct PacketBufferAllocator : PacketAllocator<T>
+{
+    PacketBufferAllocator() = default;
+    template<typename U>
+    PacketBufferAllocator(const PacketBufferAllocator<U>&) {}
+
+    template<typename U>
+    void construct(U* object) noexcept(std::is_nothrow_default_constructible_v<U>) { ::new (static_cast<void*>(object)) U; }
+    template<typename U, typename... Args>
+    void construct(U* object, Args&&... args) { ::new (static_cast<void*>(object)) U(std::forward<Args>(args)...); }
+};
+
+template<typename T, typename... Args>
+std::shared_ptr<T> PacketBufferPool::make_shared(Args&&... args)
+{
+    return std::allocate_shared<T>(PacketAllocator<T>(), std::forward<Args>(args)...);
+}
@@ -0,0 +1,265 @@
+#include "pch.h"
+#include "PacketCompressor.h"
+#include <zlib.h>
+
+namespace
+{
+    // deflate / inflate 상태는 만들 때 수백 KB를 할당하므로 스레드마다 하나씩 두고 reset해서 다시 쓴다
+    struct ZStreams
+    {
+        z_stream deflater{};
+        z_stream inflater{};
+        bool is_deflater_ready = false;
+        bool is_inflater_ready = false;
+
+        ~ZStreams()
+        {
+            if (is_deflater_ready)
+                deflateEnd(&deflater);
+            if (is_inflater_ready)
+                inflateEnd(&inflater);
+        }
+
+        z_stream* get_deflater()
+        {
+            if (is_deflater_ready)
+                return Z_OK == deflateReset(&deflater) ? &deflater : nullptr;
+
+            // windowBits가 음수면 zlib 헤더 / 체크섬 없는 deflate (C#의 DeflateStream으로 바로 푼다)
+            // reset마다 해시 표를 지우므로 memLevel을 기본값(8, 64KB)보다 줄인다. 패킷은 작아서 압축률 차이가 거의 없다
+            is_deflater_ready = Z_OK == deflateInit2(&deflater, packet_compression_level, Z_DEFLATED, -MAX_WBITS, 4, Z_DEFAULT_STRATEGY);
+            return is_deflater_ready ? &deflater : nullptr;
+        }
+
+        z_stream* get_inflater()
+        {
+            if (is_inflater_ready)
+                return Z_OK == inflateReset(&inflater) ? &inflater : nullptr;
+
+            is_inflater_ready = Z_OK == inflateInit2(&inflater, -MAX_WBITS);
+            return is_inflater_ready ? &inflater : nullptr;
+        }
+    };
+
+    thread_local ZStreams t_z_streams;
+
+    long long elapsed_ns(std::chrono::steady_clock::time_point start_time)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+    }
+}
+
+PacketCompressor& PacketCompressor::get_instance()
+{
+    static PacketCompressor instance;
+    return instance;
+}
+
+void PacketCompressor::enable(unsigned short protocol_number, int min_body_size)
+{
+    if (protocol_number >= MAX_PROTOCOL_COUNT)
+        return;
+
+    m_entries[protocol_number].min_body_size.store(std::max(1, min_body_size), std::memory_order_relaxed);
+}
+
+void PacketCompressor::disable(unsigned short protocol_number)
+{
+    if (protocol_number >= MAX_PROTOCOL_COUNT)
+        return;
+
+    m_entries[protocol_number].min_body_size.store(0, std::memory_order_relaxed);
+}
+
+bool PacketCompressor::is_enabled(unsigned short protocol_number) const
+{
+    return protocol_number < MAX_PROTOCOL_COUNT && 0 < m_entries[protocol_number].min_body_size.load(std::memory_order_relaxed);
+}
+
+void PacketCompressor::request(const std::shared_ptr<Packet>& packet)
+{
+    const unsigned short protocol_number = packet->get_protocol();
+    if (false == is_enabled(protocol_number) || packet->get_body_size() < m_entries[protocol_number].min_body_size.load(std::memory_order_relaxed))
+        return;
+
+    HardTaskPool* worker_pool = m_worker_pool.load();
+    if (nullptr == worker_pool || 0 == worker_pool->get_thread_count())
+    {
+        compress(*packet);
+        return;
+    }
+
+    // 워커가 밀려 있으면 뒤에 줄 서서 보내기를 늦추느니 여기서 압축한다
+    if (worker_pool->get_queued_task_count() >= packet_compression_inline_queue)
+    {
+        m_inline_count.fetch_add(1, std::memory_order_relaxed);
+        compress(*packet);
+        return;
+    }
+
+    // 큐에 들어가기 전에 붙여야 MultiSender가 압축 중인 걸 안다
+    packet->set_compress_job(xmake_shared(CompressJob));
+
+    iTask* task = xnew iTask;
+    task->func = [this, packet]()
+    {
+        compress(*packet);
+        complete(*packet);
+    };
+    worker_pool->push(task, HardTaskPriority::INTERACTIVE);
+}
+
+bool PacketCompressor::is_ready(const Packet& packet)
+{
+    const std::shared_ptr<CompressJob>& job = packet.get_compress_job();
+    return nullptr == job || job->is_done.load(std::memory_order_acquire);
+}
+
+bool PacketCompressor::is_ready_or_wait(Packet& packet, Session* session)
+{
+    if (is_ready(packet))
+        return true;
+
+    CompressJob& job = *packet.get_compress_job();
+    std::lock_guard<std::mutex> lock(job.mutex);
+    if (job.is_done.load(std::memory_order_relaxed))
+        return true;
+
+    // 기다리는 동안 새 패킷이 들어와 다시 send를 불러도 한 번만 올린다
+    for (auto& waiter : job.waiters)
+    {
+        if (waiter.first == session)
+            return false;
+    }
+    job.waiters.emplace_back(session, session->weak_from_this().lock());
+    return false;
+}
+
+void PacketCompressor::complete(Packet& packet)
+{
+    CompressJob& job = *packet.get_compress_job();
+    std::vector<std::pair<Session*, std::shared_ptr<Session>>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.is_done.store(true, std::memory_order_release);
+        waiters.swap(job.waiters);
+    }
+
+    for (auto& waiter : waiters)
+        waiter.first->get_multi_sender().flush();
+}
+
+bool PacketCompressor::compress(Packet& packet)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+    const unsigned short protocol_number = packet.get_protocol();
+    const int body_size = packet.get_body_size();
+    if (protocol_number >= MAX_PROTOCOL_COUNT || packet.is_slice() || packet.is_compressed() || body_size <= PACKET_COMPRESSED_SIZE_SIZEOF)
+        return false;
+
+    // 원래 본문 크기를 unsigned short로 적으므로, 헤더의 크기가 감긴 패킷(push / finalize로 PACKET_MAX_SIZE를 넘긴 것)은 압축하지 않는다
+    if (packet.get_buffer().size() != packet.get_size())
+        return false;
+
+    ProtocolEntry& entry = m_entries[protocol_number];
+
+    z_stream* stream = t_z_streams.get_deflater();
+    if (nullptr == stream)
+        return false;
+
+    // 압축 결과가 원래 본문보다 작을 때만 쓰므로, 버퍼도 원래 패킷 크기까지만 잡는다
+    PacketBuffer& buffer = packet.get_buffer();
+    PacketBuffer compressed;
+    compressed.resize(buffer.size());
+
+    const int compressed_start = PACKET_HEADER_SIZEOF + PACKET_COMPRESSED_SIZE_SIZEOF;
+    stream->next_in = reinterpret_cast<Bytef*>(buffer.data() + PACKET_HEADER_SIZEOF);
+    stream->avail_in = static_cast<uInt>(body_size);
+    stream->next_out = reinterpret_cast<Bytef*>(compressed.data() + compressed_start);
+    stream->avail_out = static_cast<uInt>(compressed.size() - compressed_start);
+
+    // 출력이 모자라 끝나지 않으면(Z_OK / Z_BUF_ERROR) 작아지지 않는 본문이다
+    if (Z_STREAM_END != deflate(stream, Z_FINISH))
+    {
+        entry.skipped_count.fetch_add(1, std::memory_order_relaxed);
+        entry.compress_ns.fetch_add(elapsed_ns(start_time), std::memory_order_relaxed);
+        return false;
+    }
+
+    const int compressed_body_size = PACKET_COMPRESSED_SIZE_SIZEOF + static_cast<int>(stream->total_out);
+    PacketHeader header;
+    header.packet_size = static_cast<unsigned short>(PACKET_HEADER_SIZEOF + compressed_body_size);
+    header.protocol_no = protocol_number | PACKET_COMPRESSED_FLAG;
+    const unsigned short raw_body_size = static_cast<unsigned short>(body_size);
+    ::memcpy(compressed.data(), &header, PACKET_HEADER_SIZEOF);
+    ::memcpy(compressed.data() + PACKET_HEADER_SIZEOF, &raw_body_size, PACKET_COMPRESSED_SIZE_SIZEOF);
+    compressed.resize(header.packet_size);
+    buffer.swap(compressed);
+
+    entry.compressed_count.fetch_add(1, std::memory_order_relaxed);
+    entry.raw_bytes.fetch_add(body_size, std::memory_order_relaxed);
+    entry.compressed_bytes.fetch_add(compressed_body_size, std::memory_order_relaxed);
+    entry.compress_ns.fetch_add(elapsed_ns(start_time), std::memory_order_relaxed);
+    return true;
+}
+
+bool PacketCompressor::decompress(Packet& packet)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+    const unsigned short protocol_number = packet.get_protocol();
+    const int body_size = packet.get_body_size();
+    if (body_size < PACKET_COMPRESSED_SIZE_SIZEOF)
+        return false;
+
+    unsigned short raw_body_size = 0;
+    ::memcpy(&raw_body_size, packet.get_data() + PACKET_HEADER_SIZEOF, PACKET_COMPRESSED_SIZE_SIZEOF);
+    if (raw_body_size > USHRT_MAX - PACKET_HEADER_SIZEOF)
+        return false;
+
+    z_stream* stream = t_z_streams.get_inflater();
+    if (nullptr == stream)
+        return false;
+
+    PacketBuffer buffer;
+    buffer.resize(PACKET_HEADER_SIZEOF + raw_body_size);
+
+    stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(packet.get_data() + PACKET_HEADER_SIZEOF + PACKET_COMPRESSED_SIZE_SIZEOF));
+    stream->avail_in = static_cast<uInt>(body_size - PACKET_COMPRESSED_SIZE_SIZEOF);
+    stream->next_out = reinterpret_cast<Bytef*>(buffer.data() + PACKET_HEADER_SIZEOF);
+    stream->avail_out = raw_body_size;
+
+    // 적힌 크기만큼 정확히 풀려야 한다 (더 풀리려 하거나 모자라면 잘못된 패킷)
+    if (Z_STREAM_END != inflate(stream, Z_FINISH) || raw_body_size != stream->total_out)
+        return false;
+
+    PacketHeader header;
+    header.packet_size = static_cast<unsigned short>(PACKET_HEADER_SIZEOF + raw_body_size);
+    header.protocol_no = protocol_number;
+    ::memcpy(buffer.data(), &header, PACKET_HEADER_SIZEOF);
+    packet.set_packet(std::move(buffer));
+
+    if (protocol_number < MAX_PROTOCOL_COUNT)
+    {
+        ProtocolEntry& entry = m_entries[protocol_number];
+        entry.decompressed_count.fetch_add(1, std::memory_order_relaxed);
+        entry.decompress_ns.fetch_add(elapsed_ns(start_time), std::memory_order_relaxed);
+    }
+    return true;
+}
+
+PacketCompressor::Stats PacketCompressor::get_stats(unsigned short protocol_number) const
+{
+    Stats stats;
+    if (protocol_number >= MAX_PROTOCOL_COUNT)
+        return stats;
+
+    const ProtocolEntry& entry = m_entries[protocol_number];
+    stats.compressed_count = entry.compressed_count.load(std::memory_order_relaxed);
+    stats.skipped_count = entry.skipped_count.load(std::memory_order_relaxed);
+    stats.raw_bytes = entry.raw_bytes.load(std::memory_order_relaxed);
+    stats.compressed_bytes = entry.compressed_bytes.load(std::memory_order_relaxed);
+    stats.compress_ns = entry.compress_ns.load(std::memory_order_relaxed);
+    stats.decompressed_count = entry.decompressed_count.load(std::memory_order_relaxed);
+    stats.decompress_ns = entry.decompress_ns.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// 압축 중인 패킷을 기다리는 세션들. 압축을 요청할 때 만들어 패킷이 큐에 들어가기 전에 붙인다
+struct CompressJob
+{
+    std::atomic<bool> is_done{ false };
+    std::mutex mutex;
+    std::vector<std::pair<class Session*, std::shared_ptr<class Session>>> waiters; // 끝날 때 flush 할 세션 (shared_ptr로 만든 세션은 그때까지 잡아둔다)
+};
+
+// packet_number별 패킷 압축
+// enable로 켠 packet_number의 본문이 기준 크기 이상이면 Packet::create가 압축을 요청한다
+// 압축 워커(ServerBase가 하드 task 워커와 따로 띄운다)가 있으면 워커에서 압축하고, 그동안 MultiSender는 그 패킷 앞까지만 보내고 기다린다 (세션마다 순서는 그대로)
+// 브로드캐스트 패킷은 한 번만 압축하고, 기다리던 세션을 압축이 끝난 워커가 모두 flush 한다
+// 워커가 없거나(ClientBase만 쓰는 프로세스) 워커 큐가 packet_compression_inline_queue만큼 밀려 있으면 만든 스레드에서 바로 압축한다
+// 압축해도 작아지지 않으면 원래 패킷을 그대로 보낸다
+// 받은 압축 패킷은 Session::on_recieve가 디스패치 전에 풀어 핸들러는 압축 여부를 모른다
+class PacketCompressor
+{
+public:
+    static PacketCompressor& get_instance();
+
+public:
+    // 서버를 열기 전에 부른다. min_body_size보다 작은 본문은 압축하지 않는다
+    void enable(unsigned short protocol_number, int min_body_size);
+    void disable(unsigned short protocol_number);
+    bool is_enabled(unsigned short protocol_number) const;
+    void set_worker_pool(HardTaskPool* worker_pool) { m_worker_pool.store(worker_pool); }
+
+    // 켜진 packet_number면 압축한다 (워커가 있고 밀려 있지 않으면 워커에 넘긴다)
+    void request(const std::shared_ptr<Packet>& packet);
+    // 워커가 밀려 있어 보내는 스레드에서 바로 압축한 수 (프로세스 전체 누적)
+    long long get_inline_count() const { return m_inline_count.load(std::memory_order_relaxed); }
+
+    // 압축이 끝난 패킷이면 true. 아니면 session을 기다리는 세션으로 올리고 false (압축이 끝나면 session의 MultiSender를 flush 한다)
+    static bool is_ready_or_wait(Packet& packet, Session* session);
+    static bool is_ready(const Packet& packet);
+
+    // 지금 스레드에서 압축 / 해제한다. decompress는 받은 패킷을 풀어 쓴 버퍼로 바꾸고, 형식이 틀리면 false
+    bool compress(Packet& packet);
+    bool decompress(Packet& packet);
+
+public:
+    // packet_number별 통계 (프로세스 전체 누적)
+    // compressed: 압축해서 보낸 패킷, skipped: 압축해도 작아지지 않아 그대로 보낸 패킷
+    struct Stats
+    {
+        long long compressed_count = 0;
+        long long skipped_count = 0;
+        long long raw_bytes = 0;        // 압축한 패킷의 원래 본문 크기 합
+        long long compressed_bytes = 0; // 그 패킷들의 압축된 본문 크기 합
+        long long compress_ns = 0;      // 압축에 쓴 시간 (skipped 포함)
+        long long decompressed_count = 0;
+        long long decompress_ns = 0;
+    };
+    Stats get_stats(unsigned short protocol_number) const;
+
+public:
+    static constexpr int MAX_PROTOCOL_COUNT = 256;
+
+private:
+    PacketCompressor() = default;
+
+    void complete(Packet& packet);
+
+private:
+    struct ProtocolEntry
+    {
+        std::atomic<int> min_body_size{ 0 }; // 0이면 압축하지 않는다
+        std::atomic<long long> compressed_count{ 0 };
+        std::atomic<long long> skipped_count{ 0 };
+        std::atomic<long long> raw_bytes{ 0 };
+        std::atomic<long long> compressed_bytes{ 0 };
+        std::atomic<long long> compress_ns{ 0 };
+        std::atomic<long long> decompressed_count{ 0 };
+        std::atomic<long long> decompress_ns{ 0 };
+    };
+
+    ProtocolEntry m_entries[MAX_PROTOCOL_COUNT];
+    std::atomic<HardTaskPool*> m_worker_pool{ nullptr };
+    std::atomic<long long> m_inline_count{ 0 };
+};
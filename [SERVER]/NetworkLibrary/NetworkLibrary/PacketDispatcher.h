@@ -0,0 +1,91 @@
+// Auto-generated by enum_mapper_generator.py
+// DO NOT EDIT THIS FILE MANUALLY
+
+#pragma once
+#include <array>
+#include <type_traits>
+#include <utility>
+
+// packet_number -> 받는 메시지 타입 (서버가 받는 C2S_, 클라이언트가 받는 S2C_). 메시지가 없으면 void
+template<int PacketNumber> struct C2SMessageOf { using type = void; };
+template<int PacketNumber> struct S2CMessageOf { using type = void; };
+template<> struct C2SMessageOf<packet_number::TestEcho> { using type = C2S_TestEcho; };
+template<> struct C2SMessageOf<packet_number::AccountRegister> { using type = C2S_AccountRegister; };
+template<> struct C2SMessageOf<packet_number::AccountLogin> { using type = C2S_AccountLogin; };
+template<> struct S2CMessageOf<packet_number::TestEcho> { using type = S2C_TestEcho; };
+template<> struct S2CMessageOf<packet_number::AccountRegister> { using type = S2C_AccountRegister; };
+template<> struct S2CMessageOf<packet_number::AccountLogin> { using type = S2C_AccountLogin; };
+
+// 메시지 타입 -> packet_number (Session::do_send<MessageT>가 GetTypeName과 문자열 검색 없이 컴파일 시간에 정한다)
+// 기본 템플릿은 Packet.h에 있고, 여기 없는 메시지를 보내면 컴파일 오류가 난다
+template<> struct ProtocolOf<C2S_TestEcho> { static constexpr unsigned short value = packet_number::TestEcho; };
+template<> struct ProtocolOf<C2S_AccountRegister> { static constexpr unsigned short value = packet_number::AccountRegister; };
+template<> struct ProtocolOf<C2S_AccountLogin> { static constexpr unsigned short value = packet_number::AccountLogin; };
+template<> struct ProtocolOf<S2C_TestEcho> { static constexpr unsigned short value = packet_number::TestEcho; };
+template<> struct ProtocolOf<S2C_AccountRegister> { static constexpr unsigned short value = packet_number::AccountRegister; };
+template<> struct ProtocolOf<S2C_AccountLogin> { static constexpr unsigned short value = packet_number::AccountLogin; };
+
+// 세션 클래스마다 packet_number로 바로 찾는 핸들러 표를 컴파일 시간에 만든다
+// 표의 칸은 메시지를 디코딩해 세션 클래스의 on_packet(C2S_XXX&) (클라이언트 세션은 on_packet(S2C_XXX&))을 바로 부른다
+// on_packet이 없는 패킷의 칸은 nullptr이고, 그 패킷은 Session::m_handlers에서 찾는다
+// on_packet을 private으로 두려면 세션 클래스에 friend class PacketDispatcher; 를 선언한다
+class PacketDispatcher
+{
+public:
+    static constexpr int TABLE_SIZE = packet_number_ARRAYSIZE;
+    using Table = std::array<Session::PacketHandler, TABLE_SIZE>;
+
+    // 세션 생성자에서 부른다 (ClientSession 계열은 bind_c2s, ServerSession 계열은 bind_s2c)
+    template<typename SessionT>
+    static void bind_c2s(SessionT* session) { session->set_packet_handlers(get_c2s_table<SessionT>().data(), TABLE_SIZE); }
+    template<typename SessionT>
+    static void bind_s2c(SessionT* session) { session->set_packet_handlers(get_s2c_table<SessionT>().data(), TABLE_SIZE); }
+
+    template<typename SessionT>
+    static const Table& get_c2s_table()
+    {
+        static constexpr Table table = make_table<SessionT, C2SMessageOf>(std::make_index_sequence<TABLE_SIZE>());
+        return table;
+    }
+
+    template<typename SessionT>
+    static const Table& get_s2c_table()
+    {
+        static constexpr Table table = make_table<SessionT, S2CMessageOf>(std::make_index_sequence<TABLE_SIZE>());
+        return table;
+    }
+
+private:
+    // 섹션 스레드에서는 섹션의 MessageArena에 디코딩하므로 메시지는 묶음(tick)이 끝날 때까지만 살아 있다
+    template<typename SessionT, typename MessageT>
+    static void dispatch(Session* session, Packet* packet)
+    {
+        MessageArena* arena = MessageArena::get_current();
+        if (nullptr != arena)
+        {
+            MessageT* message = arena->create<MessageT>();
+            packet->pop_message(*message);
+            static_cast<SessionT*>(session)->on_packet(*message);
+            return;
+        }
+
+        MessageT message;
+        packet->pop_message(message);
+        static_cast<SessionT*>(session)->on_packet(message);
+    }
+
+    template<typename SessionT, typename MessageT>
+    static constexpr auto get_handler(int) -> decltype(std::declval<SessionT&>().on_packet(std::declval<MessageT&>()), Session::PacketHandler())
+    {
+        return &dispatch<SessionT, MessageT>;
+    }
+
+    template<typename SessionT, typename MessageT>
+    static constexpr Session::PacketHandler get_handler(...) { return nullptr; }
+
+    template<typename SessionT, template<int> class MessageOf, size_t... PacketNumbers>
+    static constexpr Table make_table(std::index_sequence<PacketNumbers...>)
+    {
+        return Table{ get_handler<SessionT, typename MessageOf<static_cast<int>(PacketNumbers)>::type>(0)... };
+    }
+};
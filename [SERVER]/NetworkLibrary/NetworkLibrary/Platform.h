@@ -0,0 +1,84 @@
+#pragma once
+
+#ifdef _WIN32
+
+#include <WinSock2.h>
+#include <MSWSock.h>
+#include <ws2tcpip.h>
+#include <mswsock.h>
+#pragma comment(lib,"mswsock.lib")
+#pragma comment(lib, "ws2_32.lib")
+
+#include <concurrent_queue.h>
+#include <concurrent_priority_queue.h>
+
+#else
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <ctime>
+
+#include "ConcurrentContainers.h"
+
+// IOCP 코드와 같은 이름을 쓰기 위한 최소한의 윈도우 타입 정의 (리눅스 epoll 백엔드)
+using SOCKET = int;
+using HANDLE = void*;
+using DWORD = std::uint32_t;
+using ULONG = std::uint32_t;
+using ULONG_PTR = std::uintptr_t;
+using SOCKADDR_IN = sockaddr_in;
+
+constexpr SOCKET INVALID_SOCKET = -1;
+constexpr int SOCKET_ERROR = -1;
+constexpr DWORD INFINITE = 0xFFFFFFFF;
+
+// epoll 백엔드는 InternalHigh에 지금까지 처리한 바이트 수를 기록한다
+struct OVERLAPPED
+{
+    ULONG_PTR Internal;
+    ULONG_PTR InternalHigh;
+    DWORD Offset;
+    DWORD OffsetHigh;
+    HANDLE hEvent;
+};
+
+// iovec과 메모리 배치가 같아야 writev에 그대로 넘길 수 있다
+struct WSABUF
+{
+    char* buf;
+    std::size_t len;
+};
+static_assert(sizeof(WSABUF) == sizeof(iovec), "WSABUF must match iovec layout");
+
+#define abstract = 0
+#define ZeroMemory(dest, size) std::memset((dest), 0, (size))
+
+inline int closesocket(SOCKET socket) { return ::close(socket); }
+inline int WSAGetLastError() { return errno; }
+inline int GetLastError() { return errno; }
+
+inline int memcpy_s(void* dest, std::size_t dest_size, const void* src, std::size_t count)
+{
+    if (nullptr == dest || nullptr == src || dest_size < count)
+        return EINVAL;
+    std::memmove(dest, src, count);
+    return 0;
+}
+
+inline int localtime_s(std::tm* out, const std::time_t* time)
+{
+    return nullptr == ::localtime_r(time, out) ? errno : 0;
+}
+
+#endif
@@ -1,25 +1,36 @@
 #include "pch.h"
 #include "RecvBuffer.h"
 
-RecvBuffer::RecvBuffer() : RecvBuffer(/*TODO: const value*/65535 * 3)
+RecvBuffer::RecvBuffer()
 {
 }
 
-RecvBuffer::RecvBuffer(int buffer_size)
+RecvBuffer::RecvBuffer(int buffer_size, bool use_mirror)
+    : m_is_pooled(false)
 {
     if(buffer_size < 0)
     {
         //TODO: crash
     }
-    m_buffer = new char[buffer_size];
-    m_max_buffer_size = buffer_size;
+
+    // 두 번 매핑하려면 크기가 매핑 단위(리눅스: 페이지, 윈도우: 64KB)의 배수여야 한다
+    const int granularity = RecvBufferPool::get_mapping_granularity();
+    const int block_size = use_mirror ? (buffer_size + granularity - 1) / granularity * granularity : buffer_size;
+
+    m_block = RecvBufferPool::create_block(block_size, use_mirror);
+    if(false == m_block->is_mirrored && block_size != buffer_size)
+    {
+        RecvBufferPool::destroy_block(m_block);
+        m_block = RecvBufferPool::create_block(buffer_size, false);
+    }
     m_read_pos = 0;
     m_write_pos = 0;
 }
 
 RecvBuffer::~RecvBuffer()
 {
-    delete[] m_buffer;
+    if(nullptr != m_block)
+        m_block->release();
 }
 
 bool RecvBuffer::OnRead(int data_size)
@@ -28,6 +39,13 @@ bool RecvBuffer::OnRead(int data_size)
         return false;
 
     m_read_pos += data_size;
+
+    // 읽기 위치가 두 번째 매핑으로 넘어가면 첫 번째 매핑의 같은 위치로 옮긴다
+    if(IsMirrored() && m_read_pos >= m_block->size)
+    {
+        m_read_pos -= m_block->size;
+        m_write_pos -= m_block->size;
+    }
     
     Clean();
     return true;
@@ -48,10 +66,73 @@ void RecvBuffer::Clean()
     int data_size = GetDataSize();
     if(data_size == 0)
         m_read_pos = m_write_pos = 0;
-    else if(data_size < /*TODO: const value*/65535 && m_read_pos > 0)
+    else if(false == IsMirrored() && m_read_pos > 0 && false == m_block->is_shared())
     {
-        ::memcpy_s(&m_buffer[0], m_read_pos, &m_buffer[m_read_pos], data_size);
+        // 슬라이스가 가리키는 앞부분을 덮어쓰면 안 되므로 공유 중일 때는 EnsureBuffer에서 새 블록으로 옮긴다
+        ::memmove(&m_block->data[0], &m_block->data[m_read_pos], data_size);
         m_read_pos = 0;
         m_write_pos = data_size;
     }
-}
\ No newline at end of file
+}
+
+void RecvBuffer::Reset()
+{
+    m_read_pos = m_write_pos = 0;
+    ReleaseIfEmpty();
+}
+
+bool RecvBuffer::EnsureBuffer()
+{
+    if(nullptr == m_block)
+    {
+        m_block = RecvBufferPool::get_instance().acquire(RecvBufferPool::MIN_BLOCK_SIZE);
+        m_read_pos = m_write_pos = 0;
+        return HasBuffer();
+    }
+
+    if(false == m_block->is_shared())
+        return true;
+
+    RecvBlock* block = m_is_pooled ? RecvBufferPool::get_instance().acquire(m_block->size) : RecvBufferPool::create_block(m_block->size, m_block->is_mirrored);
+    return MoveTo(block);
+}
+
+bool RecvBuffer::Reserve(int required_size)
+{
+    if(GetBufferSize() >= required_size)
+        return true;
+
+    if(false == m_is_pooled)
+        return false;
+
+    return MoveTo(RecvBufferPool::get_instance().acquire(required_size));
+}
+
+void RecvBuffer::ReleaseIfEmpty()
+{
+    if(false == m_is_pooled || nullptr == m_block || GetDataSize() > 0)
+        return;
+
+    m_block->release();
+    m_block = nullptr;
+    m_read_pos = m_write_pos = 0;
+}
+
+bool RecvBuffer::MoveTo(RecvBlock* block)
+{
+    if(nullptr == block)
+        return false;
+
+    // 남은 데이터는 미러링 덕분에 끝을 넘어가도 GetReadPos()부터 연속이다
+    const int data_size = GetDataSize();
+    if(data_size > 0)
+        ::memcpy(block->data, GetReadPos(), data_size);
+
+    if(nullptr != m_block)
+        m_block->release();
+
+    m_block = block;
+    m_read_pos = 0;
+    m_write_pos = data_size;
+    return true;
+}
@@ -1,26 +1,57 @@
 ﻿#pragma once
+#include "RecvBufferPool.h"
 
+// 같은 물리 페이지를 가상 주소에 두 번 연달아 매핑한 링 버퍼
+// [m_buffer, m_buffer + size) 와 [m_buffer + size, m_buffer + size * 2) 가 같은 메모리이므로
+// 끝을 넘어가는 패킷도 GetReadPos()부터 연속으로 읽을 수 있고, 읽은 뒤 앞으로 당기는 복사가 필요없다
+// 매핑에 실패하면(주소 공간, 매핑 개수 부족 등) 기존처럼 읽은 만큼 앞으로 당기는 선형 버퍼로 동작한다
+// 기본 생성자로 만든 세션 버퍼는 RecvBufferPool에서 필요할 때 빌려오고(EnsureBuffer), 큰 패킷이 오면 키우고(Reserve),
+// 비어 있으면 돌려준다(ReleaseIfEmpty). 버퍼가 없을 때의 GetRemainingSize()는 0이다
+// 받은 패킷은 복사하지 않고 블록을 참조하는 슬라이스로 꺼내므로(Packet::set_packet(RecvBlock*, char*)),
+// 슬라이스가 남아 있는 블록에 다시 쓰기 전에는 EnsureBuffer가 새 블록으로 옮겨 탄다
 class RecvBuffer
 {
 public:
     RecvBuffer();
-    RecvBuffer(int buffer_size);
+    RecvBuffer(int buffer_size, bool use_mirror = true);
     ~RecvBuffer();
 
+    RecvBuffer(const RecvBuffer&) = delete;
+    RecvBuffer& operator=(const RecvBuffer&) = delete;
+
 public:
-    char* GetReadPos() { return &m_buffer[m_read_pos]; }
-    char* GetWritePos() {return &m_buffer[m_write_pos]; }
-    int GetRemainingSize() const { return m_max_buffer_size - m_write_pos; }
+    char* GetReadPos() { return &m_block->data[m_read_pos]; }
+    char* GetWritePos() {return &m_block->data[m_write_pos]; }
+    int GetRemainingSize() const
+    {
+        if (nullptr == m_block)
+            return 0;
+        return m_block->is_mirrored ? m_block->size - GetDataSize() : m_block->size - m_write_pos;
+    }
     int GetDataSize() const { return m_write_pos - m_read_pos; } 
+    int GetBufferSize() const { return nullptr != m_block ? m_block->size : 0; }
+    bool IsMirrored() const { return nullptr != m_block && m_block->is_mirrored; }
+    bool HasBuffer() const { return nullptr != m_block; }
+    RecvBlock* GetBlock() { return m_block; }
     
 public:
     bool OnRead(int data_size);
     bool OnWrite(int data_size);
     void Clean();
+    void Reset();
+
+public:
+    // 쓸 수 있는 블록을 확보한다 (없으면 빌리고, 슬라이스와 공유 중이면 남은 데이터를 새 블록으로 옮긴다)
+    bool EnsureBuffer();
+    bool Reserve(int required_size);
+    void ReleaseIfEmpty();
+
+private:
+    bool MoveTo(RecvBlock* block);
     
 private:
-    char* m_buffer;
-    int m_max_buffer_size = 0;
+    RecvBlock* m_block = nullptr;
+    bool m_is_pooled = true;
     int m_read_pos = 0;
     int m_write_pos = 0;
 };
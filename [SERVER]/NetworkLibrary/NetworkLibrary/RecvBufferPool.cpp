@@ -0,0 +1,217 @@
+#include "pch.h"
+#include "RecvBufferPool.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+RecvBufferPool& RecvBufferPool::get_instance()
+{
+    static RecvBufferPool pool;
+    return pool;
+}
+
+RecvBufferPool::~RecvBufferPool()
+{
+    for (SizeClass& size_class : m_classes)
+    {
+        for (RecvBlock* block : size_class.free_blocks)
+            destroy_block(block);
+    }
+}
+
+void RecvBlock::release()
+{
+    if (1 != ref_count.fetch_sub(1, std::memory_order_acq_rel))
+        return;
+
+    if (is_pooled)
+        RecvBufferPool::get_instance().recycle(this);
+    else
+        RecvBufferPool::destroy_block(this);
+}
+
+RecvBlock* RecvBufferPool::create_block(int size, bool use_mirror)
+{
+    RecvBlock* block = xnew RecvBlock;
+
+    // 두 번 매핑하려면 크기가 매핑 단위(리눅스: 페이지, 윈도우: 64KB)의 배수여야 한다
+    // 단위보다 작은 클래스(윈도우의 4KB ~ 32KB)는 선형 버퍼로 만든다
+    if (use_mirror && 0 == size % get_mapping_granularity())
+    {
+        block->data = map_mirrored(size);
+        block->is_mirrored = nullptr != block->data;
+    }
+
+    if (nullptr == block->data)
+        block->data = new char[size];
+
+    block->size = size;
+    block->ref_count.store(1, std::memory_order_relaxed);
+    return block;
+}
+
+void RecvBufferPool::destroy_block(RecvBlock* block)
+{
+    if (nullptr == block)
+        return;
+
+    if (false == block->is_mirrored)
+    {
+        delete[] block->data;
+    }
+    else
+    {
+#ifdef _WIN32
+        ::UnmapViewOfFile(block->data);
+        ::UnmapViewOfFile(block->data + block->size);
+#else
+        ::munmap(block->data, static_cast<size_t>(block->size) * 2);
+#endif
+    }
+    xdelete block;
+}
+
+RecvBlock* RecvBufferPool::acquire(int required_size)
+{
+    const int class_index = get_size_class(required_size);
+    if (-1 == class_index)
+        return nullptr;
+
+    RecvBlock* block = nullptr;
+    SizeClass& size_class = m_classes[class_index];
+    {
+        std::lock_guard<std::mutex> lock(size_class.lock);
+        if (false == size_class.free_blocks.empty())
+        {
+            block = size_class.free_blocks.back();
+            size_class.free_blocks.pop_back();
+        }
+    }
+
+    if (nullptr != block)
+    {
+        m_pooled_bytes.fetch_sub(block->size, std::memory_order_relaxed);
+        block->ref_count.store(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        block = create_block(MIN_BLOCK_SIZE << class_index, true);
+        block->is_pooled = true;
+    }
+
+    m_in_use_bytes.fetch_add(block->size, std::memory_order_relaxed);
+    m_in_use_count.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+void RecvBufferPool::recycle(RecvBlock* block)
+{
+    m_in_use_bytes.fetch_sub(block->size, std::memory_order_relaxed);
+    m_in_use_count.fetch_sub(1, std::memory_order_relaxed);
+
+    SizeClass& size_class = m_classes[get_size_class(block->size)];
+    {
+        std::lock_guard<std::mutex> lock(size_class.lock);
+        if (static_cast<long long>(size_class.free_blocks.size() + 1) * block->size <= MAX_POOLED_BYTES_PER_CLASS)
+        {
+            size_class.free_blocks.push_back(block);
+            m_pooled_bytes.fetch_add(block->size, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    destroy_block(block);
+}
+
+int RecvBufferPool::get_size_class(int required_size)
+{
+    int class_size = MIN_BLOCK_SIZE;
+    for (int class_index = 0; class_index < SIZE_CLASS_COUNT; ++class_index, class_size <<= 1)
+    {
+        if (required_size <= class_size)
+            return class_index;
+    }
+
+    return -1;
+}
+
+int RecvBufferPool::get_mapping_granularity()
+{
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    ::GetSystemInfo(&system_info);
+    return static_cast<int>(system_info.dwAllocationGranularity);
+#else
+    return static_cast<int>(::sysconf(_SC_PAGESIZE));
+#endif
+}
+
+char* RecvBufferPool::map_mirrored(int size)
+{
+#ifdef _WIN32
+    HANDLE mapping = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, size, nullptr);
+    if (nullptr == mapping)
+        return nullptr;
+
+    // 예약한 주소를 풀고 그 자리에 매핑하는 사이에 다른 스레드가 끼어들 수 있으므로 몇 번 다시 시도한다
+    char* buffer = nullptr;
+    for (int retry = 0; retry < 8 && nullptr == buffer; ++retry)
+    {
+        void* address = ::VirtualAlloc(nullptr, static_cast<SIZE_T>(size) * 2, MEM_RESERVE, PAGE_NOACCESS);
+        if (nullptr == address)
+            break;
+        ::VirtualFree(address, 0, MEM_RELEASE);
+
+        char* base = static_cast<char*>(address);
+        void* first = ::MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, base);
+        void* second = ::MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, base + size);
+        if (nullptr != first && nullptr != second)
+        {
+            buffer = base;
+            break;
+        }
+
+        if (nullptr != first)
+            ::UnmapViewOfFile(first);
+        if (nullptr != second)
+            ::UnmapViewOfFile(second);
+    }
+
+    // 뷰가 매핑을 참조하고 있으므로 핸들은 바로 닫아도 된다
+    ::CloseHandle(mapping);
+    return buffer;
+#else
+    const int fd = ::memfd_create("recv_buffer", MFD_CLOEXEC);
+    if (-1 == fd)
+        return nullptr;
+
+    if (-1 == ::ftruncate(fd, size))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    // 두 배 크기의 주소 공간을 먼저 잡아두고 그 위에 같은 파일을 두 번 덮어 매핑한다
+    void* address = ::mmap(nullptr, static_cast<size_t>(size) * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == address)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    char* base = static_cast<char*>(address);
+    const bool is_mapped =
+        MAP_FAILED != ::mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) &&
+        MAP_FAILED != ::mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    ::close(fd);
+
+    if (false == is_mapped)
+    {
+        ::munmap(address, static_cast<size_t>(size) * 2);
+        return nullptr;
+    }
+
+    return base;
+#endif
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// 수신 버퍼 한 덩어리. 세션의 RecvBuffer와, 이 블록을 가리키는 받은 패킷(Packet 슬라이스)들이 참조를 나눠 가진다
+// 마지막 참조가 release되면 풀로 돌아간다 (풀을 거치지 않고 만든 블록은 바로 해제된다)
+// is_mirrored면 [data, data + size) 가 바로 뒤에 한 번 더 매핑되어 있다
+struct RecvBlock
+{
+    char* data = nullptr;
+    int size = 0;
+    bool is_mirrored = false;
+    bool is_pooled = false;
+    std::atomic<int> ref_count{ 0 };
+
+    void add_ref() { ref_count.fetch_add(1, std::memory_order_relaxed); }
+    void release();
+    bool is_shared() const { return ref_count.load(std::memory_order_acquire) > 1; }
+};
+
+// 세션 수신 버퍼를 크기별(4KB ~ 64KB)로 모아두고 재사용하는 풀
+// 세션은 가장 작은 크기로 시작해 헤더가 더 큰 패킷을 알려줄 때만 큰 버퍼로 바꾸고, 받을 데이터가 없으면 돌려준다
+// 한 클래스에 쌓아두는 빈 버퍼가 MAX_POOLED_BYTES_PER_CLASS를 넘으면 바로 해제한다
+class RecvBufferPool
+{
+public:
+    static constexpr int MIN_BLOCK_SIZE = 4 * 1024;
+    static constexpr int MAX_BLOCK_SIZE = 64 * 1024;
+    static constexpr int SIZE_CLASS_COUNT = 5;
+    static constexpr long long MAX_POOLED_BYTES_PER_CLASS = 16 * 1024 * 1024;
+
+public:
+    static RecvBufferPool& get_instance();
+
+    // 풀을 거치지 않는 버퍼(벤치마크 등)도 같은 방식으로 만든다. 참조 1개로 시작한다
+    static RecvBlock* create_block(int size, bool use_mirror);
+    static void destroy_block(RecvBlock* block);
+    static int get_mapping_granularity();
+
+public:
+    // 참조 1개로 시작하는 블록을 빌려준다. 돌려줄 때는 RecvBlock::release
+    RecvBlock* acquire(int required_size);
+
+public:
+    long long get_in_use_bytes() const { return m_in_use_bytes.load(std::memory_order_relaxed); }
+    long long get_pooled_bytes() const { return m_pooled_bytes.load(std::memory_order_relaxed); }
+    int get_in_use_count() const { return m_in_use_count.load(std::memory_order_relaxed); }
+
+private:
+    friend struct RecvBlock;
+
+    RecvBufferPool() = default;
+    ~RecvBufferPool();
+
+    void recycle(RecvBlock* block);
+
+    static int get_size_class(int required_size);
+    static char* map_mirrored(int size);
+
+private:
+    struct SizeClass
+    {
+        std::mutex lock;
+        std::vector<RecvBlock*> free_blocks;
+    };
+
+    SizeClass m_classes[SIZE_CLASS_COUNT];
+    std::atomic<long long> m_in_use_bytes{ 0 };
+    std::atomic<long long> m_pooled_bytes{ 0 };
+    std::atomic<int> m_in_use_count{ 0 };
+};
@@ -3,10 +3,11 @@
 
 #include <memory>
 #include <memory>
+#include <random>
 
-void ServerBase::init(int iocp_thread_count, int hard_task_thread_count, std::function<std::shared_ptr<NetworkSection>()> section_factory, int section_count)
+void ServerBase::init(int iocp_thread_count, int hard_task_thread_count, std::function<std::shared_ptr<NetworkSection>()> section_factory, int section_count, IoEngineType io_engine_type)
 {
-    NetworkCore::init(iocp_thread_count);
+    NetworkCore::init(iocp_thread_count, io_engine_type);
 
     if (performance_check_mode)
     {
@@ -17,14 +18,15 @@ void ServerBase::init(int iocp_thread_count, int hard_task_thread_count, std::fu
         m_performance_monitor_thread = std::thread(&ServerBase::fps_monitor_thread_work, this);
     }
     
-    m_central_thread = std::thread(&ServerBase::central_thread_work, this);
-
-    for (int i = 0; i < hard_task_thread_count; ++i)
+    m_hard_task_pool.init(this, hard_task_thread_count);
+    // 보낼 패킷의 압축은 하드 task 워커와 따로 둔 작은 워커 묶음이 한다 (DB로 막힌 하드 task 워커를 기다리지 않게)
+    if (packet_compression_mode && 0 < packet_compression_thread_count)
     {
-        m_hard_task_threads.push_back(std::thread(&ServerBase::hard_task_thread_work, this));
+        m_compression_pool.init(this, packet_compression_thread_count);
+        m_compression_pool.set_max_thread_count(packet_compression_thread_count);
+        PacketCompressor::get_instance().set_worker_pool(&m_compression_pool);
     }
     
-    m_listen_socket = NetworkUtil::create_socket();
     m_section_factory = section_factory;
     
     for(int i = 0; i < section_count; ++i)
@@ -33,31 +35,61 @@ void ServerBase::init(int iocp_thread_count, int hard_task_thread_count, std::fu
         int section_id = NetworkSection::generate_section_id();
         section->init(this, section_id);
         m_sections.emplace(section_id, section);
+        m_section_list.push_back(section.get());
+
+        // 섹션마다 링 위에 여러 점을 찍어 key가 고르게 나뉘게 한다
+        for (int node = 0; node < SECTION_RING_VIRTUAL_NODE_COUNT; ++node)
+            m_section_ring.emplace_back(mix_hash((static_cast<unsigned long long>(section_id) << 32) | node), section.get());
     }
+    std::sort(m_section_ring.begin(), m_section_ring.end());
 }
-void ServerBase::open(std::string open_ip, int open_port, std::function<std::shared_ptr<ClientSession>()> session_factory, int accept_back_log)
+void ServerBase::open(std::string open_ip, int open_port, std::function<ClientSession*()> session_factory, int accept_count)
 {
-    m_session_factory = session_factory;
+    m_session_pool.init(std::move(session_factory));
 
-    NetworkUtil::bind(m_listen_socket, open_ip.c_str(), open_port);
-    NetworkUtil::listen(m_listen_socket, 1);
-    NetworkUtil::register_socket(m_iocp_handle, m_listen_socket);
+    int listener_count = 1;
+#ifndef _WIN32
+    listener_count = 0 < reuse_port_listener_count ? reuse_port_listener_count : std::max(1, m_io_thread_count);
+#endif
+    if (0 >= accept_count)
+        accept_count = std::max(1, accept_post_count);
 
-    for(int i = 0; i < accept_back_log; ++i)
+    for (int i = 0; i < listener_count; ++i)
     {
-        AcceptIO* io = new AcceptIO;
-        io->m_socket = NetworkUtil::create_socket();
-        NetworkUtil::register_socket(m_iocp_handle, io->m_socket);
-        
-        if(false == NetworkUtil::accept(m_listen_socket, io))
+        SOCKET listen_socket = NetworkUtil::create_socket();
+        if (1 < listener_count && false == NetworkUtil::set_reuse_port(listen_socket))
+        {
+            // 여러 개를 열 수 없으면 하나로 받는다
+            closesocket(listen_socket);
+            if (false == m_listen_sockets.empty())
+                break;
+            listener_count = 1;
+            listen_socket = NetworkUtil::create_socket();
+        }
+
+        if (false == NetworkUtil::bind(listen_socket, open_ip.c_str(), open_port)
+            || false == NetworkUtil::listen(listen_socket, listen_backlog)
+            || false == NetworkUtil::register_socket(m_iocp_handle, listen_socket))
+        {
+            // TODO: STOP SERVER
+            closesocket(listen_socket);
+            return;
+        }
+        m_listen_sockets.push_back(listen_socket);
+
+        for (int j = 0; j < accept_count; ++j)
         {
-            // TODO: STOP SERVER 
-            return; 
+            AcceptIO* io = new AcceptIO;
+            io->m_listen_socket = listen_socket;
+            if (false == post_accept(io))
+            {
+                // TODO: STOP SERVER
+                return;
+            }
         }
     }
-    
 
-    std::cout << "Listening..." << std::endl;
+    std::cout << "Listening... (listeners: " << m_listen_sockets.size() << ", accepts per listener: " << accept_count << ", backlog: " << listen_backlog << ")" << std::endl;
 }
 
 void ServerBase::on_accept(int bytes_transferred, NetworkIO* io) {
@@ -66,99 +98,165 @@ void ServerBase::on_accept(int bytes_transferred, NetworkIO* io) {
         increment_accept_count_for_tps();
     
     AcceptIO* accept_io = reinterpret_cast<AcceptIO*>(io);
+    const SOCKET socket = accept_io->m_socket;
+    const sockaddr_in remote_addr = *reinterpret_cast<sockaddr_in*>(NetworkUtil::get_remote_sockaddr(accept_io->m_accept_buffer));
 
-    
-    auto session = m_session_factory();
-    session->init();
-    session->set_id(Session::generate_session_id());
-    session->set_socket(accept_io->m_socket);
+    // 세션을 만들고 섹션에 넣는 동안에도 다음 연결을 받도록 받은 소켓과 주소만 꺼내고 바로 다시 건다
+    post_accept(accept_io);
+
+    std::shared_ptr<ClientSession> session = m_session_pool.acquire();
+    session->set_id(m_session_registry.add(session));
+    if (0 == session->get_id())
+    {
+        // 세션 표가 다 찼으면 받지 않는다
+        std::cout << "session registry is full" << std::endl;
+        closesocket(socket);
+        return;
+    }
+    session->set_socket(socket);
 
-    sockaddr* remote_addr = NetworkUtil::get_remote_sockaddr(accept_io->m_accept_buffer);
-    sockaddr_in* addr_in = reinterpret_cast<sockaddr_in*>(remote_addr);
     char output_ip[INET_ADDRSTRLEN] = {0, };
-    inet_ntop(addr_in->sin_family, &addr_in->sin_addr, output_ip, INET_ADDRSTRLEN);
+    inet_ntop(remote_addr.sin_family, &remote_addr.sin_addr, output_ip, INET_ADDRSTRLEN);
     
     session->set_remote_ip(output_ip);
-    session->set_remote_port(ntohs(reinterpret_cast<sockaddr_in*>(remote_addr)->sin_port));
+    session->set_remote_port(ntohs(remote_addr.sin_port));
 
     NetworkUtil::register_socket(m_iocp_handle, session->get_socket());
-    session->complete_connect();
     
-    std::shared_ptr<NetworkSection> first_section = select_first_section();
+    std::shared_ptr<NetworkSection> first_section = select_first_section(*session);
     if (nullptr == first_section)
     {
         std::cout << "first section is nullptr" << std::endl;
+        m_session_registry.remove(session->get_id());
+        closesocket(socket);
         // TODO: LOG
         // TODO: stop server
         return;
     }
 
-    first_section->enter_section(session); // TODO: 로드 밸런싱 로직
+    // 섹션에 먼저 넣어야 recv를 걸자마자 끊겨도 on_disconnected가 세션을 섹션과 세션 표에서 뺀다
+    first_section->enter_section(session);
+    session->complete_connect();
 
 
     std::cout << "Accept complete => ip: " << session->get_remote_ip() << ", port: " << session->get_remote_port() << std::endl;
-    
+}
+
+bool ServerBase::post_accept(AcceptIO* accept_io)
+{
     accept_io->Init();
-    accept_io->m_socket = NetworkUtil::create_socket();
-    if(false == NetworkUtil::accept(m_listen_socket, accept_io))
+#ifdef _WIN32
+    // DisconnectEx로 끊어 모아 둔 소켓이 있으면 새로 만들지 않는다
+    accept_io->m_socket = m_session_pool.pop_socket();
+    if (INVALID_SOCKET == accept_io->m_socket)
+        accept_io->m_socket = NetworkUtil::create_socket();
+#else
+    // accept4와 멀티샷 accept가 소켓을 만들어 주므로 미리 만들지 않는다
+    accept_io->m_socket = INVALID_SOCKET;
+#endif
+    if(false == NetworkUtil::accept(accept_io->m_listen_socket, accept_io))
     {
         // 서버 중지
-        return;
+        return false;
     }
-}
 
-void ServerBase::push_hard_task(iTask* task)
-{
-    if (task) {
-        m_hard_task_queue.push(task);
-    }
+    return true;
 }
 
-void ServerBase::push_hard_task(std::shared_ptr<iTask> task)
+std::shared_ptr<NetworkSection> ServerBase::select_first_section(ClientSession& session)
 {
-    if (task) {
-        m_hard_task_queue.push(task.get());
-    }
+    unsigned long long key = 0;
+    if (SectionSelectPolicy::CONSISTENT_HASH == section_select_policy)
+        key = std::hash<std::string>()(session.get_remote_ip());
+    return select_section(section_select_policy, key);
 }
 
-void ServerBase::central_thread_work()
+std::shared_ptr<NetworkSection> ServerBase::select_section(SectionSelectPolicy policy, unsigned long long key)
 {
-    while(is_running() == true)
-    {
-        Packet* packet;
+    if (m_section_list.empty())
+        return nullptr;
 
-        if(false == m_packet_queue.try_pop(packet))
-            continue;
-        
-        Session* session = packet->get_owner();
-        if (nullptr == session)
+    NetworkSection* selected = m_section_list.front();
+    switch (policy)
+    {
+    case SectionSelectPolicy::FIRST:
+        break;
+    case SectionSelectPolicy::LEAST_SESSIONS:
+        for (NetworkSection* section : m_section_list)
         {
-            //TODO: 로그
-            xdelete packet;
-            continue;
+            if (section->get_session_count() < selected->get_session_count())
+                selected = section;
         }
-
-        auto section = session->get_section();
-        if (nullptr == section)
+        break;
+    case SectionSelectPolicy::LEAST_QUEUED:
+        for (NetworkSection* section : m_section_list)
         {
-            //TODO: 로그
-            xdelete packet;
-            continue;
+            const long long queued_count = section->get_queued_count();
+            const long long selected_queued_count = selected->get_queued_count();
+            if (queued_count < selected_queued_count || (queued_count == selected_queued_count && section->get_session_count() < selected->get_session_count()))
+                selected = section;
         }
-
-        iTask* task = xnew iTask;
-        task->func = [session_weak_ptr = session->weak_from_this(), packet]()
+        break;
+    case SectionSelectPolicy::POWER_OF_TWO_LOAD:
+        if (1 < m_section_list.size())
         {
-            auto session = session_weak_ptr.lock();
-            if (nullptr == session)
-            {
-                xdelete packet;
-                return;
-            }
-            session->execute_packet(packet);
-        };
-        
-        section->push_task(task);
+            // 모두를 보고 가장 한가한 곳을 고르면 부하 값이 다시 재질 때까지 새 연결이 한 섹션에 몰린다
+            thread_local std::mt19937 random(std::random_device{}());
+            std::uniform_int_distribution<size_t> pick(0, m_section_list.size() - 1);
+            const size_t first = pick(random);
+            size_t second = pick(random);
+            if (first == second)
+                second = (second + 1) % m_section_list.size();
+
+            NetworkSection* a = m_section_list[first];
+            NetworkSection* b = m_section_list[second];
+            const bool is_b_lighter = b->get_load() < a->get_load() || (b->get_load() == a->get_load() && b->get_session_count() < a->get_session_count());
+            selected = is_b_lighter ? b : a;
+        }
+        break;
+    case SectionSelectPolicy::CONSISTENT_HASH:
+        return select_section_by_key(key);
+    }
+
+    return selected->shared_from_this();
+}
+
+std::shared_ptr<NetworkSection> ServerBase::select_section_by_key(unsigned long long key)
+{
+    if (m_section_ring.empty())
+        return nullptr;
+
+    // key의 해시보다 크거나 같은 첫 점의 섹션 (끝을 넘으면 처음으로 돈다)
+    const unsigned long long hash = mix_hash(key);
+    auto it = std::lower_bound(m_section_ring.begin(), m_section_ring.end(), hash,
+                               [](const std::pair<unsigned long long, NetworkSection*>& node, unsigned long long value) { return node.first < value; });
+    if (it == m_section_ring.end())
+        it = m_section_ring.begin();
+    return it->second->shared_from_this();
+}
+
+unsigned long long ServerBase::mix_hash(unsigned long long value)
+{
+    // splitmix64의 마무리 단계. 연속된 값도 비트가 고르게 퍼진다
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+void ServerBase::push_hard_task(iTask* task, HardTaskPriority priority)
+{
+    if (task) {
+        m_hard_task_pool.push(task, priority);
+    }
+}
+
+void ServerBase::push_hard_task(std::shared_ptr<iTask> task, HardTaskPriority priority)
+{
+    if (task) {
+        m_hard_task_pool.push(task.get(), priority);
     }
 }
 
@@ -224,6 +322,11 @@ double ServerBase::get_send_tps_avg()
     return (active_sections > 0) ? total_tps / active_sections : 0;
 }
 
+int ServerBase::get_session_count()
+{
+    return m_session_registry.get_count();
+}
+
 void ServerBase::update_accept_tps_info()
 {
     auto current_time = std::chrono::high_resolution_clock::now();
@@ -249,12 +352,102 @@ void ServerBase::print_fps_info()
     std::cout << "Accept TPS: " << static_cast<int>(get_accept_tps()) << std::endl;
     std::cout << "Average RECV TPS: " << static_cast<int>(get_recv_tps_avg()) << std::endl;
     std::cout << "Average SEND TPS: " << static_cast<int>(get_send_tps_avg()) << std::endl;
+
+    // 수신 버퍼 메모리 (풀은 프로세스 전체에서 공유하므로 같은 프로세스의 클라이언트 세션도 포함된다)
+    RecvBufferPool& recv_buffer_pool = RecvBufferPool::get_instance();
+    const int session_count = get_session_count();
+    std::cout << "Sessions: " << session_count
+              << ", Recv Buffer In Use: " << recv_buffer_pool.get_in_use_bytes() / 1024 << " KB (" << recv_buffer_pool.get_in_use_count() << " blocks)"
+              << ", Pooled: " << recv_buffer_pool.get_pooled_bytes() / 1024 << " KB"
+              << ", Per Session: " << (session_count > 0 ? recv_buffer_pool.get_in_use_bytes() / session_count : 0) << " bytes" << std::endl;
+
+    std::cout << "Session Pool Created: " << m_session_pool.get_created_count() << ", Reused: " << m_session_pool.get_reused_count()
+              << ", Pooled: " << m_session_pool.get_pooled_count() << ", Pooled Sockets: " << m_session_pool.get_pooled_socket_count()
+              << ", Reused Sockets: " << m_session_pool.get_socket_reused_count() << std::endl;
+
+    PacketBufferPool& packet_buffer_pool = PacketBufferPool::get_instance();
+    std::cout << "Packet Buffer Hit: " << packet_buffer_pool.get_hit_count()
+              << ", Miss: " << packet_buffer_pool.get_miss_count()
+              << ", Outstanding: " << packet_buffer_pool.get_outstanding_bytes() / 1024 << " KB" << std::endl;
+
+    const long long send_call_count = MultiSender::get_send_call_count();
+    const long long sent_packet_count = MultiSender::get_sent_packet_count();
+    std::cout << "Send Calls: " << send_call_count << ", Sent Packets: " << sent_packet_count
+              << ", Send Calls Per Packet: " << (sent_packet_count > 0 ? static_cast<double>(send_call_count) / sent_packet_count : 0) << std::endl;
+
+    // 세션 send 큐 깊이와 밀린 클라이언트 처리
+    SendQueueDepth send_queue_depth;
+    for (auto& section_pair : m_sections)
+        section_pair.second->collect_send_queue_depth(send_queue_depth);
+    std::cout << "Send Queue Total: " << send_queue_depth.total_bytes / 1024 << " KB, Max Session: " << send_queue_depth.max_bytes / 1024 << " KB / "
+              << send_queue_depth.max_packet_count << " packets, Over Watermark: " << send_queue_depth.over_watermark_session_count << " sessions"
+              << ", Dropped: " << MultiSender::get_dropped_packet_count() << ", Conflated: " << MultiSender::get_conflated_packet_count()
+              << ", Slow Consumers: " << MultiSender::get_slow_consumer_count() << ", Partial Sends: " << MultiSender::get_partial_send_count() << std::endl;
+
+    // 압축을 켠 packet_number마다 압축률(압축된 본문 / 원래 본문)과 패킷 하나당 압축 / 해제 시간
+    PacketCompressor& packet_compressor = PacketCompressor::get_instance();
+    std::cout << "Compression Threads: " << m_compression_pool.get_thread_count() << ", Queued: " << m_compression_pool.get_queued_task_count()
+              << ", Inline: " << packet_compressor.get_inline_count() << std::endl;
+    for (int protocol_number = 0; protocol_number < PacketCompressor::MAX_PROTOCOL_COUNT; ++protocol_number)
+    {
+        const PacketCompressor::Stats stats = packet_compressor.get_stats(static_cast<unsigned short>(protocol_number));
+        if (false == packet_compressor.is_enabled(static_cast<unsigned short>(protocol_number)) && 0 == stats.decompressed_count)
+            continue;
+
+        const long long compress_try_count = stats.compressed_count + stats.skipped_count;
+        std::cout << "Packet Compression " << packet_number_Name(protocol_number) << ": " << stats.compressed_count << " compressed, " << stats.skipped_count << " skipped"
+                  << ", Ratio: " << (stats.raw_bytes > 0 ? static_cast<double>(stats.compressed_bytes) / stats.raw_bytes : 1)
+                  << ", Compress: " << (compress_try_count > 0 ? stats.compress_ns / compress_try_count : 0) << " ns"
+                  << ", Decompressed: " << stats.decompressed_count << ", Decompress: " << (stats.decompressed_count > 0 ? stats.decompress_ns / stats.decompressed_count : 0) << " ns" << std::endl;
+    }
+
+    // 하드 task 큐 대기 시간 (지난 출력 이후 구간)
+    static const char* const priority_names[HARD_TASK_PRIORITY_COUNT] = { "Interactive", "Normal", "Background" };
+    std::cout << "Hard Task Threads: " << m_hard_task_pool.get_thread_count() << " (" << m_hard_task_pool.get_min_thread_count() << "~" << m_hard_task_pool.get_max_thread_count() << ")"
+              << ", Blocked: " << m_hard_task_pool.get_blocked_thread_count() << ", Queued: " << m_hard_task_pool.get_queued_task_count()
+              << ", Grown: " << m_hard_task_pool.get_grow_count() << ", Shrunk: " << m_hard_task_pool.get_shrink_count() << std::endl;
+    std::cout << "Hard Task Queue Wait";
+    for (int priority = 0; priority < HARD_TASK_PRIORITY_COUNT; ++priority)
+    {
+        const HardTaskPriority hard_task_priority = static_cast<HardTaskPriority>(priority);
+        std::cout << (0 == priority ? " " : ", ") << priority_names[priority] << ": " << m_hard_task_pool.get_wait_count(hard_task_priority) << " tasks, avg "
+                  << static_cast<long long>(m_hard_task_pool.get_wait_avg_us(hard_task_priority)) << " us, max " << m_hard_task_pool.get_wait_max_us(hard_task_priority) << " us";
+    }
+    std::cout << std::endl;
+
+    // 섹션 아레나에서 디코딩한 메시지마다 아레나가 힙에서 블록을 받은 횟수 (첫 블록에 다 들어가면 0)
+    long long arena_message_count = 0;
+    long long arena_block_alloc_count = 0;
+    long long arena_peak_used_bytes = 0;
+    for (auto& section_pair : m_sections)
+    {
+        MessageArena& message_arena = section_pair.second->get_message_arena();
+        arena_message_count += message_arena.get_created_count();
+        arena_block_alloc_count += message_arena.get_block_alloc_count();
+        arena_peak_used_bytes = std::max(arena_peak_used_bytes, message_arena.get_peak_used_bytes());
+    }
+    std::cout << "Message Arena Messages: " << arena_message_count << ", Block Allocs: " << arena_block_alloc_count
+              << ", Allocs Per Message: " << (arena_message_count > 0 ? static_cast<double>(arena_block_alloc_count) / arena_message_count : 0)
+              << ", Peak Used: " << arena_peak_used_bytes / 1024 << " KB" << std::endl;
     
     for (auto& section_pair : m_sections)
     {
         std::cout << "Section " << section_pair.first << " FPS: " << static_cast<int>(section_pair.second->get_fps()) 
                   << ", Recv TPS: " << section_pair.second->get_recv_tps()
-                  << ", Send TPS: " << section_pair.second->get_send_tps() << std::endl;
+                  << ", Send TPS: " << section_pair.second->get_send_tps()
+                  << ", Sessions: " << section_pair.second->get_session_count()
+                  << ", Queued: " << section_pair.second->get_queued_count()
+                  << ", Load: " << static_cast<int>(section_pair.second->get_load() * 100) << "%";
+        // tick 모드면 FPS는 실제로 돈 tick 수다
+        if (0 < section_pair.second->get_tick_rate())
+        {
+            std::cout << ", Tick Rate: " << section_pair.second->get_tick_rate()
+                      << ", Late Ticks: " << section_pair.second->get_late_tick_count()
+                      << ", Overrun Ticks: " << section_pair.second->get_overrun_tick_count()
+                      << ", Skipped Ticks: " << section_pair.second->get_skipped_tick_count()
+                      << ", Max Tick Work: " << section_pair.second->get_max_tick_work_us() << " us";
+        }
+        std::cout << std::endl;
     }
     std::cout << "===============================" << std::endl;
 }
@@ -266,55 +459,11 @@ void ServerBase::fps_monitor_thread_work()
         std::this_thread::sleep_for(std::chrono::seconds(server_fps_check_interval));
         
         update_accept_tps_info();
+        m_hard_task_pool.update_wait_stats();
         print_fps_info();
     }
 }
 
-void ServerBase::hard_task_thread_work()
-{
-    while (true == is_running())
-    {
-        iTask* task = nullptr;
-
-        if (false == m_hard_task_queue.try_pop(task))
-            continue;
-        
-        if(std::chrono::steady_clock::now() < task->execute_time)
-        {
-            m_hard_task_queue.push(task);
-            continue;
-        }
-
-        try
-        {
-            task->func();
-
-            if (nullptr != task->post_processing_func)
-                task->post_processing_func();
-        }
-        catch (const std::exception& e)
-        {
-            std::cerr << "[hard_task] exception: " << e.what() << std::endl;
-            xdelete task;
-            continue;
-        }
-        catch (...)
-        {
-            std::cerr << "[hard_task] unknown exception" << std::endl;
-            xdelete task;
-            continue;
-        }
-
-        if(task->is_repeat)
-        {
-            task->execute_time = std::chrono::steady_clock::now() + std::chrono::microseconds(task->delay_time);
-            m_hard_task_queue.push(task);
-        }
-        else
-            xdelete task;
-    }
-}
-
 void ServerBase::on_iocp_io(NetworkIO* io, int bytes_transferred)
 {
     Session* session = io->get_session();
@@ -7,12 +7,15 @@ public:
     virtual ~ServerBase() = default;
     
 public:
-    virtual void init(int iocp_thread_count = 1, int hard_task_thread_count = 1, std::function<std::shared_ptr<class NetworkSection>()> section_factory = {}, int section_count = 0);
-    void open(std::string open_ip, int open_port, std::function<std::shared_ptr<class ClientSession>()> session_factory, int accpet_back_log = 1);
+    virtual void init(int iocp_thread_count = 1, int hard_task_thread_count = 1, std::function<std::shared_ptr<class NetworkSection>()> section_factory = {}, int section_count = 0, IoEngineType io_engine_type = IoEngineType::DEFAULT);
+    // 리슨 소켓마다 AcceptIO를 accept_count개 걸어둔다 (0이면 accept_post_count). 리슨 소켓 수와 backlog는 config.h
+    // session_factory로 만든 세션은 끊긴 뒤 SessionPool에 모아 다시 쓴다 (지울 때는 xdelete)
+    void open(std::string open_ip, int open_port, std::function<class ClientSession*()> session_factory, int accept_count = 0);
     
     double get_fps_avg();
     double get_recv_tps_avg();
     double get_send_tps_avg();
+    int get_session_count();
     void print_fps_info();
     
     double get_accept_tps() const { return m_current_accept_tps; }
@@ -22,30 +25,42 @@ public:
 public:
     void on_accept(int bytes_transferred, NetworkIO* io);
     
-    void push_hard_task(iTask* task);
-    void push_hard_task(std::shared_ptr<iTask> task);
+    void push_hard_task(iTask* task, HardTaskPriority priority = HardTaskPriority::NORMAL);
+    void push_hard_task(std::shared_ptr<iTask> task, HardTaskPriority priority = HardTaskPriority::NORMAL);
+    HardTaskPool& get_hard_task_pool() { return m_hard_task_pool; }
+    SessionRegistry& get_session_registry() { return m_session_registry; }
+    SessionPool& get_session_pool() { return m_session_pool; }
+
+    // policy에 따라 섹션을 고른다 (섹션이 없으면 nullptr). key는 CONSISTENT_HASH에서만 쓴다
+    std::shared_ptr<NetworkSection> select_section(SectionSelectPolicy policy, unsigned long long key = 0);
+    // 같은 key(계정 id 등)는 섹션 구성이 같은 동안 항상 같은 섹션을 고른다. 섹션이 늘거나 줄어도 대부분의 key는 그대로다
+    std::shared_ptr<NetworkSection> select_section_by_key(unsigned long long key);
     
 private:
-    void central_thread_work();
+    bool post_accept(AcceptIO* accept_io);
+    static unsigned long long mix_hash(unsigned long long value);
     void fps_monitor_thread_work();
-    void hard_task_thread_work();
 
 protected:
     void on_iocp_io(NetworkIO* io, int bytes_transferred) override;
-    virtual std::shared_ptr<NetworkSection> select_first_section() abstract;
+    // 새 연결이 처음 들어갈 섹션. 기본은 section_select_policy를 따르고, CONSISTENT_HASH면 접속 IP로 고른다
+    virtual std::shared_ptr<NetworkSection> select_first_section(class ClientSession& session);
 
 protected:
-    SOCKET m_listen_socket;
+    std::vector<SOCKET> m_listen_sockets; // SO_REUSEPORT로 같은 포트에 연 리슨 소켓들 (open 뒤로 바뀌지 않는다)
     
-    std::thread m_central_thread;
     std::thread m_performance_monitor_thread;
     
-    std::vector<std::thread> m_hard_task_threads;
-    concurrency::concurrent_queue<iTask*> m_hard_task_queue;
+    HardTaskPool m_hard_task_pool;
+    HardTaskPool m_compression_pool; // 보낼 패킷만 압축하는 워커 (PacketCompressor)
+    SessionRegistry m_session_registry;
+    SessionPool m_session_pool;
 
     std::map<unsigned int, std::shared_ptr<NetworkSection>> m_sections;
+    std::vector<NetworkSection*> m_section_list;                                 // 무작위로 고르기 위해 m_sections를 배열로 (init 뒤로 바뀌지 않는다)
+    std::vector<std::pair<unsigned long long, NetworkSection*>> m_section_ring;  // 일관된 해싱 링 (해시 순)
+    static constexpr int SECTION_RING_VIRTUAL_NODE_COUNT = 64;
     std::function<std::shared_ptr<NetworkSection>()> m_section_factory;
-    std::function<std::shared_ptr<ClientSession>()> m_session_factory;
     
     // Accept TPS 측정 관련
     std::chrono::high_resolution_clock::time_point m_last_accept_tps_time;
@@ -3,9 +3,9 @@
 
 int Session::generate_session_id()
 {
-    static int session_id = 0;
+    static std::atomic<int> session_id{ 0 };
 
-    return ++session_id;
+    return session_id.fetch_add(1, std::memory_order_relaxed) + 1;
 }
 
 void Session::init()
@@ -15,7 +15,8 @@ void Session::init()
 
 void Session::finalize()
 {
-    m_recv_buffer.Clean();
+    m_is_connected = false;
+    m_recv_buffer.Reset();
     m_connecting_socket = INVALID_SOCKET;
     m_remote_ip = "";
     m_remote_port = 0;
@@ -68,6 +69,10 @@ bool Session::do_recieve()
 
 bool Session::do_send(std::shared_ptr<Packet> packet)
 {
+    // 끊긴 뒤에 섹션 task나 DB 콜백에서 늦게 보내는 패킷은 쌓지 않는다
+    if (nullptr == packet || false == is_connected())
+        return false;
+
     if (performance_check_mode)
     {
         ClientSession* client_session = dynamic_cast<ClientSession*>(this);
@@ -79,20 +84,13 @@ bool Session::do_send(std::shared_ptr<Packet> packet)
         }
     }
     
-    m_multi_sender.register_packet(packet);
+    m_multi_sender.register_packet(std::move(packet));
     return true;
 }
 
 bool Session::do_send(google::protobuf::Message& message)
 {
-    unsigned short protocol_number = PacketNumberMapper::GetProtocolNumber(message.GetTypeName());
-
-    std::shared_ptr<Packet> packet = xmake_shared(Packet);
-    packet->initialize(protocol_number);
-    packet->push(message);
-    packet->finalize();
-
-    return do_send(packet);
+    return do_send(Packet::create(PacketNumberMapper::GetProtocolNumber(message.GetTypeName()), message));
 }
 
 bool Session::do_disconnect()
@@ -121,6 +119,13 @@ void Session::complete_recieve(int bytes_transferred)
 {
     if (bytes_transferred == 0)
     {
+        // 버퍼를 풀에 돌려둔 채 걸었던 0 바이트 recv(IOCP)가 끝났으면 이제 버퍼를 받아 실제로 읽는다
+        if (false == m_recv_buffer.HasBuffer() && m_recv_buffer.EnsureBuffer())
+        {
+            do_recieve();
+            return;
+        }
+
         // TODO: LOG
         do_disconnect();
         return;
@@ -153,6 +158,9 @@ void Session::complete_recieve(int bytes_transferred)
         //TODO: LOG
         return;
     }
+
+    // 다 처리해서 비었으면 다음 데이터가 올 때까지 버퍼를 풀에 돌려준다
+    m_recv_buffer.ReleaseIfEmpty();
     
     if(false == do_recieve())
     {
@@ -163,17 +171,42 @@ void Session::complete_recieve(int bytes_transferred)
 
 void Session::complete_send(int bytes_transferred)
 {
+    // on_send가 send 동안 잡아둔 참조를 놓아도 이 함수가 끝날 때까지는 지워지지 않게 한다
+    std::shared_ptr<Session> sending_owner = m_multi_sender.get_sending_owner();
     on_send(bytes_transferred);
-    m_multi_sender.on_send();
+    m_multi_sender.on_send(bytes_transferred);
+}
+
+bool Session::acquire_socket()
+{
+    // complete_disconnect와 반대 순서로 확인하므로 (seq_cst) 둘 중 하나는 반드시 상대를 본다
+    m_socket_user_count.fetch_add(1);
+    if (m_is_connected.load())
+        return true;
+
+    m_socket_user_count.fetch_sub(1);
+    return false;
 }
 
 void Session::complete_disconnect()
 {
     m_is_connected = false;
-    closesocket(m_connecting_socket);
+
+    // 이미 소켓을 잡고 send를 거는 중인 스레드가 끝난 뒤에 닫는다
+    while (0 < m_socket_user_count.load())
+        std::this_thread::yield();
+    close_socket();
     on_disconnected();
 }
 
+void Session::close_socket()
+{
+    // 리눅스는 닫은 fd 번호를 바로 다음 소켓에 다시 주므로 세션에 남겨두지 않는다
+    const SOCKET socket = m_connecting_socket;
+    m_connecting_socket = INVALID_SOCKET;
+    closesocket(socket);
+}
+
 int Session::on_recieve()
 {
     int complete_byte_length = 0;
@@ -192,16 +225,35 @@ int Session::on_recieve()
             return -1;
         }
         
-        if(header.packet_size > remain_len) break;
+        if(header.packet_size > remain_len)
+        {
+            // 지금 버퍼로는 다 받을 수 없는 패킷이면 더 큰 크기의 버퍼로 바꾼다
+            if(header.packet_size > m_recv_buffer.GetBufferSize() && false == m_recv_buffer.Reserve(header.packet_size))
+            {
+                //TODO: LOG
+                do_disconnect();
+                return -1;
+            }
+            break;
+        }
 
         Packet* packet = xnew Packet;
         
-        packet->set_packet(m_recv_buffer.GetReadPos() + complete_byte_length, header.packet_size);
+        // 복사하지 않고 수신 버퍼 블록을 가리키는 슬라이스로 넘긴다
+        packet->set_packet(m_recv_buffer.GetBlock(), m_recv_buffer.GetReadPos() + complete_byte_length);
         packet->set_owner(this);
 
-        
-        NetworkCore* network_core = get_network_core();
-        if (nullptr == network_core)
+        // 압축된 패킷은 여기서 풀어 핸들러에는 원래 패킷으로 넘긴다 (이 패킷만 슬라이스 대신 풀어 쓴 버퍼를 가진다)
+        if (packet->is_compressed() && false == PacketCompressor::get_instance().decompress(*packet))
+        {
+            //TODO: LOG
+            do_disconnect();
+            xdelete packet;
+
+            return -1;
+        }
+
+        if (false == dispatch_packet(packet))
         {
             //TODO: LOG
             do_disconnect();
@@ -209,8 +261,6 @@ int Session::on_recieve()
             
             return 0;
         }
-    
-        network_core->push_packet(packet);
         
         complete_byte_length += header.packet_size;
     }
@@ -223,13 +273,31 @@ void Session::on_disconnected()
     
 }
 
+bool Session::dispatch_packet(Packet* packet)
+{
+    NetworkCore* network_core = get_network_core();
+    if (nullptr == network_core)
+        return false;
+
+    network_core->push_packet(packet);
+    return true;
+}
+
 void Session::execute_packet(Packet* packet)
 {
-    if (0 == m_handlers.count(packet->get_protocol()))
+    const unsigned short protocol = packet->get_protocol();
+    if (protocol < m_packet_handler_count && nullptr != m_packet_handlers[protocol])
+    {
+        m_packet_handlers[protocol](this, packet);
+        return;
+    }
+
+    auto handler = m_handlers.find(protocol);
+    if (m_handlers.end() == handler)
     {
         // TODO: 로그
         return;
     }
 
-    m_handlers[packet->get_protocol()](packet);
+    handler->second(packet);
 }
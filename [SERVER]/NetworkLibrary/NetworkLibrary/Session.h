@@ -6,6 +6,7 @@ class Session : public std::enable_shared_from_this<Session>
 public:
     Session() : m_multi_sender(this)
     {
+        m_connect_io.set_session(this);
         m_recv_io.set_session(this);
         m_disconnect_io.set_session(this);
     }
@@ -15,17 +16,25 @@ public:
     }
 
 public:
+    // 서버(ServerBase)가 받은 세션은 SessionRegistry가 id를 정하므로 ClientBase의 세션만 쓴다
     static int generate_session_id();
 public:
     virtual void init();
     virtual void init_handlers() abstract;
+    // 연결이 끝난 세션을 비운다 (SessionPool로 돌아가 다시 쓰일 때도 부른다)
     virtual void finalize();
+    // 끊기가 끝난 소켓을 닫는다
+    virtual void close_socket();
 public:
     int get_id() { return m_session_id; };
     void set_id(int id) { m_session_id = id; };
-    bool is_connected() { return m_is_connected; }
+    bool is_connected() { return m_is_connected.load(); }
 
     SOCKET get_socket() { return m_connecting_socket; }
+    // 소켓으로 I/O를 거는 동안 잡는다. 끊긴 세션이면 false (닫거나 풀에 돌려준 소켓은 다른 연결에 다시 쓰일 수 있다)
+    // complete_disconnect는 잡고 있는 스레드가 다 놓을 때까지 기다린 뒤 소켓을 닫는다
+    bool acquire_socket();
+    void release_socket() { m_socket_user_count.fetch_sub(1); }
 
     std::string& get_remote_ip(){ return m_remote_ip; }
     int get_remote_port(){ return m_remote_port; }
@@ -47,7 +56,11 @@ public:
     bool do_connect();
     bool do_recieve();
     bool do_send(std::shared_ptr<Packet> packet);
+    // 타입을 모르는 메시지는 GetTypeName으로 packet_number를 찾는다
     bool do_send(google::protobuf::Message& message);
+    // 생성된 메시지 타입으로 보내면 packet_number가 ProtocolOf<MessageT>로 컴파일 시간에 정해진다
+    template<typename MessageT, typename = std::enable_if_t<std::is_base_of_v<google::protobuf::Message, MessageT> && false == std::is_same_v<google::protobuf::Message, MessageT>>>
+    bool do_send(MessageT& message) { return do_send(Packet::create(message)); }
     bool do_disconnect();
 
     void complete_connect();
@@ -60,13 +73,26 @@ public:
     virtual void on_send(int data_size) abstract;
     virtual void on_disconnected() abstract;
     virtual void execute_packet(Packet* packet);
+    // 완성된 패킷을 처리할 스레드로 넘긴다. 넘길 곳이 없으면 false (패킷은 호출한 쪽이 지운다)
+    virtual bool dispatch_packet(Packet* packet);
+
+    // PacketDispatcher(PacketDispatcher.h)가 세션 클래스마다 만든 packet_number별 핸들러 표
+    // execute_packet은 표에서 먼저 찾고, 표에 없는 패킷만 m_handlers에서 찾는다
+    using PacketHandler = void(*)(Session*, Packet*);
+    void set_packet_handlers(const PacketHandler* handlers, int count)
+    {
+        m_packet_handlers = handlers;
+        m_packet_handler_count = count;
+    }
     
 
     RecvBuffer& get_recv_buffer() { return m_recv_buffer; }
     RecvIO& get_recv_io(){ return m_recv_io; }
+    MultiSender& get_multi_sender() { return m_multi_sender; }
 protected:
     int m_session_id;
-    bool m_is_connected;
+    std::atomic<bool> m_is_connected{ false }; // 워커 콜백도 읽는다
+    std::atomic<int> m_socket_user_count{ 0 };
     
     SOCKET m_connecting_socket;
     std::string m_remote_ip;
@@ -78,5 +104,7 @@ protected:
     RecvIO m_recv_io;
     DisconnectIO m_disconnect_io;
 
+    const PacketHandler* m_packet_handlers = nullptr;
+    int m_packet_handler_count = 0;
     std::map<unsigned short, std::function<void(Packet*)>> m_handlers;
 };
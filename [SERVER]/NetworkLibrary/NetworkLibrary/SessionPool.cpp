@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "SessionPool.h"
+
+SessionPool::~SessionPool()
+{
+    for (ClientSession* session : m_sessions)
+        xdelete session;
+    for (SOCKET socket : m_sockets)
+        closesocket(socket);
+}
+
+void SessionPool::init(std::function<ClientSession*()> session_factory)
+{
+    m_session_factory = std::move(session_factory);
+}
+
+std::shared_ptr<ClientSession> SessionPool::acquire()
+{
+    ClientSession* session = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (false == m_sessions.empty())
+        {
+            session = m_sessions.back();
+            m_sessions.pop_back();
+        }
+    }
+
+    if (nullptr != session)
+    {
+        m_reused_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        session = m_session_factory();
+        session->init();
+        m_created_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    session->set_session_pool(this);
+    // 제어 블록은 xmake_shared처럼 PacketBufferPool에서 빌린다
+    return std::shared_ptr<ClientSession>(session, [this](ClientSession* released) { release(released); }, PacketAllocator<ClientSession>());
+}
+
+void SessionPool::release(ClientSession* session)
+{
+    session->finalize();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (static_cast<int>(m_sessions.size()) < session_pool_max_count)
+        {
+            m_sessions.push_back(session);
+            return;
+        }
+    }
+
+    xdelete session;
+}
+
+void SessionPool::push_socket(SOCKET socket)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (static_cast<int>(m_sockets.size()) < session_pool_max_count)
+        {
+            m_sockets.push_back(socket);
+            return;
+        }
+    }
+
+    closesocket(socket);
+}
+
+SOCKET SessionPool::pop_socket()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_sockets.empty())
+        return INVALID_SOCKET;
+
+    SOCKET socket = m_sockets.back();
+    m_sockets.pop_back();
+    m_socket_reused_count.fetch_add(1, std::memory_order_relaxed);
+    return socket;
+}
+
+int SessionPool::get_pooled_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_sessions.size());
+}
+
+int SessionPool::get_pooled_socket_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_sockets.size());
+}
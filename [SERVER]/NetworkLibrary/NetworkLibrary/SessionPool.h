@@ -0,0 +1,45 @@
+#pragma once
+
+// 끊긴 ClientSession을 지우지 않고 모아 두었다가 다음 accept에 다시 쓰는 풀
+// 세션은 풀로 돌려보내는 deleter를 단 shared_ptr로 내주므로, 마지막 참조가 놓이면 finalize로 비운 뒤 풀로 돌아온다
+// 다시 쓰는 세션은 init(핸들러 맵 만들기)을 다시 부르지 않으므로, 연결마다 바뀌는 상태는 finalize에서 비워야 한다
+// 윈도우에서는 DisconnectEx(TF_REUSE_SOCKET)로 끊은 소켓도 모아 AcceptEx에 다시 쓴다 (리눅스는 accept4가 소켓을 만들어 주므로 모을 소켓이 없다)
+// 풀에 모아 두는 세션과 소켓은 각각 session_pool_max_count개까지 (config.h)
+class SessionPool
+{
+public:
+    SessionPool() = default;
+    ~SessionPool();
+    SessionPool(const SessionPool&) = delete;
+    SessionPool& operator=(const SessionPool&) = delete;
+
+public:
+    void init(std::function<class ClientSession*()> session_factory);
+    // 풀에 있으면 꺼내고, 없으면 factory로 만들어 init을 부른다
+    std::shared_ptr<ClientSession> acquire();
+
+    void push_socket(SOCKET socket);
+    // 모아 둔 소켓이 없으면 INVALID_SOCKET
+    SOCKET pop_socket();
+
+public:
+    int get_pooled_count() const;
+    int get_pooled_socket_count() const;
+    long long get_created_count() const { return m_created_count.load(std::memory_order_relaxed); }
+    long long get_reused_count() const { return m_reused_count.load(std::memory_order_relaxed); }
+    long long get_socket_reused_count() const { return m_socket_reused_count.load(std::memory_order_relaxed); }
+
+private:
+    void release(ClientSession* session);
+
+private:
+    std::function<ClientSession*()> m_session_factory;
+
+    mutable std::mutex m_mutex;
+    std::vector<ClientSession*> m_sessions;
+    std::vector<SOCKET> m_sockets;
+
+    std::atomic<long long> m_created_count{ 0 };
+    std::atomic<long long> m_reused_count{ 0 };
+    std::atomic<long long> m_socket_reused_count{ 0 };
+};
@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "SessionRegistry.h"
+
+SessionRegistry::~SessionRegistry()
+{
+    for (std::atomic<Slot*>& chunk : m_chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+int SessionRegistry::add(std::shared_ptr<ClientSession> session)
+{
+    Slot* slot = nullptr;
+    int session_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        int index = 0;
+        if (false == m_free_indices.empty())
+        {
+            index = m_free_indices.front();
+            m_free_indices.pop_front();
+        }
+        else
+        {
+            if (m_next_index >= MAX_SESSION_COUNT)
+                return 0;
+
+            index = m_next_index++;
+            std::atomic<Slot*>& chunk = m_chunks[index >> CHUNK_BITS];
+            if (nullptr == chunk.load(std::memory_order_relaxed))
+                chunk.store(new Slot[CHUNK_SIZE], std::memory_order_release);
+        }
+
+        slot = m_chunks[index >> CHUNK_BITS].load(std::memory_order_relaxed) + (index & (CHUNK_SIZE - 1));
+
+        // 세대는 1부터 돌아 id가 0이 되지 않는다
+        slot->generation = slot->generation % ((1 << GENERATION_BITS) - 1) + 1;
+        session_id = (slot->generation << INDEX_BITS) | index;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        slot->session = std::move(session);
+        slot->id.store(session_id, std::memory_order_release);
+    }
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    return session_id;
+}
+
+std::shared_ptr<ClientSession> SessionRegistry::remove(int session_id)
+{
+    Slot* slot = get_slot(session_id);
+    if (nullptr == slot)
+        return nullptr;
+
+    std::shared_ptr<ClientSession> session;
+    {
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        if (session_id != slot->id.load(std::memory_order_relaxed))
+            return nullptr;
+
+        slot->id.store(0, std::memory_order_release);
+        session = std::move(slot->session);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free_indices.push_back(get_index(session_id));
+    }
+    m_count.fetch_sub(1, std::memory_order_relaxed);
+    return session;
+}
+
+std::shared_ptr<ClientSession> SessionRegistry::find(int session_id)
+{
+    Slot* slot = get_slot(session_id);
+    if (nullptr == slot || session_id != slot->id.load(std::memory_order_acquire))
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    if (session_id != slot->id.load(std::memory_order_relaxed))
+        return nullptr;
+    return slot->session;
+}
+
+const SessionRegistry::Slot* SessionRegistry::get_slot(int session_id) const
+{
+    if (session_id <= 0)
+        return nullptr;
+
+    const int index = get_index(session_id);
+    const Slot* chunk = m_chunks[index >> CHUNK_BITS].load(std::memory_order_acquire);
+    if (nullptr == chunk)
+        return nullptr;
+    return chunk + (index & (CHUNK_SIZE - 1));
+}
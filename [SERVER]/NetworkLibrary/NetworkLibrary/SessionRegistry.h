@@ -0,0 +1,61 @@
+#pragma once
+#include <deque>
+
+// 서버 전체의 ClientSession을 칸 번호로 찾는 표 (generational slot map)
+// 세션 id = (세대 << INDEX_BITS) | 칸 번호. 칸을 다시 쓸 때마다 세대를 올리므로, 나간 세션의 id는 그 칸을 새 세션이 쓰더라도 다시 맞지 않는다
+// 칸은 CHUNK_SIZE개씩 묶어 한 번 만들면 옮기지 않으므로, 찾을 때는 표 전체 락 없이 칸의 id만 비교한다
+// 빈 칸은 비워진 순서대로 다시 써서 같은 칸의 세대가 빨리 돌지 않게 한다
+class SessionRegistry
+{
+public:
+    SessionRegistry() = default;
+    ~SessionRegistry();
+    SessionRegistry(const SessionRegistry&) = delete;
+    SessionRegistry& operator=(const SessionRegistry&) = delete;
+
+public:
+    // 빈 칸에 넣고 id를 돌려준다. 칸이 다 찼으면 0
+    int add(std::shared_ptr<class ClientSession> session);
+    // id가 가리키는 칸을 비운다. 그 뒤로 이 id는 is_alive가 false다. 이미 비었으면 nullptr
+    std::shared_ptr<ClientSession> remove(int session_id);
+
+    std::shared_ptr<ClientSession> find(int session_id);
+    // 락 없이 id가 아직 유효한지만 본다
+    bool is_alive(int session_id) const
+    {
+        const Slot* slot = get_slot(session_id);
+        return nullptr != slot && session_id == slot->id.load(std::memory_order_acquire);
+    }
+
+    int get_count() const { return m_count.load(std::memory_order_relaxed); }
+
+public:
+    static constexpr int INDEX_BITS = 18;
+    static constexpr int GENERATION_BITS = 31 - INDEX_BITS; // id가 양수 int에 들어가도록
+    static constexpr int MAX_SESSION_COUNT = 1 << INDEX_BITS;
+    static int get_index(int session_id) { return session_id & (MAX_SESSION_COUNT - 1); }
+
+private:
+    struct Slot
+    {
+        std::atomic<int> id{ 0 }; // 이 칸을 쓰는 세션의 id (비었으면 0)
+        std::mutex mutex;         // session을 바꾸거나 복사할 때만 잡는다
+        std::shared_ptr<ClientSession> session;
+        int generation = 0;       // m_mutex를 잡고 바꾼다
+    };
+
+    const Slot* get_slot(int session_id) const;
+    Slot* get_slot(int session_id) { return const_cast<Slot*>(static_cast<const SessionRegistry*>(this)->get_slot(session_id)); }
+
+private:
+    static constexpr int CHUNK_BITS = 12;
+    static constexpr int CHUNK_SIZE = 1 << CHUNK_BITS;
+    static constexpr int MAX_CHUNK_COUNT = MAX_SESSION_COUNT / CHUNK_SIZE;
+
+    std::atomic<Slot*> m_chunks[MAX_CHUNK_COUNT] = {};
+
+    std::mutex m_mutex; // add / remove
+    std::deque<int> m_free_indices;
+    int m_next_index = 0;
+    std::atomic<int> m_count{ 0 };
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+
+// 한 스레드만 넣고 한 스레드만 꺼내는 락 없는 큐
+// CHUNK_SIZE개 단위의 청크를 이어 붙여 크기 제한이 없고, 넣는 쪽이 청크를 할당하고 꺼내는 쪽이 다 읽은 청크를 해제한다
+// 넣는 쪽과 꺼내는 쪽은 청크의 count(release / acquire)로만 만나므로 원소마다 RMW 연산이 없다
+template<typename T, int CHUNK_SIZE = 256>
+class SpscQueue
+{
+public:
+    SpscQueue()
+    {
+        m_write_chunk = xnew Chunk;
+        m_read_chunk = m_write_chunk;
+    }
+    ~SpscQueue()
+    {
+        while (nullptr != m_read_chunk)
+        {
+            Chunk* next = m_read_chunk->next.load(std::memory_order_relaxed);
+            xdelete m_read_chunk;
+            m_read_chunk = next;
+        }
+    }
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+public:
+    // 넣는 스레드 전용
+    void push(T&& value)
+    {
+        int count = m_write_chunk->count.load(std::memory_order_relaxed);
+        if (CHUNK_SIZE == count)
+        {
+            Chunk* chunk = xnew Chunk;
+            m_write_chunk->next.store(chunk, std::memory_order_release);
+            m_write_chunk = chunk;
+            count = 0;
+        }
+
+        m_write_chunk->items[count] = std::move(value);
+        m_write_chunk->count.store(count + 1, std::memory_order_release);
+    }
+
+    // 꺼내는 스레드 전용. 비어있으면 nullptr
+    T* front()
+    {
+        if (m_read_idx == CHUNK_SIZE)
+        {
+            Chunk* next = m_read_chunk->next.load(std::memory_order_acquire);
+            if (nullptr == next)
+                return nullptr;
+
+            xdelete m_read_chunk;
+            m_read_chunk = next;
+            m_read_idx = 0;
+        }
+
+        if (m_read_idx == m_read_chunk->count.load(std::memory_order_acquire))
+            return nullptr;
+
+        return &m_read_chunk->items[m_read_idx];
+    }
+
+    // 꺼내는 스레드 전용. front()가 돌려준 원소를 버린다
+    void pop()
+    {
+        m_read_chunk->items[m_read_idx] = T();
+        ++m_read_idx;
+    }
+
+private:
+    struct Chunk
+    {
+        T items[CHUNK_SIZE];
+        std::atomic<int> count{ 0 };
+        std::atomic<Chunk*> next{ nullptr };
+    };
+
+    alignas(64) Chunk* m_write_chunk;
+    alignas(64) Chunk* m_read_chunk;
+    int m_read_idx = 0;
+};
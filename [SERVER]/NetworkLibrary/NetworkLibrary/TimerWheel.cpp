@@ -0,0 +1,199 @@
+#include "pch.h"
+#include "TimerWheel.h"
+
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+
+namespace
+{
+    int count_trailing_zeros(unsigned long long bits)
+    {
+#ifdef _WIN32
+        unsigned long index = 0;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+}
+
+TimerWheel::TimerWheel(std::chrono::steady_clock::time_point origin)
+    : m_origin(origin), m_current_tick(0), m_level0_bitmap{}, m_level_bitmaps{}, m_count(0)
+{
+}
+
+void TimerWheel::add(iTask* task)
+{
+    ++m_count;
+    place(task, std::max(to_tick(task->execute_time), m_current_tick + 1));
+}
+
+void TimerWheel::advance(std::chrono::steady_clock::time_point now, std::deque<iTask*>& expired)
+{
+    const long long target_tick = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_origin).count() / std::chrono::nanoseconds(TICK).count();
+
+    while (m_current_tick < target_tick)
+    {
+        const long long tick = get_next_tick();
+        if (tick > target_tick)
+        {
+            m_current_tick = target_tick;
+            break;
+        }
+        m_current_tick = tick;
+
+        const int index = static_cast<int>(tick & (LEVEL0_SIZE - 1));
+        if (0 == index)
+        {
+            // 아랫단계가 한 바퀴를 다 돌았을 때만 그 윗단계도 내린다
+            for (int level = 0; level < UPPER_LEVEL_COUNT; ++level)
+            {
+                const int level_index = static_cast<int>((tick >> (LEVEL0_BITS + LEVEL_BITS * level)) & (LEVEL_SIZE - 1));
+                cascade(level, level_index);
+                if (0 != level_index)
+                    break;
+            }
+        }
+
+        Slot& slot = m_level0[index];
+        for (iTask* task = slot.head; nullptr != task;)
+        {
+            iTask* next = task->timer_next;
+            task->timer_next = nullptr;
+            expired.push_back(task);
+            --m_count;
+            task = next;
+        }
+        slot = Slot();
+        m_level0_bitmap[index / 64] &= ~(1ULL << (index % 64));
+    }
+}
+
+bool TimerWheel::get_next_deadline(std::chrono::steady_clock::time_point& deadline) const
+{
+    const long long tick = get_next_tick();
+    if (LLONG_MAX == tick)
+        return false;
+
+    deadline = m_origin + TICK * tick;
+    return true;
+}
+
+long long TimerWheel::to_tick(std::chrono::steady_clock::time_point time) const
+{
+    const long long elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_origin).count();
+    if (elapsed_ns <= 0)
+        return 0;
+
+    const long long tick_ns = std::chrono::nanoseconds(TICK).count();
+    return (elapsed_ns + tick_ns - 1) / tick_ns;
+}
+
+long long TimerWheel::get_next_tick() const
+{
+    long long next_tick = LLONG_MAX;
+
+    const int slot = find_level0_slot(static_cast<int>((m_current_tick + 1) & (LEVEL0_SIZE - 1)));
+    if (-1 != slot)
+    {
+        const long long distance = (slot - m_current_tick) & (LEVEL0_SIZE - 1);
+        next_tick = m_current_tick + (0 == distance ? LEVEL0_SIZE : distance);
+    }
+
+    // 윗단계 칸은 그 칸이 맡은 구간이 시작되는 tick에 내린다 (지금 칸은 이미 내렸으므로 한 바퀴 뒤)
+    for (int level = 0; level < UPPER_LEVEL_COUNT; ++level)
+    {
+        if (0 == m_level_bitmaps[level])
+            continue;
+
+        const int shift = LEVEL0_BITS + LEVEL_BITS * level;
+        const long long block = m_current_tick >> shift;
+        const int current_index = static_cast<int>(block & (LEVEL_SIZE - 1));
+        const int index = find_slot(m_level_bitmaps[level], (current_index + 1) & (LEVEL_SIZE - 1));
+        const long long distance = (index - current_index) & (LEVEL_SIZE - 1);
+        next_tick = std::min(next_tick, (block + (0 == distance ? LEVEL_SIZE : distance)) << shift);
+    }
+
+    return next_tick;
+}
+
+void TimerWheel::place(iTask* task, long long expire_tick)
+{
+    long long delta = expire_tick - m_current_tick;
+    if (delta < LEVEL0_SIZE)
+    {
+        const int index = static_cast<int>(expire_tick & (LEVEL0_SIZE - 1));
+        append(m_level0[index], task);
+        m_level0_bitmap[index / 64] |= 1ULL << (index % 64);
+        return;
+    }
+
+    if (delta >= MAX_DELTA_TICKS)
+    {
+        delta = MAX_DELTA_TICKS - 1;
+        expire_tick = m_current_tick + delta;
+    }
+
+    int level = 0;
+    while (delta >= (1LL << (LEVEL0_BITS + LEVEL_BITS * (level + 1))))
+        ++level;
+
+    const int index = static_cast<int>((expire_tick >> (LEVEL0_BITS + LEVEL_BITS * level)) & (LEVEL_SIZE - 1));
+    append(m_levels[level][index], task);
+    m_level_bitmaps[level] |= 1ULL << index;
+}
+
+void TimerWheel::cascade(int level, int index)
+{
+    Slot slot = m_levels[level][index];
+    m_levels[level][index] = Slot();
+    m_level_bitmaps[level] &= ~(1ULL << index);
+
+    for (iTask* task = slot.head; nullptr != task;)
+    {
+        iTask* next = task->timer_next;
+        task->timer_next = nullptr;
+        place(task, std::max(to_tick(task->execute_time), m_current_tick));
+        task = next;
+    }
+}
+
+int TimerWheel::find_level0_slot(int from) const
+{
+    // from부터 한 바퀴 돌며 처음 만나는 비어있지 않은 칸
+    const int from_word = from / 64;
+    const int from_bit = from % 64;
+    for (int i = 0; i <= LEVEL0_SIZE / 64; ++i)
+    {
+        const int word = (from_word + i) % (LEVEL0_SIZE / 64);
+        unsigned long long bits = m_level0_bitmap[word];
+        if (0 == i)
+            bits &= ~0ULL << from_bit;
+        else if (LEVEL0_SIZE / 64 == i)
+            bits &= (1ULL << from_bit) - 1;
+
+        if (0 != bits)
+            return word * 64 + count_trailing_zeros(bits);
+    }
+    return -1;
+}
+
+int TimerWheel::find_slot(unsigned long long bitmap, int from)
+{
+    const unsigned long long upper = bitmap & (~0ULL << from);
+    if (0 != upper)
+        return count_trailing_zeros(upper);
+    return count_trailing_zeros(bitmap);
+}
+
+void TimerWheel::append(Slot& slot, iTask* task)
+{
+    task->timer_next = nullptr;
+    if (nullptr == slot.tail)
+        slot.head = task;
+    else
+        slot.tail->timer_next = task;
+    slot.tail = task;
+}
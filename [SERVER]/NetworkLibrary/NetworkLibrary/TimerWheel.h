@@ -0,0 +1,62 @@
+#pragma once
+#include <deque>
+
+// 섹션 스레드 전용 계층형 타이밍 휠 (리눅스 커널 타이머와 같은 구조)
+// 0단계는 TICK 단위 256칸, 1~3단계는 64칸씩이며 윗단계 한 칸은 아랫단계 한 바퀴 길이를 맡는다
+// 넣기는 O(1)이고, 윗단계 칸은 그 칸이 맡은 구간이 시작될 때 꺼내 실행 시각에 맞는 아랫단계 칸으로 다시 나눈다 (cascade)
+// 단계마다 비어있지 않은 칸을 비트맵으로 들고 있어, 빈 칸과 내릴 게 없는 구간 경계는 tick 단위로 돌지 않고 건너뛴다
+// task는 실행 시각을 TICK 단위로 올림한 칸에 들어가므로 일찍 실행되지 않고, 늦어도 TICK 미만이다
+// 3단계 범위(TICK * 2^26, 약 11분)를 넘는 task는 3단계 마지막 칸에 두었다가 내려올 때 다시 넣는다
+class TimerWheel
+{
+public:
+    static constexpr std::chrono::microseconds TICK{ 10 };
+
+public:
+    explicit TimerWheel(std::chrono::steady_clock::time_point origin);
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+public:
+    // task->execute_time에 실행되도록 넣는다. 이미 지난 시각이면 다음 칸에 들어간다
+    void add(iTask* task);
+    // now까지 실행 시각이 된 task를 실행 시각 칸 순서대로 expired 뒤에 붙인다
+    void advance(std::chrono::steady_clock::time_point now, std::deque<iTask*>& expired);
+    // 다음 advance에서 꺼낼 task가 생길 수 있는 가장 이른 시각 (윗단계를 내릴 시각 포함). 비었으면 false
+    bool get_next_deadline(std::chrono::steady_clock::time_point& deadline) const;
+    size_t size() const { return m_count; }
+
+private:
+    static constexpr int LEVEL0_BITS = 8;
+    static constexpr int LEVEL_BITS = 6;
+    static constexpr int UPPER_LEVEL_COUNT = 3;
+    static constexpr int LEVEL0_SIZE = 1 << LEVEL0_BITS;
+    static constexpr int LEVEL_SIZE = 1 << LEVEL_BITS;
+    static constexpr long long MAX_DELTA_TICKS = 1LL << (LEVEL0_BITS + LEVEL_BITS * UPPER_LEVEL_COUNT);
+
+    struct Slot
+    {
+        iTask* head = nullptr;
+        iTask* tail = nullptr;
+    };
+
+    long long to_tick(std::chrono::steady_clock::time_point time) const;
+    // 0단계 칸을 꺼내거나 윗단계 칸을 내려야 하는 가장 가까운 tick (m_current_tick 이후). 비었으면 LLONG_MAX
+    long long get_next_tick() const;
+    void place(iTask* task, long long expire_tick);
+    void cascade(int level, int index);
+    int find_level0_slot(int from) const;
+    static int find_slot(unsigned long long bitmap, int from);
+    static void append(Slot& slot, iTask* task);
+
+private:
+    std::chrono::steady_clock::time_point m_origin;
+    long long m_current_tick; // 이 tick의 0단계 칸까지는 이미 꺼냈다
+
+    Slot m_level0[LEVEL0_SIZE];
+    unsigned long long m_level0_bitmap[LEVEL0_SIZE / 64]; // 비어있지 않은 0단계 칸
+    Slot m_levels[UPPER_LEVEL_COUNT][LEVEL_SIZE];
+    unsigned long long m_level_bitmaps[UPPER_LEVEL_COUNT];
+
+    size_t m_count;
+};
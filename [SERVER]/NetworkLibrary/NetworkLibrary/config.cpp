@@ -6,4 +6,70 @@ bool performance_check_mode = false;
 
 int server_fps_check_interval = 5;
 
-int client_rtt_check_interval = 10;
\ No newline at end of file
+int client_rtt_check_interval = 10;
+
+bool send_coalescing_mode = false;
+
+int send_coalescing_threshold = 512;
+
+int send_coalescing_buffer_size = 16 * 1024;
+
+SendFlushPolicy send_flush_policy = SendFlushPolicy::IMMEDIATE;
+
+int send_flush_delay_us = 500;
+
+bool deferred_broadcast_mode = true;
+
+int section_tick_rate = 0;
+
+int section_tick_budget_us = 0;
+
+TickCatchUpPolicy section_tick_catch_up_policy = TickCatchUpPolicy::CATCH_UP;
+
+int section_max_catch_up_ticks = 5;
+
+bool hard_task_auto_scaling_mode = true;
+
+int hard_task_min_threads = 1;
+
+int hard_task_max_threads = 16;
+
+int hard_task_grow_wait_us = 5000;
+
+double hard_task_grow_blocked_ratio = 0.8;
+
+int hard_task_shrink_idle_ms = 10000;
+
+int hard_task_scale_interval_ms = 20;
+
+SectionSelectPolicy section_select_policy = SectionSelectPolicy::LEAST_SESSIONS;
+
+int section_load_window_ms = 100;
+
+int listen_backlog = SOMAXCONN;
+
+int accept_post_count = 16;
+
+int reuse_port_listener_count = 0;
+
+int session_pool_max_count = 4096;
+
+bool message_arena_mode = true;
+
+int message_arena_initial_block_size = 256 * 1024;
+
+bool packet_compression_mode = true;
+
+int packet_compression_level = 1;
+
+int packet_compression_thread_count = 2;
+
+int packet_compression_inline_queue = 64;
+
+int send_queue_max_bytes = 4 * 1024 * 1024;
+
+int send_queue_max_packets = 16384;
+
+int send_queue_high_watermark_bytes = 1024 * 1024;
+
+int slow_consumer_disconnect_ms = 10000;
\ No newline at end of file
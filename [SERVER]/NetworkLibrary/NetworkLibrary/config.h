@@ -1,4 +1,91 @@
 ﻿#pragma once
 extern bool performance_check_mode;
 extern int server_fps_check_interval;
-extern int client_rtt_check_interval;
\ No newline at end of file
+extern int client_rtt_check_interval;
+
+// 보낼 패킷을 언제 소켓으로 내보낼지
+// IMMEDIATE: do_send 즉시, END_OF_BATCH: 섹션 스레드가 처리할 task를 다 비운 뒤, DELAYED: 첫 패킷부터 send_flush_delay_us 뒤
+// 섹션 스레드가 아닌 곳(하드 task, DB 콜백 등)에서 보낸 패킷은 정책과 상관없이 즉시 보낸다
+enum class SendFlushPolicy
+{
+    IMMEDIATE,
+    END_OF_BATCH,
+    DELAYED,
+};
+
+extern bool send_coalescing_mode;        // 작은 패킷을 연속된 버퍼 하나로 복사해 보낸다
+extern int send_coalescing_threshold;    // 이 크기(바이트) 이하의 패킷만 복사한다. 더 크면 패킷 버퍼를 그대로 scatter/gather
+extern int send_coalescing_buffer_size;  // send 한 번에 복사해 담는 최대 바이트
+extern SendFlushPolicy send_flush_policy;
+extern int send_flush_delay_us;
+extern bool deferred_broadcast_mode;     // 섹션 스레드의 broadcast는 큐에만 넣고 task 묶음이 끝날 때 세션마다 한 번 send 한다
+
+// 섹션 tick이 예정 시각보다 한 주기 넘게 밀렸을 때
+// CATCH_UP: 밀린 tick을 고정 dt로 연달아 돌린다 (section_max_catch_up_ticks개까지, 나머지는 버린다)
+// SKIP: 밀린 tick은 버리고, 지난 tick부터 흐른 시간 전체를 dt로 한 번만 돌린다
+enum class TickCatchUpPolicy
+{
+    CATCH_UP,
+    SKIP,
+};
+
+extern int section_tick_rate;            // 0이면 일이 들어올 때만 도는 기존 방식. 0보다 크면 섹션이 초당 이 횟수만큼 tick을 돈다
+extern int section_tick_budget_us;       // tick 하나에 쓸 수 있는 시간. 0이면 tick 주기 전체
+extern TickCatchUpPolicy section_tick_catch_up_policy;
+extern int section_max_catch_up_ticks;
+
+// 하드 task 워커 수 자동 조절. ServerBase::init의 hard_task_thread_count개로 시작해 [hard_task_min_threads, hard_task_max_threads] 안에서 늘고 준다
+// (hard_task_thread_count가 0이면 워커를 띄우지 않는다)
+// 큐에서 hard_task_grow_wait_us보다 오래 기다린 task가 있거나, 기다리는 task가 있는데 워커 중 hard_task_grow_blocked_ratio 이상이 막혀(BlockingScope) 있으면 하나씩 늘리고,
+// hard_task_shrink_idle_ms 동안 일이 없던 워커는 스스로 내려간다
+extern bool hard_task_auto_scaling_mode;
+extern int hard_task_min_threads;
+extern int hard_task_max_threads;
+extern int hard_task_grow_wait_us;
+extern double hard_task_grow_blocked_ratio;
+extern int hard_task_shrink_idle_ms;
+extern int hard_task_scale_interval_ms;  // 늘릴지 판단하는 주기
+// 새 연결이 처음 들어갈 섹션 고르기 (ServerBase::select_first_section 기본 구현)
+// FIRST: 항상 첫 섹션, LEAST_SESSIONS: 세션이 가장 적은 섹션, LEAST_QUEUED: 아직 처리 못 한 패킷과 task가 가장 적은 섹션
+// POWER_OF_TWO_LOAD: 무작위로 고른 두 섹션 중 최근 부하(섹션 스레드가 일한 시간 비율)가 낮은 섹션
+// CONSISTENT_HASH: 접속 주소를 해싱해 섹션 구성이 같은 동안 항상 같은 섹션으로 (계정으로 고를 때는 ServerBase::select_section_by_key)
+// 같은 값이면 세션이 적은 섹션을 고른다
+enum class SectionSelectPolicy
+{
+    FIRST,
+    LEAST_SESSIONS,
+    LEAST_QUEUED,
+    POWER_OF_TWO_LOAD,
+    CONSISTENT_HASH,
+};
+
+extern SectionSelectPolicy section_select_policy;
+extern int section_load_window_ms;       // 섹션 부하를 이 구간마다 다시 잰다
+
+// 서버 리슨 (ServerBase::open)
+// 리눅스에서 reuse_port_listener_count가 1보다 크면 같은 포트에 SO_REUSEPORT 리슨 소켓을 그 수만큼 열어 커널이 새 연결을 나눠 넣게 한다
+// 리슨 소켓마다 락이 따로라 여러 I/O 스레드가 동시에 accept한다. 0이면 I/O 스레드 수만큼 (윈도우는 항상 하나)
+extern int listen_backlog;               // 리슨 소켓마다 커널이 쌓아둘 수 있는 완료된 연결 수 (커널 상한 somaxconn을 넘으면 잘린다)
+extern int accept_post_count;            // 리슨 소켓마다 미리 걸어둘 AcceptIO 수 (open의 accept_count가 0일 때)
+extern int reuse_port_listener_count;
+extern int session_pool_max_count;       // 끊긴 세션(윈도우는 소켓도)을 지우지 않고 다시 쓰려고 모아 둘 최대 수. 0이면 모으지 않는다
+
+// 섹션 스레드가 받은 메시지를 섹션의 MessageArena에 디코딩한다 (task 묶음이나 tick이 끝나면 비운다)
+extern bool message_arena_mode;
+extern int message_arena_initial_block_size; // 섹션마다 들고 있다가 비운 뒤에도 다시 쓰는 첫 블록 (바이트)
+
+// 패킷 압축 (PacketCompressor). 어떤 packet_number를 몇 바이트부터 압축할지는 PacketCompressor::enable로 정한다
+// 보낼 패킷은 압축 워커에서 압축하고, 받은 압축 패킷은 I/O 스레드가 디스패치 전에 푼다
+// 압축 워커는 하드 task 워커(DB 호출로 막히고 수가 제한된다)와 따로 두어, 압축할 패킷이 DB task 뒤에서 기다리지 않게 한다
+extern bool packet_compression_mode;
+extern int packet_compression_level;     // zlib 압축 레벨 (1: 빠름 ~ 9: 작음)
+extern int packet_compression_thread_count; // 압축 워커 수 (0이면 보내는 스레드에서 바로 압축한다)
+extern int packet_compression_inline_queue; // 압축 워커에 이만큼 밀려 있으면 기다리지 않고 보내는 스레드에서 바로 압축한다
+
+// 세션 send 큐 제한 (MultiSender). 넣은 뒤 아직 다 보내지 못한 패킷(보내는 중인 것 포함)의 압축 전 바이트와 수
+// 최대를 넘는 패킷은 버릴 수 있는 패킷(SendPolicy)이면 버리고, 아니면 느린 클라이언트로 보고 세션을 끊는다
+// high watermark를 넘은 채로 보낼 때는 CONFLATE 패킷을 합치고 오래된 DROPPABLE 패킷부터 버린다
+extern int send_queue_max_bytes;
+extern int send_queue_max_packets;
+extern int send_queue_high_watermark_bytes;
+extern int slow_consumer_disconnect_ms;  // high watermark를 이만큼 계속 넘어 있으면 끊는다 (0이면 시간으로는 끊지 않는다)
\ No newline at end of file
@@ -1,10 +1,49 @@
 ﻿#pragma once
 
-struct iTask
+// 하드 task 풀에서 먼저 꺼낼 순서. 앞의 것이 항상 먼저 실행된다
+// INTERACTIVE: 유저가 응답을 기다리는 일 (로그인 등), NORMAL: 기본, BACKGROUND: 늦어도 되는 일 (저장 등)
+enum class HardTaskPriority
+{
+    INTERACTIVE,
+    NORMAL,
+    BACKGROUND,
+};
+constexpr int HARD_TASK_PRIORITY_COUNT = 3;
+
+// 섹션의 task 큐(MpscQueue)와 타이밍 휠에 할당 없이 들어가도록 노드를 직접 들고 있다
+struct iTask : public MpscNode
 {
     bool is_repeat = false; // 패킷 처리 task는 무조건 false => 실행 후 패킷을 delete함.
     std::chrono::steady_clock::time_point execute_time;
-    long long delay_time = 0;
+    long long delay_time = 0; // ms. 반복 task는 실행이 끝난 뒤 이만큼 지나 다시 실행한다
     std::function<void()> func;
     std::function<void()> post_processing_func;
+    HardTaskPriority hard_task_priority = HardTaskPriority::NORMAL; // 하드 task 풀에서만 쓴다
+    int session_id = 0; // 섹션 task가 세션 것이면 그 id. 실행할 때 세션이 다른 섹션으로 옮겨가 있으면 그 섹션으로 넘긴다
+
+    // NetworkSection::push_timer로 넣은 task만 가진다. true가 되면 실행하지 않고 지운다
+    std::shared_ptr<std::atomic<bool>> cancel_flag;
+    bool is_cancelled() const { return nullptr != cancel_flag && cancel_flag->load(std::memory_order_acquire); }
+
+    iTask* timer_next = nullptr; // TimerWheel 칸 안의 다음 task (섹션 스레드만 접근)
+};
+
+// push_timer가 돌려주는 취소 핸들. 아무 스레드에서나 cancel할 수 있고, 이미 실행됐거나 취소된 task에 불러도 된다
+// 반복 task는 cancel한 뒤로 다시 실행되지 않는다
+class TimerHandle
+{
+public:
+    TimerHandle() = default;
+    explicit TimerHandle(std::shared_ptr<std::atomic<bool>> cancel_flag) : m_cancel_flag(std::move(cancel_flag)) {}
+
+public:
+    bool is_valid() const { return nullptr != m_cancel_flag; }
+    void cancel()
+    {
+        if (nullptr != m_cancel_flag)
+            m_cancel_flag->store(true, std::memory_order_release);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancel_flag;
 };
\ No newline at end of file